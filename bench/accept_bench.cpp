@@ -0,0 +1,144 @@
+// Бенчмарк приёма соединений: один слушающий сокет и один цикл обработки
+// (прежняя схема сервера) против N сокетов с SO_REUSEPORT и цикла на каждый.
+// Цикл делает то же, что сервер на каждое соединение без обработки запроса:
+// accept, read, send готового ответа, close. Клиенты в отдельных потоках
+// открывают новое соединение на каждый запрос (Connection: close) и читают
+// ответ до EOF. Результат - соединений в секунду.
+//
+// Запуск: make microbench или build/accept_bench [секунд] [клиентов] [циклов]
+// PIN_EVENT_LOOPS=1 закрепляет циклы за процессорами.
+
+#include "listeners.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const char REQUEST[] = "GET / HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+const char RESPONSE[] = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 2\r\nConnection: close\r\n\r\nok";
+
+void serveLoop(int listener, int stopFd, size_t loopIndex, bool pin) {
+    if (pin) pinCurrentThread(loopIndex % cpuCount());
+    char buffer[8192];
+    while (true) {
+        pollfd fds[2] = {{listener, POLLIN, 0}, {stopFd, POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) continue;
+        if (fds[1].revents & (POLLIN | POLLHUP)) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) continue;
+        if (read(client, buffer, sizeof(buffer)) > 0) {
+            send(client, RESPONSE, sizeof(RESPONSE) - 1, MSG_NOSIGNAL);
+        }
+        close(client);
+    }
+}
+
+void clientLoop(int port, std::chrono::steady_clock::time_point deadline, std::atomic<uint64_t>& completed,
+                std::atomic<uint64_t>& failed) {
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    char buffer[512];
+    uint64_t done = 0;
+    uint64_t errors = 0;
+    while (std::chrono::steady_clock::now() < deadline) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) < 0 ||
+            send(fd, REQUEST, sizeof(REQUEST) - 1, MSG_NOSIGNAL) < 0) {
+            errors++;
+            if (fd >= 0) close(fd);
+            continue;
+        }
+        ssize_t total = 0;
+        ssize_t count;
+        while ((count = read(fd, buffer, sizeof(buffer))) > 0) total += count;
+        close(fd);
+        if (total == static_cast<ssize_t>(sizeof(RESPONSE) - 1)) {
+            done++;
+        } else {
+            errors++;
+        }
+    }
+    completed += done;
+    failed += errors;
+}
+
+// Соединений в секунду при loops слушающих сокетах и циклах
+double run(size_t loops, size_t clients, int seconds, bool pin) {
+    std::vector<int> listeners;
+    listeners.push_back(openListener(0, loops > 1, 1024));
+    if (listeners[0] < 0) return -1;
+    int port = listenerPort(listeners[0]);
+    while (listeners.size() < loops) {
+        int listener = openListener(port, true, 1024);
+        if (listener < 0) return -1;
+        listeners.push_back(listener);
+    }
+    int stopPipe[2];
+    if (pipe(stopPipe) < 0) return -1;
+
+    std::vector<std::thread> servers;
+    for (size_t i = 0; i < loops; i++) {
+        servers.emplace_back(serveLoop, listeners[i], stopPipe[0], i, pin);
+    }
+
+    std::atomic<uint64_t> completed{0};
+    std::atomic<uint64_t> failed{0};
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::seconds(seconds);
+    std::vector<std::thread> clientThreads;
+    for (size_t i = 0; i < clients; i++) {
+        clientThreads.emplace_back(clientLoop, port, deadline, std::ref(completed), std::ref(failed));
+    }
+    for (auto& thread : clientThreads) thread.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    close(stopPipe[1]);
+    for (auto& thread : servers) thread.join();
+    close(stopPipe[0]);
+    for (int listener : listeners) close(listener);
+
+    if (failed > 0) {
+        std::cerr << "Ошибок соединения: " << failed.load() << std::endl;
+    }
+    return completed / elapsed;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int seconds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 2;
+    size_t loops = argc > 3 ? std::max(1, std::atoi(argv[3])) : cpuCount();
+    size_t clients = argc > 2 ? std::max(1, std::atoi(argv[2])) : loops * 2;
+    const char* pinEnv = std::getenv("PIN_EVENT_LOOPS");
+    bool pin = pinEnv && std::string(pinEnv) == "1";
+
+    std::cout << "Приём соединений: " << clients << " клиентов, " << seconds << " с"
+              << (pin ? ", циклы закреплены за процессорами" : "") << std::endl;
+    double single = run(1, clients, seconds, pin);
+    double reusePort = run(loops, clients, seconds, pin);
+    if (single <= 0 || reusePort <= 0) {
+        std::cerr << "Не удалось открыть слушающие сокеты" << std::endl;
+        return 1;
+    }
+    std::cout << std::fixed << std::setprecision(0)
+              << "один сокет, 1 цикл:             " << std::setw(9) << single << " соед/с" << std::endl
+              << "SO_REUSEPORT, " << std::setw(2) << loops << " циклов:       " << std::setw(9) << reusePort
+              << " соед/с (" << std::setprecision(2) << reusePort / single << "x)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,180 @@
+// Микробенчмарк страницы каталога: прежний способ (указатели на Integrator,
+// сортировка всей выборки со сравнением строк и поиском рейтинга в std::map в
+// компараторе) против готовых порядков CatalogColumns, из которых берётся только
+// страница. Перед замерами порядок строк сверяется. Отдельно - перестройка
+// порядка по рейтингу после новой оценки: полная и с перестановкой строки.
+//
+// Запуск: make microbench или build/catalog_columns_bench [интеграторов]
+
+#include "catalog_columns.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+volatile size_t sink = 0;
+
+double measure(const std::function<void()>& body) {
+    using clock = std::chrono::steady_clock;
+    size_t iterations = 1;
+    for (;;) {
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; i++) body();
+        double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        if (elapsed > 2e8 || iterations > (1u << 20)) {
+            return elapsed / iterations;
+        }
+        iterations *= elapsed < 1e7 ? 8 : 2;
+    }
+}
+
+std::vector<Integrator> makeIntegrators(size_t count) {
+    const char* cities[] = {"Москва", "Санкт-Петербург", "Казань", "Новосибирск", "Екатеринбург",
+                            "Нижний Новгород", "Самара", "Омск", "Ростов-на-Дону", "Уфа"};
+    std::mt19937 random(42);
+    std::vector<Integrator> result(count);
+    for (size_t i = 0; i < count; i++) {
+        Integrator& integrator = result[i];
+        integrator.id = static_cast<int>(i + 1);
+        integrator.name = "ООО «Интегратор безопасности №" + std::to_string(random() % (count * 4)) + "»";
+        integrator.city = cities[random() % 10];
+        integrator.description = "Комплексная защита информации";
+        integrator.licenses.push_back({"Л024-00107-00/" + std::to_string(i), "ФСТЭК России"});
+    }
+    return result;
+}
+
+double averageOf(const std::map<int, RatingStats>& ratingStats, int id) {
+    auto it = ratingStats.find(id);
+    return it == ratingStats.end() ? 0.0 : it->second.average;
+}
+
+// Сортировка и фильтр по городу до перехода на колонки
+std::vector<const Integrator*> legacyListing(const std::vector<Integrator>& integrators, const std::string& filterCity,
+                                             const std::string& sortOption, std::map<int, RatingStats>& ratingStats) {
+    std::vector<const Integrator*> filtered;
+    for (const auto& itg : integrators) {
+        if (!filterCity.empty() && itg.city != filterCity) continue;
+        filtered.push_back(&itg);
+    }
+    std::sort(filtered.begin(), filtered.end(), [&](const Integrator* pa, const Integrator* pb) {
+        const Integrator& a = *pa;
+        const Integrator& b = *pb;
+        if (sortOption == "name_desc") return a.name > b.name;
+        if (sortOption == "city_asc") return a.city != b.city ? a.city < b.city : a.name < b.name;
+        if (sortOption == "rating_desc") {
+            double ra = ratingStats.count(a.id) ? ratingStats[a.id].average : 0.0;
+            double rb = ratingStats.count(b.id) ? ratingStats[b.id].average : 0.0;
+            if (ra == rb) return a.name < b.name;
+            return ra > rb;
+        }
+        return a.name < b.name;
+    });
+    return filtered;
+}
+
+std::vector<uint32_t> columnListing(const CatalogColumns& columns, const std::string& filterCity,
+                                    const CatalogOrdering& ordering, size_t count) {
+    std::vector<uint32_t> rows(columns.size());
+    for (uint32_t row = 0; row < rows.size(); row++) rows[row] = row;
+    if (!filterCity.empty()) columns.filterByCity(rows, columns.cityId(filterCity));
+    std::vector<uint32_t> page;
+    selectOrderedPage(ordering, rows, 0, count, page);
+    return page;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20000;
+    std::vector<Integrator> integrators = makeIntegrators(count);
+    std::map<int, RatingStats> ratingStats;
+    std::mt19937 random(7);
+    for (const auto& integrator : integrators) {
+        if (random() % 3 == 0) continue;
+        int votes = 1 + random() % 20;
+        ratingStats[integrator.id] = {1.0 + (random() % (4 * votes + 1)) / static_cast<double>(votes), votes};
+    }
+    CatalogColumns columns;
+    columns.build(integrators);
+    // id = номер строки + 1
+    std::vector<double> averages(count, 0.0);
+    for (const auto& entry : ratingStats) averages[entry.first - 1] = entry.second.average;
+    CatalogOrdering byRatingDesc;
+    columns.buildRatingOrdering(byRatingDesc, CatalogOrder::RatingDesc, averages);
+
+    struct Case {
+        const char* sort;
+        CatalogOrder order;
+        const char* filterCity;
+    };
+    const Case cases[] = {
+        {"name_asc", CatalogOrder::NameAsc, ""},
+        {"name_desc", CatalogOrder::NameDesc, ""},
+        {"city_asc", CatalogOrder::CityAsc, ""},
+        {"rating_desc", CatalogOrder::RatingDesc, ""},
+        {"name_asc", CatalogOrder::NameAsc, "Казань"},
+    };
+    const size_t pageSize = 5;
+
+    std::cout << "Страница каталога (" << pageSize << " строк): " << count << " интеграторов" << std::endl;
+    for (const Case& c : cases) {
+        const CatalogOrdering& ordering = c.order == CatalogOrder::RatingDesc ? byRatingDesc : columns.ordering(c.order);
+        // Равные ключи прежний способ оставляет в произвольном порядке - сверяются ключи
+        std::vector<const Integrator*> expected = legacyListing(integrators, c.filterCity, c.sort, ratingStats);
+        std::vector<uint32_t> rows = columnListing(columns, c.filterCity, ordering, count);
+        bool same = expected.size() == rows.size();
+        for (size_t i = 0; same && i < rows.size(); i++) {
+            const Integrator& a = *expected[i];
+            const Integrator& b = integrators[rows[i]];
+            same = a.name == b.name && (c.order != CatalogOrder::CityAsc || a.city == b.city) &&
+                   (c.order != CatalogOrder::RatingDesc || averageOf(ratingStats, a.id) == averageOf(ratingStats, b.id));
+        }
+        if (!same) {
+            std::cerr << "Порядок не совпадает: sort=" << c.sort << " filter_city=" << c.filterCity << std::endl;
+            return 1;
+        }
+
+        double legacyNs = measure([&] { sink += legacyListing(integrators, c.filterCity, c.sort, ratingStats).size(); });
+        double orderedNs = measure([&] { sink += columnListing(columns, c.filterCity, ordering, pageSize).size(); });
+        std::string name = std::string(c.sort) + (c.filterCity[0] ? ", filter_city" : "");
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+                  << "legacy " << std::setw(9) << legacyNs / 1000 << " мкс, порядок " << std::setw(8)
+                  << orderedNs / 1000 << " мкс (" << legacyNs / orderedNs << "x)" << std::endl;
+    }
+
+    // Новая оценка одного интегратора: порядок перестраивается заново или строка переставляется
+    uint32_t ratedRow = static_cast<uint32_t>(count / 2);
+    std::vector<double> updated = averages;
+    updated[ratedRow] = 4.5;
+    CatalogOrdering rebuilt;
+    columns.buildRatingOrdering(rebuilt, CatalogOrder::RatingDesc, updated);
+    CatalogOrdering patched = byRatingDesc;
+    columns.updateRatingOrdering(patched, CatalogOrder::RatingDesc, updated, {ratedRow});
+    if (patched.rows != rebuilt.rows || patched.positions != rebuilt.positions) {
+        std::cerr << "Перестановка строки расходится с полной сортировкой" << std::endl;
+        return 1;
+    }
+    double rebuildNs = measure([&] {
+        CatalogOrdering ordering;
+        columns.buildRatingOrdering(ordering, CatalogOrder::RatingDesc, updated);
+        sink += ordering.rows.size();
+    });
+    double updateNs = measure([&] {
+        CatalogOrdering ordering = byRatingDesc;
+        columns.updateRatingOrdering(ordering, CatalogOrder::RatingDesc, updated, {ratedRow});
+        sink += ordering.rows.size();
+    });
+    std::cout << std::left << std::setw(30) << "rating_desc, 1 оценка" << std::right << "сортировка " << std::setw(9)
+              << rebuildNs / 1000 << " мкс, перестановка " << std::setw(8) << updateNs / 1000 << " мкс ("
+              << rebuildNs / updateNs << "x)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,290 @@
+// Микробенчмарк разбора формы /add и /update: прежний способ (parsePostData в
+// std::map и поиск полей license_number[] и т.п. через body.find) против FormData.
+// Перед замерами результаты сверяются.
+//
+// Запуск: make microbench
+
+#include "form_parser.h"
+#include "text_kernels.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <string>
+#include <functional>
+
+namespace {
+
+struct License {
+    std::string number;
+    std::string issuedBy;
+    bool operator==(const License& other) const { return number == other.number && issuedBy == other.issuedBy; }
+};
+
+struct Certificate {
+    std::string name;
+    std::string issuedBy;
+    std::string number;
+    bool operator==(const Certificate& other) const {
+        return name == other.name && issuedBy == other.issuedBy && number == other.number;
+    }
+};
+
+struct ParsedForm {
+    std::string name;
+    std::string city;
+    std::string description;
+    std::string website;
+    int countryId = 0;
+    std::vector<License> licenses;
+    std::vector<Certificate> certificates;
+    std::vector<int> productIds;
+    std::vector<int> serviceIds;
+
+    bool operator==(const ParsedForm& other) const {
+        return name == other.name && city == other.city && description == other.description &&
+               website == other.website && countryId == other.countryId && licenses == other.licenses &&
+               certificates == other.certificates && productIds == other.productIds && serviceIds == other.serviceIds;
+    }
+};
+
+volatile size_t sink = 0;
+
+// Обработчик /add до перехода на FormData
+namespace legacy {
+
+std::string urlDecode(const std::string& str) {
+    std::string result;
+    for (size_t i = 0; i < str.length(); i++) {
+        if (str[i] == '%' && i + 2 < str.length()) {
+            int value;
+            std::istringstream(str.substr(i + 1, 2)) >> std::hex >> value;
+            result += static_cast<char>(value);
+            i += 2;
+        } else if (str[i] == '+') {
+            result += ' ';
+        } else {
+            result += str[i];
+        }
+    }
+    return result;
+}
+
+std::map<std::string, std::string> parsePostData(const std::string& data) {
+    std::map<std::string, std::string> params;
+    std::istringstream stream(data);
+    std::string pair;
+    while (std::getline(stream, pair, '&')) {
+        size_t pos = pair.find('=');
+        if (pos != std::string::npos) {
+            params[urlDecode(pair.substr(0, pos))] = urlDecode(pair.substr(pos + 1));
+        }
+    }
+    return params;
+}
+
+ParsedForm parse(const std::string& body) {
+    ParsedForm result;
+    auto params = parsePostData(body);
+    result.name = params["name"];
+    result.city = params["city"];
+    result.description = params["description"];
+    result.website = params["website"];
+    if (!params["country_id"].empty()) {
+        try { result.countryId = std::stoi(params["country_id"]); } catch (...) {}
+    }
+
+    size_t pos = 0;
+    while ((pos = body.find("license_number[]=", pos)) != std::string::npos) {
+        pos += 17;
+        size_t end = body.find("&", pos);
+        if (end == std::string::npos) end = body.length();
+        std::string num = urlDecode(body.substr(pos, end - pos));
+        pos = body.find("license_issued_by[]=", end);
+        if (pos != std::string::npos) {
+            pos += 20;
+            end = body.find("&", pos);
+            if (end == std::string::npos) end = body.length();
+            std::string issued = urlDecode(body.substr(pos, end - pos));
+            if (!num.empty() && !issued.empty()) {
+                result.licenses.push_back({num, issued});
+            }
+        }
+    }
+
+    pos = 0;
+    while ((pos = body.find("certificate_name[]=", pos)) != std::string::npos) {
+        pos += 19;
+        size_t end = body.find("&", pos);
+        if (end == std::string::npos) end = body.length();
+        std::string name = urlDecode(body.substr(pos, end - pos));
+
+        pos = body.find("certificate_number[]=", end);
+        std::string number = "";
+        if (pos != std::string::npos) {
+            pos += 21;
+            end = body.find("&", pos);
+            if (end == std::string::npos) end = body.length();
+            number = urlDecode(body.substr(pos, end - pos));
+        }
+
+        pos = body.find("certificate_issued_by[]=", end);
+        if (pos != std::string::npos) {
+            pos += 24;
+            end = body.find("&", pos);
+            if (end == std::string::npos) end = body.length();
+            std::string issued = urlDecode(body.substr(pos, end - pos));
+            if (!name.empty() && !issued.empty()) {
+                result.certificates.push_back({name, issued, number});
+            }
+        }
+    }
+
+    pos = 0;
+    while ((pos = body.find("products[]=", pos)) != std::string::npos) {
+        pos += 11;
+        size_t end = body.find("&", pos);
+        if (end == std::string::npos) end = body.length();
+        try {
+            result.productIds.push_back(std::stoi(urlDecode(body.substr(pos, end - pos))));
+        } catch (...) {}
+    }
+
+    pos = 0;
+    while ((pos = body.find("services[]=", pos)) != std::string::npos) {
+        pos += 11;
+        size_t end = body.find("&", pos);
+        if (end == std::string::npos) end = body.length();
+        try {
+            result.serviceIds.push_back(std::stoi(urlDecode(body.substr(pos, end - pos))));
+        } catch (...) {}
+    }
+    return result;
+}
+
+} // namespace legacy
+
+// То же, что readIntegratorForm в server.cpp
+ParsedForm parseWithFormData(const std::string& body) {
+    FormData form(body);
+    ParsedForm result;
+    result.name = std::string(form.get("name"));
+    result.city = std::string(form.get("city"));
+    result.description = std::string(form.get("description"));
+    result.website = std::string(form.get("website"));
+    parseFormInt(form.get("country_id"), result.countryId);
+
+    FormValues licenseNumbers = form.getAll("license_number[]");
+    FormValues licenseIssuers = form.getAll("license_issued_by[]");
+    for (size_t i = 0; i < licenseNumbers.size(); i++) {
+        if (!licenseNumbers[i].empty() && !licenseIssuers[i].empty()) {
+            result.licenses.push_back({std::string(licenseNumbers[i]), std::string(licenseIssuers[i])});
+        }
+    }
+
+    FormValues certificateNames = form.getAll("certificate_name[]");
+    FormValues certificateNumbers = form.getAll("certificate_number[]");
+    FormValues certificateIssuers = form.getAll("certificate_issued_by[]");
+    for (size_t i = 0; i < certificateNames.size(); i++) {
+        if (!certificateNames[i].empty() && !certificateIssuers[i].empty()) {
+            result.certificates.push_back({std::string(certificateNames[i]), std::string(certificateIssuers[i]),
+                                           std::string(certificateNumbers[i])});
+        }
+    }
+
+    for (std::string_view value : form.getAll("products[]")) {
+        int id;
+        if (parseFormInt(value, id)) result.productIds.push_back(id);
+    }
+    for (std::string_view value : form.getAll("services[]")) {
+        int id;
+        if (parseFormInt(value, id)) result.serviceIds.push_back(id);
+    }
+    return result;
+}
+
+std::string percentEncode(const std::string& value) {
+    static const char* hex = "0123456789ABCDEF";
+    std::string result;
+    for (unsigned char c : value) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.') {
+            result += static_cast<char>(c);
+        } else if (c == ' ') {
+            result += '+';
+        } else {
+            result += '%';
+            result += hex[c >> 4];
+            result += hex[c & 15];
+        }
+    }
+    return result;
+}
+
+// Тело формы редактирования; brackets - как записаны имена массивов ("[]" или "%5B%5D")
+std::string makeFormBody(size_t licenses, const std::string& brackets) {
+    std::string body = "id=42&name=" + percentEncode("ООО «Защита Информации»") +
+                       "&city=" + percentEncode("Санкт-Петербург") +
+                       "&description=" + percentEncode("Комплексная защита инфраструктуры, аудит и сопровождение.") +
+                       "&website=" + percentEncode("https://example.ru") +
+                       "&country_id=1";
+    for (size_t i = 0; i < licenses; i++) {
+        body += "&license_number" + brackets + "=" + percentEncode("Л024-00107-00/" + std::to_string(100000 + i)) +
+                "&license_issued_by" + brackets + "=" + percentEncode("ФСТЭК России");
+    }
+    for (size_t i = 0; i < licenses / 2; i++) {
+        body += "&certificate_name" + brackets + "=" + percentEncode("Сертификат соответствия " + std::to_string(i)) +
+                "&certificate_number" + brackets + "=" + std::to_string(2000 + i) +
+                "&certificate_issued_by" + brackets + "=" + percentEncode("ФСБ России");
+    }
+    for (int id = 1; id <= 10; id++) {
+        body += "&products" + brackets + "=" + std::to_string(id);
+        body += "&services" + brackets + "=" + std::to_string(id);
+    }
+    return body;
+}
+
+double measure(const std::function<void()>& body) {
+    using clock = std::chrono::steady_clock;
+    size_t iterations = 1;
+    for (;;) {
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; i++) body();
+        double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        if (elapsed > 2e8 || iterations > (1u << 30)) {
+            return elapsed / iterations;
+        }
+        iterations *= elapsed < 1e7 ? 8 : 2;
+    }
+}
+
+} // namespace
+
+int main() {
+    std::cout << "Ядро обработки строк: " << textKernelName(textKernelLevel()) << std::endl << std::endl;
+
+    for (size_t licenses : {1, 10, 100}) {
+        std::string body = makeFormBody(licenses, "[]");
+        std::string encodedBody = makeFormBody(licenses, "%5B%5D");
+
+        ParsedForm expected = legacy::parse(body);
+        if (expected.licenses.size() != licenses || !(parseWithFormData(body) == expected) ||
+            !(parseWithFormData(encodedBody) == expected)) {
+            std::cerr << "Результаты разбора не совпадают для " << licenses << " лицензий" << std::endl;
+            return 1;
+        }
+
+        double legacyNs = measure([&] { sink += legacy::parse(body).licenses.size(); });
+        double formNs = measure([&] { sink += parseWithFormData(body).licenses.size(); });
+        double parseOnlyNs = measure([&] { FormData form(body); sink += form.fieldCount(); });
+
+        std::cout << std::left << std::setw(6) << licenses << " лицензий, " << std::setw(6) << body.size() << " байт: "
+                  << std::right << std::fixed << std::setprecision(1)
+                  << "legacy " << std::setw(10) << legacyNs / 1000 << " мкс, "
+                  << "FormData " << std::setw(8) << formNs / 1000 << " мкс ("
+                  << legacyNs / formNs << "x), "
+                  << "только разбор " << std::setw(7) << parseOnlyNs / 1000 << " мкс" << std::endl;
+    }
+    return 0;
+}
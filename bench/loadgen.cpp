@@ -0,0 +1,575 @@
+// Нагрузочный генератор для сквозного замера сервера: много одновременных
+// соединений (keep-alive, если сервер его поддерживает; иначе - новое
+// соединение на запрос), смесь входов, просмотров главной с фильтрами,
+// сортировкой и страницами, оценок и правок администратора.
+//
+// Перед замером создаются пользователи bench_user_N, администратор admin и
+// отдельный интегратор "Bench <pid>": оценки и правки идут только в него, в
+// конце он удаляется. Результат - throughput и p50/p99/p999 по каждому типу
+// запроса, в stdout и в JSON-файл.
+//
+// Запуск: make bench (поднимает сервер) или
+//   build/loadgen --port 8080 --connections 64 --duration 20 --output build/bench_results.json
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Kind { Login, Main, Rate, Update, Count };
+const char* const KIND_NAMES[] = {"login", "main", "rate", "update"};
+const int KINDS = static_cast<int>(Kind::Count);
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    int connections = 64;
+    double duration = 20;
+    double warmup = 2;
+    double wait = 30;                 // ожидание запуска сервера
+    int weights[KINDS] = {5, 80, 10, 5};
+    std::string adminPassword = "admin123";
+    std::string label;
+    std::string output;
+};
+
+struct Response {
+    int status = 0;
+    std::string headers;
+    std::string body;
+};
+
+std::string percentEncode(const std::string& value) {
+    static const char* hex = "0123456789ABCDEF";
+    std::string result;
+    for (unsigned char c : value) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.') {
+            result += static_cast<char>(c);
+        } else {
+            result += '%';
+            result += hex[c >> 4];
+            result += hex[c & 15];
+        }
+    }
+    return result;
+}
+
+// Значение заголовка (имя в нижнем регистре), пусто если нет
+std::string headerValue(const std::string& headers, const std::string& name) {
+    std::string lower = headers;
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return std::tolower(c); });
+    size_t pos = lower.find("\r\n" + name + ":");
+    if (pos == std::string::npos) return "";
+    pos += name.size() + 3;
+    size_t end = headers.find("\r\n", pos);
+    std::string value = headers.substr(pos, end - pos);
+    value.erase(0, value.find_first_not_of(' '));
+    return value;
+}
+
+std::string cookieValue(const std::string& headers, const std::string& name) {
+    std::string marker = "Set-Cookie: " + name + "=";
+    size_t pos = headers.find(marker);
+    if (pos == std::string::npos) return "";
+    pos += marker.size();
+    return headers.substr(pos, headers.find_first_of(";\r", pos) - pos);
+}
+
+class Connection {
+private:
+    const Options& options;
+    int fd = -1;
+    std::string pending;   // байты сверх предыдущего ответа
+
+    bool open() {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return false;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(options.port);
+        if (inet_pton(AF_INET, options.host.c_str(), &addr.sin_addr) != 1 ||
+            ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            closeSocket();
+            return false;
+        }
+        pending.clear();
+        return true;
+    }
+
+    bool readMore() {
+        char buffer[16384];
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) return false;
+        pending.append(buffer, n);
+        return true;
+    }
+
+    bool attempt(const std::string& request, Response& response) {
+        if (fd < 0 && !open()) return false;
+        size_t sent = 0;
+        while (sent < request.size()) {
+            ssize_t n = send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            sent += n;
+        }
+
+        size_t headerEnd;
+        while ((headerEnd = pending.find("\r\n\r\n")) == std::string::npos) {
+            if (!readMore()) return false;
+        }
+        response.headers = pending.substr(0, headerEnd + 2);
+        response.status = std::atoi(response.headers.c_str() + response.headers.find(' ') + 1);
+        pending.erase(0, headerEnd + 4);
+
+        std::string length = headerValue(response.headers, "content-length");
+        bool closeAfter = headerValue(response.headers, "connection") == "close";
+        if (!length.empty()) {
+            size_t bodySize = std::strtoul(length.c_str(), nullptr, 10);
+            while (pending.size() < bodySize) {
+                if (!readMore()) return false;
+            }
+            response.body = pending.substr(0, bodySize);
+            pending.erase(0, bodySize);
+        } else {
+            // Без Content-Length тело заканчивается закрытием соединения
+            while (readMore()) {}
+            response.body.swap(pending);
+            pending.clear();
+            closeAfter = true;
+        }
+        if (closeAfter) closeSocket();
+        return true;
+    }
+
+public:
+    explicit Connection(const Options& opts) : options(opts) {}
+    ~Connection() { closeSocket(); }
+
+    void closeSocket() {
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+
+    // Один запрос-ответ; keep-alive соединение, закрытое сервером, переоткрывается один раз
+    bool roundTrip(const std::string& request, Response& response) {
+        bool reused = fd >= 0;
+        if (attempt(request, response)) return true;
+        closeSocket();
+        return reused && attempt(request, response);
+    }
+};
+
+std::string buildRequest(const Options& options, const std::string& method, const std::string& target,
+                         const std::string& cookies, const std::string& body = "") {
+    std::ostringstream request;
+    request << method << " " << target << " HTTP/1.1\r\n"
+            << "Host: " << options.host << ":" << options.port << "\r\n"
+            << "Connection: keep-alive\r\n";
+    if (!cookies.empty()) {
+        request << "Cookie: " << cookies << "\r\n";
+    }
+    if (method == "POST") {
+        request << "Content-Type: application/x-www-form-urlencoded\r\n"
+                << "Content-Length: " << body.size() << "\r\n";
+    }
+    request << "\r\n" << body;
+    return request.str();
+}
+
+std::string loginBody(const std::string& user, const std::string& password) {
+    return "username=" + percentEncode(user) + "&password=" + percentEncode(password);
+}
+
+// Вход; возвращает строку для заголовка Cookie или пусто (код ответа - в status)
+std::string login(const Options& options, Connection& connection, const std::string& user,
+                  const std::string& password, int* status = nullptr) {
+    Response response;
+    bool received = connection.roundTrip(buildRequest(options, "POST", "/login", "", loginBody(user, password)),
+                                         response);
+    if (status) *status = received ? response.status : 0;
+    if (!received) return "";
+    std::string session = cookieValue(response.headers, "session_id");
+    if (session.empty()) return "";
+    return "session_id=" + session + "; tab_token=" + cookieValue(response.headers, "tab_token");
+}
+
+void registerUser(const Options& options, Connection& connection, const std::string& user,
+                  const std::string& password) {
+    Response response;
+    std::string body = loginBody(user, password) + "&password_confirm=" + percentEncode(password);
+    connection.roundTrip(buildRequest(options, "POST", "/register", "", body), response);
+}
+
+std::string benchIntegratorForm(const std::string& name, int revision) {
+    std::string body = "name=" + percentEncode(name) + "&city=" + percentEncode("Москва") +
+                       "&description=" + percentEncode("Нагрузочный тест, правка " + std::to_string(revision)) +
+                       "&website=" + percentEncode("https://bench.example") + "&country_id=1";
+    for (int i = 0; i < 3; i++) {
+        body += "&license_number%5B%5D=" + percentEncode("BENCH-" + std::to_string(revision) + "-" + std::to_string(i)) +
+                "&license_issued_by%5B%5D=" + percentEncode("ФСТЭК России");
+    }
+    body += "&products%5B%5D=1&products%5B%5D=2&services%5B%5D=1";
+    return body;
+}
+
+struct Shared {
+    const Options& options;
+    std::string adminCookies;
+    int benchIntegratorId = 0;
+    std::string benchIntegratorName;
+    std::atomic<bool> stop{false};
+    Clock::time_point measureFrom;
+
+    explicit Shared(const Options& opts) : options(opts) {}
+};
+
+struct WorkerStats {
+    std::vector<uint32_t> latencies[KINDS];
+    uint64_t errors[KINDS] = {};
+    bool loginFailed = false;   // без сессии все запросы получили бы страницу входа
+};
+
+// Главная страница с каталогом, а не форма входа или страница ошибки
+bool isCatalogPage(const Response& response) {
+    return response.body.find("class='results-info'") != std::string::npos;
+}
+
+const int LOGIN_ATTEMPTS = 10;
+
+const char* const SORTS[] = {"name_asc", "name_desc", "city_asc", "city_desc", "rating_desc", "rating_asc"};
+const char* const QUERIES[] = {"защита", "аудит", "DLP", "сертификат", "SOC"};
+const char* const CITIES[] = {"Москва", "Санкт-Петербург", "Казань", "Новосибирск"};
+
+std::string mainPageTarget(std::mt19937& random) {
+    std::string target = "/?sort=" + std::string(SORTS[random() % 6]) + "&page=" + std::to_string(1 + random() % 5);
+    switch (random() % 5) {
+        case 0: target += "&filter_city=" + percentEncode(CITIES[random() % 4]); break;
+        case 1: target += "&product=" + std::to_string(1 + random() % 5); break;
+        case 2: target += "&service=" + std::to_string(1 + random() % 5); break;
+        case 3: target += "&q=" + percentEncode(QUERIES[random() % 5]); break;
+        default: break;
+    }
+    return target;
+}
+
+void worker(Shared& shared, int index, WorkerStats& stats) {
+    const Options& options = shared.options;
+    std::mt19937 random(index * 7919 + 17);
+    Connection connection(options);
+    std::string user = "bench_user_" + std::to_string(index % 8);
+    // Соединения входят одновременно, а очередь хеширования паролей
+    // (PASSWORD_QUEUE) и лимит входов ограничены: на 503/429 вход повторяется
+    // после паузы со случайным сдвигом, чтобы повторы не шли волной
+    std::string cookies;
+    for (int attempt = 0; attempt < LOGIN_ATTEMPTS && !shared.stop.load(std::memory_order_relaxed); attempt++) {
+        int status = 0;
+        cookies = login(options, connection, user, "bench", &status);
+        if (!cookies.empty() || (status != 503 && status != 429)) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds((100 << std::min(attempt, 4)) + random() % 100));
+    }
+    if (cookies.empty()) {
+        stats.loginFailed = true;
+        return;
+    }
+
+    int totalWeight = 0;
+    for (int weight : options.weights) totalWeight += weight;
+    int revision = index * 1000000;
+
+    while (!shared.stop.load(std::memory_order_relaxed)) {
+        int pick = static_cast<int>(random() % totalWeight);
+        int kind = 0;
+        while (pick >= options.weights[kind]) pick -= options.weights[kind++];
+
+        std::string request;
+        switch (static_cast<Kind>(kind)) {
+            case Kind::Login:
+                request = buildRequest(options, "POST", "/login", "", loginBody(user, "bench"));
+                break;
+            case Kind::Main:
+                request = buildRequest(options, "GET", mainPageTarget(random), cookies);
+                break;
+            case Kind::Rate:
+                request = buildRequest(options, "POST", "/rate", cookies,
+                                       "id=" + std::to_string(shared.benchIntegratorId) + "&rating=" +
+                                       std::to_string(1 + random() % 5) + "&comment=" + percentEncode("нагрузка"));
+                break;
+            case Kind::Update:
+                request = buildRequest(options, "POST", "/update", shared.adminCookies,
+                                       "id=" + std::to_string(shared.benchIntegratorId) + "&" +
+                                       benchIntegratorForm(shared.benchIntegratorName, ++revision));
+                break;
+            default:
+                break;
+        }
+
+        Response response;
+        auto start = Clock::now();
+        bool ok = connection.roundTrip(request, response) && response.status > 0 && response.status < 400;
+        auto end = Clock::now();
+
+        if (ok && static_cast<Kind>(kind) == Kind::Main) {
+            ok = isCatalogPage(response);
+        }
+        if (ok && static_cast<Kind>(kind) == Kind::Login) {
+            std::string fresh = cookieValue(response.headers, "session_id");
+            if (fresh.empty()) {
+                ok = false;
+            } else {
+                cookies = "session_id=" + fresh + "; tab_token=" + cookieValue(response.headers, "tab_token");
+            }
+        }
+        if (start < shared.measureFrom) continue;
+        if (!ok) {
+            stats.errors[kind]++;
+            continue;
+        }
+        stats.latencies[kind].push_back(static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(end - start).count()));
+    }
+}
+
+uint32_t percentile(const std::vector<uint32_t>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    size_t rank = static_cast<size_t>(q * sorted.size() + 0.999999);
+    return sorted[std::min(sorted.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+struct Summary {
+    std::string name;
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    double throughput = 0;
+    double meanMicros = 0;
+    uint32_t p50 = 0, p99 = 0, p999 = 0, max = 0;
+};
+
+Summary summarize(const std::string& name, std::vector<uint32_t>& latencies, uint64_t errors, double seconds) {
+    std::sort(latencies.begin(), latencies.end());
+    Summary summary;
+    summary.name = name;
+    summary.requests = latencies.size();
+    summary.errors = errors;
+    summary.throughput = latencies.size() / seconds;
+    double total = 0;
+    for (uint32_t value : latencies) total += value;
+    summary.meanMicros = latencies.empty() ? 0 : total / latencies.size();
+    summary.p50 = percentile(latencies, 0.50);
+    summary.p99 = percentile(latencies, 0.99);
+    summary.p999 = percentile(latencies, 0.999);
+    summary.max = latencies.empty() ? 0 : latencies.back();
+    return summary;
+}
+
+void writeSummaryJson(std::ostream& out, const Summary& s) {
+    out << "{\"requests\": " << s.requests << ", \"errors\": " << s.errors
+        << ", \"throughput_rps\": " << std::fixed << std::setprecision(1) << s.throughput
+        << ", \"mean_us\": " << s.meanMicros
+        << ", \"p50_us\": " << s.p50 << ", \"p99_us\": " << s.p99 << ", \"p999_us\": " << s.p999
+        << ", \"max_us\": " << s.max << "}";
+}
+
+bool parseMix(const std::string& mix, int* weights) {
+    std::fill(weights, weights + KINDS, 0);
+    std::istringstream stream(mix);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) return false;
+        std::string name = item.substr(0, eq);
+        int kind = 0;
+        while (kind < KINDS && name != KIND_NAMES[kind]) kind++;
+        if (kind == KINDS) return false;
+        weights[kind] = std::atoi(item.c_str() + eq + 1);
+    }
+    int total = 0;
+    for (int i = 0; i < KINDS; i++) total += weights[i];
+    return total > 0;
+}
+
+void usage() {
+    std::cerr << "Использование: loadgen [--host 127.0.0.1] [--port 8080] [--connections 64]\n"
+              << "  [--duration 20] [--warmup 2] [--wait 30] [--mix login=5,main=80,rate=10,update=5]\n"
+              << "  [--admin-password admin123] [--label текст] [--output файл.json]" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage();
+            return 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--host") options.host = value;
+        else if (arg == "--port") options.port = std::atoi(value.c_str());
+        else if (arg == "--connections") options.connections = std::max(1, std::atoi(value.c_str()));
+        else if (arg == "--duration") options.duration = std::atof(value.c_str());
+        else if (arg == "--warmup") options.warmup = std::atof(value.c_str());
+        else if (arg == "--wait") options.wait = std::atof(value.c_str());
+        else if (arg == "--admin-password") options.adminPassword = value;
+        else if (arg == "--label") options.label = value;
+        else if (arg == "--output") options.output = value;
+        else if (arg == "--mix") {
+            if (!parseMix(value, options.weights)) {
+                usage();
+                return 1;
+            }
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    Shared shared(options);
+    Connection setup(options);
+
+    // Ждём, пока сервер начнёт принимать соединения
+    auto waitUntil = Clock::now() + std::chrono::milliseconds(static_cast<int>(options.wait * 1000));
+    Response probe;
+    while (!setup.roundTrip(buildRequest(options, "GET", "/metrics", ""), probe)) {
+        if (Clock::now() > waitUntil) {
+            std::cerr << "Сервер " << options.host << ":" << options.port << " не отвечает" << std::endl;
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    // Пользователи (повторная регистрация просто отклоняется сервером)
+    registerUser(options, setup, "admin", options.adminPassword);
+    for (int i = 0; i < 8; i++) {
+        registerUser(options, setup, "bench_user_" + std::to_string(i), "bench");
+    }
+    shared.adminCookies = login(options, setup, "admin", options.adminPassword);
+    if (shared.adminCookies.empty()) {
+        std::cerr << "Не удалось войти как admin (--admin-password?)" << std::endl;
+        return 1;
+    }
+
+    // Отдельный интегратор для оценок и правок
+    shared.benchIntegratorName = "Bench " + std::to_string(getpid());
+    Response response;
+    setup.roundTrip(buildRequest(options, "POST", "/add", shared.adminCookies,
+                                 benchIntegratorForm(shared.benchIntegratorName, 0)), response);
+    setup.roundTrip(buildRequest(options, "GET", "/?name=" + percentEncode(shared.benchIntegratorName),
+                                 shared.adminCookies), response);
+    size_t idPos = response.body.find("name='id' value='");
+    if (idPos == std::string::npos) {
+        std::cerr << "Не найден созданный интегратор " << shared.benchIntegratorName << std::endl;
+        return 1;
+    }
+    shared.benchIntegratorId = std::atoi(response.body.c_str() + idPos + 17);
+
+    std::cout << "Нагрузка: " << options.connections << " соединений, " << options.duration << " с (+"
+              << options.warmup << " с разогрев), смесь";
+    for (int i = 0; i < KINDS; i++) std::cout << " " << KIND_NAMES[i] << "=" << options.weights[i];
+    std::cout << std::endl;
+
+    auto start = Clock::now();
+    shared.measureFrom = start + std::chrono::milliseconds(static_cast<int>(options.warmup * 1000));
+    std::vector<WorkerStats> stats(options.connections);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < options.connections; i++) {
+        threads.emplace_back(worker, std::ref(shared), i, std::ref(stats[i]));
+    }
+    std::this_thread::sleep_until(shared.measureFrom + std::chrono::milliseconds(static_cast<int>(options.duration * 1000)));
+    shared.stop.store(true);
+    for (auto& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - shared.measureFrom).count();
+
+    int loginFailures = 0;
+    for (const auto& worker : stats) loginFailures += worker.loginFailed;
+    if (loginFailures > 0) {
+        std::cerr << "Не удалось войти: " << loginFailures << " из " << options.connections
+                  << " соединений остались без сессии, замер недействителен" << std::endl;
+        setup.roundTrip(buildRequest(options, "POST", "/delete", shared.adminCookies,
+                                     "id=" + std::to_string(shared.benchIntegratorId)), response);
+        return 2;
+    }
+
+    setup.roundTrip(buildRequest(options, "POST", "/delete", shared.adminCookies,
+                                 "id=" + std::to_string(shared.benchIntegratorId)), response);
+
+    std::vector<Summary> summaries;
+    std::vector<uint32_t> all;
+    uint64_t allErrors = 0;
+    for (int kind = 0; kind < KINDS; kind++) {
+        std::vector<uint32_t> merged;
+        uint64_t errors = 0;
+        for (auto& worker : stats) {
+            merged.insert(merged.end(), worker.latencies[kind].begin(), worker.latencies[kind].end());
+            errors += worker.errors[kind];
+        }
+        all.insert(all.end(), merged.begin(), merged.end());
+        allErrors += errors;
+        summaries.push_back(summarize(KIND_NAMES[kind], merged, errors, seconds));
+    }
+    Summary total = summarize("total", all, allErrors, seconds);
+
+    // Заголовки латиницей: setw считает байты, а не символы
+    std::cout << std::left << std::setw(8) << "" << std::right << std::setw(10) << "requests" << std::setw(8) << "errors"
+              << std::setw(10) << "rps" << std::setw(10) << "p50_ms" << std::setw(10) << "p99_ms" << std::setw(10)
+              << "p999_ms" << std::endl;
+    summaries.push_back(total);
+    for (const auto& s : summaries) {
+        std::cout << std::left << std::setw(8) << s.name << std::right << std::setw(10) << s.requests
+                  << std::setw(8) << s.errors << std::fixed << std::setprecision(1) << std::setw(10) << s.throughput
+                  << std::setprecision(2) << std::setw(10) << s.p50 / 1000.0 << std::setw(10) << s.p99 / 1000.0
+                  << std::setw(10) << s.p999 / 1000.0 << std::endl;
+    }
+    summaries.pop_back();
+
+    if (!options.output.empty()) {
+        std::ofstream out(options.output);
+        if (!out) {
+            std::cerr << "Ошибка записи " << options.output << std::endl;
+            return 1;
+        }
+        out << "{\n  \"label\": \"" << options.label << "\",\n"
+            << "  \"timestamp\": " << std::chrono::duration_cast<std::chrono::seconds>(
+                   std::chrono::system_clock::now().time_since_epoch()).count() << ",\n"
+            << "  \"connections\": " << options.connections << ",\n"
+            << "  \"duration_s\": " << std::fixed << std::setprecision(3) << seconds << ",\n"
+            << "  \"mix\": {";
+        for (int i = 0; i < KINDS; i++) {
+            out << (i ? ", " : "") << "\"" << KIND_NAMES[i] << "\": " << options.weights[i];
+        }
+        out << "},\n  \"total\": ";
+        writeSummaryJson(out, total);
+        out << ",\n  \"endpoints\": {\n";
+        for (size_t i = 0; i < summaries.size(); i++) {
+            out << "    \"" << summaries[i].name << "\": ";
+            writeSummaryJson(out, summaries[i]);
+            out << (i + 1 < summaries.size() ? ",\n" : "\n");
+        }
+        out << "  }\n}\n";
+        std::cout << "Результаты: " << options.output << std::endl;
+    }
+    return total.errors > total.requests / 100 ? 2 : 0;
+}
@@ -0,0 +1,175 @@
+// Микробенчмарки чистых функций сервера на типичных входных данных:
+// кириллица в URL и HTML, длинные формы, заголовки с cookie, главная страница
+// с большим числом интеграторов, разбор sql/queries.sql.
+// Функции берутся из build/libinfosec.a - те же, что в сервере.
+//
+// Запуск: make microbench (из корня проекта, нужен sql/queries.sql)
+// Фильтр по имени: build/microbench generateMainPage
+
+#include "http_utils.h"
+#include "pages.h"
+#include "database.h"
+#include "text_kernels.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace {
+
+volatile size_t sink = 0;
+
+double measure(const std::function<void()>& body) {
+    using clock = std::chrono::steady_clock;
+    size_t iterations = 1;
+    for (;;) {
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; i++) body();
+        double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        if (elapsed > 2e8 || iterations > (1u << 30)) {
+            return elapsed / iterations;
+        }
+        iterations *= elapsed < 1e7 ? 8 : 2;
+    }
+}
+
+// name - имя замера, bytes - размер входа для пропускной способности (0 - не выводить)
+void report(const std::string& name, size_t bytes, double ns) {
+    // setw считает байты; выравниваем по числу символов UTF-8
+    size_t width = 0;
+    for (unsigned char c : name) {
+        if ((c & 0xC0) != 0x80) width++;
+    }
+    std::cout << name << std::string(width < 44 ? 44 - width : 1, ' ') << std::fixed << std::setprecision(1)
+              << std::setw(12) << ns << " нс";
+    if (bytes > 0) {
+        std::cout << std::setw(10) << bytes * 1e3 / ns << " МБ/с";
+    }
+    std::cout << std::endl;
+}
+
+std::string repeatText(const std::string& text, size_t bytes) {
+    std::string result;
+    while (result.size() < bytes) result += text;
+    return result;
+}
+
+const std::string CYRILLIC = "Комплексная защита информации: аудит, внедрение DLP и SIEM, \"сопровождение\" <24/7> & обучение. ";
+
+std::vector<Integrator> makeIntegrators(size_t count) {
+    const char* cities[] = {"Москва", "Санкт-Петербург", "Казань", "Новосибирск", "Екатеринбург"};
+    std::vector<Integrator> result;
+    for (size_t i = 0; i < count; i++) {
+        Integrator integrator;
+        integrator.id = static_cast<int>(i + 1);
+        integrator.name = "ООО «Интегратор безопасности №" + std::to_string(i + 1) + "»";
+        integrator.city = cities[i % 5];
+        integrator.description = repeatText(CYRILLIC, 400);
+        integrator.website = "https://integrator" + std::to_string(i + 1) + ".ru";
+        integrator.countryId = 1;
+        integrator.productIds = {1, 2, 3};
+        integrator.serviceIds = {4, 5};
+        for (int l = 0; l < 3; l++) {
+            integrator.licenses.push_back({"Л024-00107-00/" + std::to_string(100000 + l), "ФСТЭК России"});
+        }
+        integrator.certificates.push_back({"Сертификат соответствия", "ФСБ России", "СФ/124-" + std::to_string(i)});
+        result.push_back(integrator);
+    }
+    return result;
+}
+
+struct Case {
+    std::string name;
+    size_t bytes;                // размер входа
+    std::function<void()> run;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string filter = argc > 1 ? argv[1] : "";
+    auto enabled = [&](const std::string& name) { return filter.empty() || name.find(filter) != std::string::npos; };
+    std::cout << "Ядро обработки строк: " << textKernelName(textKernelLevel()) << std::endl << std::endl;
+
+    // Входные данные
+    std::string cyrillic4k = repeatText(CYRILLIC, 4096);
+    std::string encoded4k = urlEncode(cyrillic4k);
+    std::string ascii4k = repeatText("plain-ascii-text-without-escapes_", 4096);
+
+    std::string longForm = "id=42&name=" + urlEncode("ООО «Защита Информации»") + "&city=" + urlEncode("Москва") +
+                           "&description=" + urlEncode(repeatText(CYRILLIC, 1024)) + "&country_id=1";
+    for (int i = 0; i < 100; i++) {
+        longForm += "&license_number%5B%5D=" + urlEncode("Л024-00107-00/" + std::to_string(100000 + i)) +
+                    "&license_issued_by%5B%5D=" + urlEncode("ФСТЭК России");
+    }
+
+    std::string request =
+        "GET /?city=" + urlEncode("Санкт-Петербург") + "&filter_city=&name=&q=" + urlEncode("защита персональных данных") +
+        "&product=3&service=&sort=rating_desc&page=4 HTTP/1.1\r\n"
+        "Host: localhost:8080\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/120.0 Safari/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+        "Accept-Language: ru-RU,ru;q=0.9,en-US;q=0.8,en;q=0.7\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Cookie: _ga=GA1.1.123456789.1700000000; theme=dark; tab_token=0123456789abcdef0123456789abcdef; "
+        "session_id=fedcba9876543210fedcba9876543210\r\n"
+        "Connection: keep-alive\r\n\r\n";
+
+    std::vector<std::string> cities = {"Москва", "Санкт-Петербург", "Казань", "Новосибирск", "Екатеринбург"};
+    std::vector<std::pair<int, std::string>> entries;
+    for (int i = 1; i <= 12; i++) entries.push_back({i, "Элемент справочника " + std::to_string(i)});
+    Dictionary dictionary(entries);
+
+    std::vector<Case> cases = {
+        {"urlDecode кириллица 4 КБ", encoded4k.size(), [&] { sink += urlDecode(encoded4k).size(); }},
+        {"urlDecode ASCII 4 КБ", ascii4k.size(), [&] { sink += urlDecode(ascii4k).size(); }},
+        {"urlEncode кириллица 4 КБ", cyrillic4k.size(), [&] { sink += urlEncode(cyrillic4k).size(); }},
+        {"htmlEscape кириллица 4 КБ", cyrillic4k.size(), [&] { sink += htmlEscape(cyrillic4k).size(); }},
+        {"parsePostData форма со 100 лицензиями", longForm.size(), [&] { sink += parsePostData(longForm).size(); }},
+        {"getCookie session_id", request.size(), [&] { sink += getCookie(request, "session_id").size(); }},
+        {"getQueryParam q (кириллица)", request.size(), [&] { sink += getQueryParam(request, "q").size(); }},
+        {"getQueryParam page", request.size(), [&] { sink += getQueryParam(request, "page").size(); }},
+    };
+    for (const auto& c : cases) {
+        if (enabled(c.name)) report(c.name, c.bytes, measure(c.run));
+    }
+
+    // Главная страница: страница из 5 интеграторов и весь каталог разом
+    for (size_t count : {5, 100, 1000}) {
+        std::string name = "generateMainPage " + std::to_string(count) + " интеграторов";
+        if (!enabled(name)) continue;
+        std::vector<Integrator> integrators = makeIntegrators(count);
+        std::map<int, RatingStats> stats;
+        std::map<int, std::vector<Rating>> ratings;
+        for (const auto& integrator : integrators) {
+            stats[integrator.id] = {4.2, 17};
+            for (int r = 0; r < 3; r++) {
+                ratings[integrator.id].push_back({r, integrator.id, r, 4, "Хороший интегратор, рекомендую", "user" + std::to_string(r),
+                                                  "2025-01-01 12:00:00"});
+            }
+        }
+        size_t pageBytes = 0;
+        double ns = measure([&] {
+            std::string page = generateMainPage(integrators, true, true, "admin", "0123456789abcdef", cities, dictionary,
+                                                dictionary, dictionary, "", "", "", "защита", "3", "", "rating_desc",
+                                                1, 1, static_cast<int>(count), stats, ratings);
+            pageBytes = page.size();
+            sink += pageBytes;
+        });
+        report(name, pageBytes, ns);
+    }
+
+    // Разбор sql/queries.sql (без подключения к БД); вывод loadQueries подавляется
+    if (enabled("Database::loadQueries")) {
+        std::streambuf* saved = std::cout.rdbuf(nullptr);
+        Database db("localhost", "5432", "bench", "bench", "bench");
+        double ns = measure([&] { sink += db.loadQueries("sql/queries.sql"); });
+        std::cout.rdbuf(saved);
+        report("Database::loadQueries sql/queries.sql", 0, ns);
+    }
+    return 0;
+}
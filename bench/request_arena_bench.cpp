@@ -0,0 +1,213 @@
+// Выделения памяти на запрос: прежний разбор (копия запроса в std::string,
+// substr тела, parsePostData в std::map) против разбора прямо в буфере чтения
+// с FormData на арене запроса, а также отрисовка главной страницы.
+// Операторы new/delete подменены счётчиками: выводится число вызовов и байт
+// на запрос, время и пиковый RSS процесса, выполнявшего только этот вариант.
+//
+// Запуск: make microbench или build/request_arena_bench [запросов]
+
+#include "form_parser.h"
+#include "http_utils.h"
+#include "pages.h"
+#include "request_arena.h"
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+size_t allocations = 0;
+size_t allocatedBytes = 0;
+volatile size_t sink = 0;
+
+} // namespace
+
+// Сравнение с free внутри заменённого delete для GCC выглядит как несоответствие new/free
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(size_t size) {
+    allocations++;
+    allocatedBytes += size;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+const char COOKIE[] = "Cookie: session_id=6f1c0e9a2b7d4f3e8a5c1b0d9e7f6a5b4c3d2e1f0a9b8c7d6e5f4a3b2c1d0e9f; "
+                      "tab_token=0123456789abcdef\r\n";
+
+std::string makeRequest(const std::string& target, const std::string& body) {
+    return "POST " + target + " HTTP/1.1\r\nHost: localhost:8080\r\n"
+           "Content-Type: application/x-www-form-urlencoded\r\n" + COOKIE +
+           "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+std::string makeRateRequest() {
+    std::string comment;
+    while (comment.size() < 300) comment += "Хорошо внедрили DLP, рекомендую! ";
+    return makeRequest("/rate", "id=17&rating=5&comment=" + urlEncode(comment));
+}
+
+std::string makeUpdateRequest(size_t licenses) {
+    std::string body = "id=17&name=" + urlEncode("ООО «Интегратор безопасности»") + "&city=" + urlEncode("Москва") +
+                       "&description=" + urlEncode("Аудит, внедрение DLP и SIEM, сопровождение") +
+                       "&website=integrator.ru&country_id=1&products=1&products=2&services=3";
+    for (size_t i = 0; i < licenses; i++) {
+        body += "&license_number%5B%5D=" + urlEncode("Л024-00107-00/" + std::to_string(100000 + i)) +
+                "&license_issued_by%5B%5D=" + urlEncode("ФСТЭК России");
+    }
+    return makeRequest("/update", body);
+}
+
+// Как сервер до арены: запрос копируется из буфера чтения, тело - ещё раз
+void legacyRate(const char* buffer) {
+    std::string request(buffer);
+    size_t bodyStart = request.find("\r\n\r\n");
+    std::string body = request.substr(bodyStart + 4);
+    auto params = parsePostData(body);
+    std::string comment = params["comment"];
+    sink += getCookie(request, "session_id").size() + std::stoi(params["id"]) + std::stoi(params["rating"]) + comment.size();
+}
+
+void legacyUpdate(const char* buffer) {
+    std::string request(buffer);
+    size_t bodyStart = request.find("\r\n\r\n");
+    FormData form(std::string_view(request).substr(bodyStart + 4));
+    sink += getCookie(request, "session_id").size() + form.getAll("license_number[]").size();
+}
+
+void arenaRate(const char* buffer, size_t size, RequestArena& arena) {
+    arena.reset();
+    std::string_view request(buffer, size);
+    FormData form(request.substr(request.find("\r\n\r\n") + 4), arena.memory());
+    int id = 0;
+    int rating = 0;
+    parseFormInt(form.get("id"), id);
+    parseFormInt(form.get("rating"), rating);
+    sink += getCookie(request, "session_id").size() + id + rating + form.get("comment").size();
+}
+
+void arenaUpdate(const char* buffer, size_t size, RequestArena& arena) {
+    arena.reset();
+    std::string_view request(buffer, size);
+    FormData form(request.substr(request.find("\r\n\r\n") + 4), arena.memory());
+    sink += getCookie(request, "session_id").size() + form.getAll("license_number[]").size();
+}
+
+std::vector<Integrator> makeIntegrators(size_t count) {
+    std::vector<Integrator> result;
+    for (size_t i = 0; i < count; i++) {
+        Integrator integrator;
+        integrator.id = static_cast<int>(i + 1);
+        integrator.name = "ООО «Интегратор безопасности №" + std::to_string(i + 1) + "»";
+        integrator.city = "Москва";
+        integrator.description = "Комплексная защита информации: аудит, внедрение DLP и SIEM, \"сопровождение\"";
+        integrator.website = "integrator" + std::to_string(i + 1) + ".ru";
+        integrator.countryId = 1;
+        integrator.productIds = {1, 2};
+        integrator.serviceIds = {3};
+        for (int l = 0; l < 3; l++) {
+            integrator.licenses.push_back({"Л024-00107-00/" + std::to_string(100000 + l), "ФСТЭК России"});
+        }
+        integrator.certificates.push_back({"Сертификат соответствия", "ФСБ России", "СФ/124-" + std::to_string(i)});
+        result.push_back(integrator);
+    }
+    return result;
+}
+
+struct Result {
+    double allocationsPerRequest;
+    double bytesPerRequest;
+    double nsPerRequest;
+    long maxRssKb;
+};
+
+// Вариант выполняется в отдельном процессе, чтобы пиковый RSS относился только к нему
+Result run(size_t requests, const std::function<void()>& handle) {
+    int resultPipe[2];
+    if (pipe(resultPipe) < 0) return {-1, -1, -1, -1};
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(resultPipe[0]);
+        handle();   // прогрев: первые выделения арены и буферов
+        size_t startAllocations = allocations;
+        size_t startBytes = allocatedBytes;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < requests; i++) handle();
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        Result result = {static_cast<double>(allocations - startAllocations) / requests,
+                         static_cast<double>(allocatedBytes - startBytes) / requests,
+                         elapsed / requests, usage.ru_maxrss};
+        if (write(resultPipe[1], &result, sizeof(result)) < 0) _exit(1);
+        _exit(0);
+    }
+    close(resultPipe[1]);
+    Result result = {-1, -1, -1, -1};
+    if (pid < 0 || read(resultPipe[0], &result, sizeof(result)) != sizeof(result)) result.nsPerRequest = -1;
+    close(resultPipe[0]);
+    if (pid > 0) waitpid(pid, nullptr, 0);
+    return result;
+}
+
+void report(const std::string& name, const Result& result) {
+    size_t width = 0;
+    for (unsigned char c : name) {
+        if ((c & 0xC0) != 0x80) width++;
+    }
+    std::cout << name << std::string(width < 34 ? 34 - width : 1, ' ') << std::fixed << std::setprecision(1)
+              << std::setw(8) << result.allocationsPerRequest << " new/запрос"
+              << std::setw(10) << result.bytesPerRequest << " Б/запрос"
+              << std::setw(10) << result.nsPerRequest << " нс"
+              << std::setw(8) << result.maxRssKb << " КБ RSS" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t requests = argc > 1 ? std::max(1, std::atoi(argv[1])) : 200000;
+
+    std::string rate = makeRateRequest();
+    std::string update = makeUpdateRequest(10);
+    std::vector<Integrator> integrators = makeIntegrators(20);
+    Dictionary countries({{1, "Россия"}});
+    Dictionary products({{1, "DLP"}, {2, "SIEM"}});
+    Dictionary services({{3, "Аудит безопасности"}});
+
+    std::cout << "Выделения памяти на запрос (" << requests << " запросов)" << std::endl;
+    report("POST /rate, прежний разбор", run(requests, [&] { legacyRate(rate.c_str()); }));
+    report("POST /rate, арена", run(requests, [&] {
+        static RequestArena arena;
+        arenaRate(rate.data(), rate.size(), arena);
+    }));
+    report("POST /update, прежний разбор", run(requests, [&] { legacyUpdate(update.c_str()); }));
+    report("POST /update, арена", run(requests, [&] {
+        static RequestArena arena;
+        arenaUpdate(update.data(), update.size(), arena);
+    }));
+    report("главная, 20 интеграторов", run(requests / 100 + 1, [&] {
+        sink += generateMainPage(integrators, true, true, "admin", "0123456789abcdef", {"Москва"}, countries, products,
+                                 services, "", "", "", "", "", "", "name_asc", 1, 1, 20, {}, {}, 20).size();
+    }));
+    return 0;
+}
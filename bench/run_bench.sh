@@ -0,0 +1,35 @@
+#!/bin/sh
+# Сквозной замер: запускает собранный сервер (нужен PostgreSQL с настройками
+# из DB_* переменных), прогоняет build/loadgen и останавливает сервер.
+# Дополнительные аргументы передаются loadgen, например:
+#   make bench BENCH_ARGS="--connections 256 --duration 60"
+set -e
+
+BUILD_DIR=${BUILD_DIR:-build}
+
+# Число соединений loadgen (--connections, по умолчанию 64) плюс служебное
+CONNECTIONS=64
+PREVIOUS=
+for ARG in "$@"; do
+    if [ "$PREVIOUS" = "--connections" ]; then
+        CONNECTIONS=$ARG
+    fi
+    PREVIOUS=$ARG
+done
+CONNECTIONS=$((CONNECTIONS + 1))
+
+# Все соединения loadgen идут с одного адреса: бюджеты на IP по умолчанию
+# отклонили бы почти всю нагрузку (429), поэтому ограничение по клиентам
+# выключено, а лимит одновременных запросов и очередь хеширования паролей
+# не меньше числа соединений. Любую из переменных можно задать явно.
+# Журнал доступа на каждый запрос искажает замер; по умолчанию только предупреждения
+RATE_LIMIT_SLOTS=${RATE_LIMIT_SLOTS:-0} \
+MAX_IN_FLIGHT=${MAX_IN_FLIGHT:-$CONNECTIONS} \
+PASSWORD_QUEUE=${PASSWORD_QUEUE:-$CONNECTIONS} \
+LOG_LEVEL=${LOG_LEVEL:-warn} "./$BUILD_DIR/server" > "$BUILD_DIR/bench_server.log" 2>&1 &
+SERVER_PID=$!
+trap 'kill $SERVER_PID 2>/dev/null; wait $SERVER_PID 2>/dev/null || true' EXIT INT TERM
+
+"./$BUILD_DIR/loadgen" --port 8080 \
+    --label "$(git rev-parse --short HEAD 2>/dev/null || echo unknown)" \
+    --output "$BUILD_DIR/bench_results.json" "$@"
@@ -0,0 +1,312 @@
+// Микробенчмарки ядер из text_kernels.cpp в сравнении с прежними побайтовыми
+// реализациями urlDecode, htmlEscape, parsePostData и escapeForJS из server.cpp.
+// Перед замерами результаты всех реализаций сверяются между собой.
+//
+// Запуск: make microbench
+
+#include "text_kernels.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <string>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+
+namespace legacy {
+
+std::string urlDecode(const std::string& str) {
+    std::string result;
+    for (size_t i = 0; i < str.length(); i++) {
+        if (str[i] == '%' && i + 2 < str.length()) {
+            int value;
+            std::istringstream(str.substr(i + 1, 2)) >> std::hex >> value;
+            result += static_cast<char>(value);
+            i += 2;
+        } else if (str[i] == '+') {
+            result += ' ';
+        } else {
+            result += str[i];
+        }
+    }
+    return result;
+}
+
+std::string htmlEscape(const std::string& str) {
+    std::string result;
+    for (char c : str) {
+        if (c == '&') {
+            result += "&amp;";
+        } else if (c == '<') {
+            result += "&lt;";
+        } else if (c == '>') {
+            result += "&gt;";
+        } else if (c == '"') {
+            result += "&quot;";
+        } else if (c == '\'') {
+            result += "&#39;";
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+std::map<std::string, std::string> parsePostData(const std::string& data) {
+    std::map<std::string, std::string> params;
+    std::istringstream stream(data);
+    std::string pair;
+
+    while (std::getline(stream, pair, '&')) {
+        size_t pos = pair.find('=');
+        if (pos != std::string::npos) {
+            std::string key = urlDecode(pair.substr(0, pos));
+            std::string value = urlDecode(pair.substr(pos + 1));
+            params[key] = value;
+        }
+    }
+    return params;
+}
+
+void escapeForJS(std::string& str) {
+    size_t pos = 0;
+    while ((pos = str.find("\\", pos)) != std::string::npos) {
+        str.replace(pos, 1, "\\\\");
+        pos += 2;
+    }
+    pos = 0;
+    while ((pos = str.find("\"", pos)) != std::string::npos) {
+        str.replace(pos, 1, "\\\"");
+        pos += 2;
+    }
+    pos = 0;
+    while ((pos = str.find("\n", pos)) != std::string::npos) {
+        str.replace(pos, 1, "\\n");
+        pos += 2;
+    }
+    pos = 0;
+    while ((pos = str.find("\r", pos)) != std::string::npos) {
+        str.replace(pos, 1, "");
+    }
+}
+
+} // namespace legacy
+
+namespace current {
+
+std::string urlDecode(const std::string& str) {
+    std::string result;
+    result.reserve(str.size());
+    appendUrlDecoded(result, str.data(), str.size());
+    return result;
+}
+
+std::string htmlEscape(const std::string& str) {
+    std::string result;
+    result.reserve(str.size() + str.size() / 8);
+    appendHtmlEscaped(result, str.data(), str.size());
+    return result;
+}
+
+// Та же логика, что и в server.cpp
+std::map<std::string, std::string> parsePostData(const std::string& data) {
+    std::map<std::string, std::string> params;
+    const char* p = data.data();
+    size_t remaining = data.size();
+    while (remaining > 0) {
+        const char* amp = static_cast<const char*>(memchr(p, '&', remaining));
+        size_t pairLength = amp ? static_cast<size_t>(amp - p) : remaining;
+        const char* eqPos = static_cast<const char*>(memchr(p, '=', pairLength));
+        if (eqPos != nullptr) {
+            size_t eq = eqPos - p;
+            std::string key;
+            appendUrlDecoded(key, p, eq);
+            std::string& value = params[key];
+            value.clear();
+            appendUrlDecoded(value, p + eq + 1, pairLength - eq - 1);
+        }
+        if (pairLength == remaining) break;
+        p += pairLength + 1;
+        remaining -= pairLength + 1;
+    }
+    return params;
+}
+
+void escapeForJS(std::string& str) {
+    if (!needsJsEscape(str.data(), str.size())) return;
+    std::string escaped;
+    escaped.reserve(str.size() + 8);
+    appendJsEscaped(escaped, str.data(), str.size());
+    str.swap(escaped);
+}
+
+} // namespace current
+
+namespace {
+
+volatile size_t sink = 0;
+
+std::string repeat(const std::string& piece, size_t targetSize) {
+    std::string result;
+    while (result.size() < targetSize) {
+        result += piece;
+    }
+    return result;
+}
+
+std::string percentEncode(const std::string& value) {
+    static const char* hex = "0123456789ABCDEF";
+    std::string result;
+    for (unsigned char c : value) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.') {
+            result += static_cast<char>(c);
+        } else if (c == ' ') {
+            result += '+';
+        } else {
+            result += '%';
+            result += hex[c >> 4];
+            result += hex[c & 15];
+        }
+    }
+    return result;
+}
+
+// Тело POST /add с заданным числом лицензий
+std::string makeFormBody(size_t licenses) {
+    std::string body = "name=" + percentEncode("ООО «Защита Информации»") +
+                       "&city=" + percentEncode("Санкт-Петербург") +
+                       "&description=" + percentEncode(repeat("Комплексная защита инфраструктуры, аудит и сопровождение. ", 300)) +
+                       "&website=" + percentEncode("https://example.ru/about?lang=ru") +
+                       "&country_id=1";
+    for (size_t i = 0; i < licenses; i++) {
+        body += "&license_number=" + percentEncode("Л024-00107-00/00" + std::to_string(i)) +
+                "&license_issued=" + percentEncode("ФСТЭК России");
+    }
+    return body;
+}
+
+struct Input {
+    std::string name;
+    std::string data;
+};
+
+std::vector<Input> makeTextInputs() {
+    return {
+        {"ascii-plain", repeat("Integrator provides security audit and monitoring services. ", 4096)},
+        {"cyrillic-plain", repeat("Интегратор оказывает услуги по аудиту и мониторингу безопасности. ", 4096)},
+        {"mixed-sparse", repeat("Компания \"Щит\" & партнёры: <SOC>, аудит 'под ключ'.\nТелефон: 8-800\\100\r\n", 4096)},
+        {"short-field", "ООО \"Альфа-Системс\""},
+        {"dense", repeat("<&>\"'\\\n\r", 1024)},
+    };
+}
+
+// Возвращает среднее время одного вызова в наносекундах
+double measure(const std::function<void()>& body) {
+    using clock = std::chrono::steady_clock;
+    size_t iterations = 1;
+    for (;;) {
+        auto start = clock::now();
+        for (size_t i = 0; i < iterations; i++) body();
+        double elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        if (elapsed > 2e8 || iterations > (1u << 30)) {
+            return elapsed / iterations;
+        }
+        iterations *= elapsed < 1e7 ? 8 : 2;
+    }
+}
+
+void report(const std::string& kernel, const std::string& input, size_t bytes, const std::string& impl, double ns, double baseline) {
+    double mbPerSec = bytes / ns * 1e9 / (1024.0 * 1024.0);
+    std::cout << std::left << std::setw(14) << kernel << std::setw(16) << input
+              << std::setw(12) << impl << std::right
+              << std::setw(12) << std::fixed << std::setprecision(1) << ns << " нс"
+              << std::setw(10) << std::setprecision(0) << mbPerSec << " МБ/с"
+              << std::setw(8) << std::setprecision(1) << baseline / ns << "x" << std::endl;
+}
+
+bool check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "Результаты не совпадают: " << what << std::endl;
+    }
+    return ok;
+}
+
+std::vector<TextKernelLevel> supportedLevels() {
+    std::vector<TextKernelLevel> levels;
+    for (TextKernelLevel level : {TextKernelLevel::Scalar, TextKernelLevel::SSE42, TextKernelLevel::AVX2}) {
+        if (setTextKernelLevel(level)) {
+            levels.push_back(level);
+        }
+    }
+    return levels;
+}
+
+} // namespace
+
+int main() {
+    std::vector<TextKernelLevel> levels = supportedLevels();
+    std::vector<Input> textInputs = makeTextInputs();
+    std::vector<Input> formInputs = {
+        {"form-1", makeFormBody(1)},
+        {"form-100", makeFormBody(100)},
+        {"query-short", "name=%D0%90%D0%BB%D1%8C%D1%84%D0%B0&city=Moscow&page=2"},
+    };
+
+    // Сверка с прежними реализациями на всех уровнях
+    bool ok = true;
+    for (TextKernelLevel level : levels) {
+        setTextKernelLevel(level);
+        std::string levelName = textKernelName(level);
+        for (const auto& input : textInputs) {
+            ok &= check(legacy::htmlEscape(input.data) == current::htmlEscape(input.data), "htmlEscape/" + input.name + "/" + levelName);
+            std::string a = input.data, b = input.data;
+            legacy::escapeForJS(a);
+            current::escapeForJS(b);
+            ok &= check(a == b, "escapeForJS/" + input.name + "/" + levelName);
+        }
+        for (const auto& input : formInputs) {
+            ok &= check(legacy::urlDecode(input.data) == current::urlDecode(input.data), "urlDecode/" + input.name + "/" + levelName);
+            ok &= check(legacy::parsePostData(input.data) == current::parsePostData(input.data), "parsePostData/" + input.name + "/" + levelName);
+        }
+    }
+    if (!ok) {
+        return 1;
+    }
+
+    std::cout << "Доступные ядра:";
+    for (TextKernelLevel level : levels) std::cout << " " << textKernelName(level);
+    std::cout << std::endl << std::endl;
+
+    auto run = [&](const std::string& kernel, const std::vector<Input>& inputs,
+                   const std::function<void(const std::string&)>& legacyFn,
+                   const std::function<void(const std::string&)>& currentFn) {
+        for (const auto& input : inputs) {
+            double baseline = measure([&] { legacyFn(input.data); });
+            report(kernel, input.name, input.data.size(), "legacy", baseline, baseline);
+            for (TextKernelLevel level : levels) {
+                setTextKernelLevel(level);
+                double ns = measure([&] { currentFn(input.data); });
+                report(kernel, input.name, input.data.size(), textKernelName(level), ns, baseline);
+            }
+        }
+        std::cout << std::endl;
+    };
+
+    run("htmlEscape", textInputs,
+        [](const std::string& s) { sink += legacy::htmlEscape(s).size(); },
+        [](const std::string& s) { sink += current::htmlEscape(s).size(); });
+    run("escapeForJS", textInputs,
+        [](const std::string& s) { std::string copy = s; legacy::escapeForJS(copy); sink += copy.size(); },
+        [](const std::string& s) { std::string copy = s; current::escapeForJS(copy); sink += copy.size(); });
+    run("urlDecode", formInputs,
+        [](const std::string& s) { sink += legacy::urlDecode(s).size(); },
+        [](const std::string& s) { sink += current::urlDecode(s).size(); });
+    run("parsePostData", formInputs,
+        [](const std::string& s) { sink += legacy::parsePostData(s).size(); },
+        [](const std::string& s) { sink += current::parsePostData(s).size(); });
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+#ifndef API_H
+#define API_H
+
+#include "catalog.h"
+#include "json_writer.h"
+#include <string>
+#include <string_view>
+
+// JSON API каталога для внутренних инструментов:
+//   GET /api/integrators                 - фильтры, сортировка и страницы как у GET /,
+//                                          включая per_page
+//   GET /api/integrators/{id}
+//   GET /api/integrators/{id}/ratings
+//   GET /api/countries, /api/products, /api/services
+// Ответы сериализуются JsonWriter из структур прямо в буфер ResponseStream;
+// длинные списки уходят кусками (chunked) по мере записи.
+
+enum class ApiEndpoint {
+    None,
+    Integrators,
+    Integrator,
+    Ratings,
+    Countries,
+    Products,
+    Services
+};
+
+// Разбор пути запроса GET /api/...; id - для Integrator и Ratings
+ApiEndpoint parseApiEndpoint(std::string_view request, int& id);
+
+// Названия страны, продуктов и услуг берутся из справочников catalog
+void writeIntegratorJson(JsonWriter& json, const Integrator& integrator, const CatalogSnapshot& catalog,
+                         const RatingStats* stats);
+void writeRatingJson(JsonWriter& json, const Rating& rating);
+
+// Выполняет запрос к API и отправляет ответ в сокет; возвращает число отправленных байт.
+// searchIndexAvailable - как у parseListingQuery; validatorHeaders (ETag и т.п.)
+// добавляются к успешным ответам.
+size_t serveApiRequest(int clientSocket, std::string_view request, ApiEndpoint endpoint, int id,
+                       Database& db, Catalog& catalog, bool searchIndexAvailable,
+                       const std::string& validatorHeaders = "");
+
+#endif
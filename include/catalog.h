@@ -0,0 +1,67 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "database.h"
+#include "search_index.h"
+#include "catalog_columns.h"
+#include "dictionary.h"
+#include "metrics.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// Снимок каталога: интеграторы, справочники (интеграторы ссылаются на них
+// по id), поисковый индекс и колонки для фильтрации и сортировки.
+// После построения не изменяется.
+struct CatalogSnapshot {
+    std::vector<Integrator> integrators;   // в порядке GET_ALL_INTEGRATORS (по названию)
+    std::vector<std::string> cities;
+    Dictionary countries;
+    Dictionary products;
+    Dictionary services;
+    std::unordered_map<int, uint32_t> rowById;
+    SearchIndex index;
+    CatalogColumns columns;
+
+    const Integrator* findById(int id) const;
+};
+
+// Оценки интеграторов снимка каталога при одной версии оценок и готовые
+// порядки по рейтингу. После построения не изменяется.
+struct RatingSnapshot {
+    std::shared_ptr<const CatalogSnapshot> catalog;
+    std::map<int, RatingStats> stats;
+    std::vector<double> averages;   // по номеру строки снимка, 0 - оценок нет
+    CatalogOrdering byRatingDesc;
+    CatalogOrdering byRatingAsc;
+};
+
+// Кэш каталога в памяти процесса. Перестраивается при первом обращении
+// после invalidate(), которое вызывается после изменений каталога, или после
+// смены версии каталога (DataVersions) - например, изменения из другого цикла.
+// Общий для всех циклов обработки: перестраивает снимок один из них, остальные
+// ждут на мьютексе и получают готовый.
+class Catalog {
+private:
+    std::mutex mutex;
+    std::shared_ptr<const CatalogSnapshot> snapshot;
+    bool dirty = true;
+    uint64_t snapshotVersion = 0;   // версия каталога, прочитанная до загрузки снимка
+    CacheMetrics& metrics = MetricsRegistry::instance().cache("catalog");
+
+    std::mutex ratingsMutex;
+    std::shared_ptr<const RatingSnapshot> ratingSnapshot;
+    uint64_t ratingsVersion = 0;
+    CacheMetrics& ratingsMetrics = MetricsRegistry::instance().cache("ratings");
+
+public:
+    std::shared_ptr<const CatalogSnapshot> get(Database& db);
+    void invalidate();
+    // Оценки для snapshot; перечитываются при смене версии оценок (DataVersions)
+    // или снимка. Порядки по рейтингу при этом не сортируются заново, если
+    // изменились средние немногих интеграторов: эти строки переставляются.
+    std::shared_ptr<const RatingSnapshot> ratings(Database& db, const std::shared_ptr<const CatalogSnapshot>& snapshot);
+};
+
+#endif
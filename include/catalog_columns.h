@@ -0,0 +1,82 @@
+#ifndef CATALOG_COLUMNS_H
+#define CATALOG_COLUMNS_H
+
+#include "database.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Порядок выдачи списка интеграторов (параметр sort, кроме relevance)
+enum class CatalogOrder {
+    NameAsc,
+    NameDesc,
+    CityAsc,
+    CityDesc,
+    RatingDesc,
+    RatingAsc
+};
+
+// Строки снимка, заранее упорядоченные для одного значения sort
+struct CatalogOrdering {
+    std::vector<uint32_t> rows;        // строки в порядке выдачи
+    std::vector<uint32_t> positions;   // место строки в rows (обратная перестановка)
+};
+
+// Поля каталога, по которым фильтруют и сортируют, в виде колонок: по элементу
+// на строку снимка, значения лежат подряд, строки при сравнении не читаются.
+// Названия и города упорядочены по ключам сортировки (collation.h) - так же,
+// как ORDER BY в запросах к БД. Города интернированы в номера, выданные в этом
+// порядке, так что сравнение номеров совпадает со сравнением названий. Название
+// заменено местом строки в порядке по названию (без повторов: равные названия -
+// по номеру строки, то есть в порядке GET_ALL_INTEGRATORS).
+//
+// Порядки по названию и городу строятся вместе с колонками, порядки по рейтингу
+// - по средним оценкам (см. RatingSnapshot в catalog.h). Сортировка идёт по
+// 64-битным ключам: старшая половина - основной признак (город, рейтинг),
+// младшая - место по названию. Оно же и второй признак сортировки, и способ
+// вернуться от ключа к строке.
+class CatalogColumns {
+private:
+    std::vector<uint32_t> cityIds;
+    CatalogOrdering byName;
+    CatalogOrdering byNameDesc;
+    CatalogOrdering byCity;
+    CatalogOrdering byCityDesc;
+    std::unordered_map<std::string, uint32_t> cityIdByName;
+
+    void sortOrdering(CatalogOrdering& ordering, CatalogOrder order, const std::vector<double>& averages) const;
+
+public:
+    static const uint32_t NO_CITY = UINT32_MAX;
+
+    void build(const std::vector<Integrator>& integrators);
+    size_t size() const { return cityIds.size(); }
+
+    // NO_CITY - такого города в каталоге нет
+    uint32_t cityId(const std::string& city) const;
+    // Оставляет строки с городом cityId, порядок сохраняется
+    void filterByCity(std::vector<uint32_t>& rows, uint32_t cityId) const;
+
+    // Готовый порядок по названию или городу; для RatingDesc и RatingAsc
+    // порядок строит buildRatingOrdering
+    const CatalogOrdering& ordering(CatalogOrder order) const;
+    // averages - средняя оценка по номеру строки (0 - оценок нет).
+    // Равные по рейтингу - по названию.
+    void buildRatingOrdering(CatalogOrdering& ordering, CatalogOrder order, const std::vector<double>& averages) const;
+    // Порядок, построенный по прежним средним, у которых изменились только
+    // changedRows: они вынимаются и вливаются обратно по новым averages, O(n + k log k)
+    void updateRatingOrdering(CatalogOrdering& ordering, CatalogOrder order, const std::vector<double>& averages,
+                              const std::vector<uint32_t>& changedRows) const;
+
+    size_t memoryUsage() const;
+};
+
+// Строки [start, start + count) выдачи: rows (без повторов, в любом порядке),
+// расставленные по ordering. Если rows - весь снимок, это срез ordering.rows;
+// иначе ordering обходится по битовой маске rows до заполнения страницы, а
+// для малой доли строк сортируются только их места в ordering.
+void selectOrderedPage(const CatalogOrdering& ordering, const std::vector<uint32_t>& rows, size_t start, size_t count,
+                       std::vector<uint32_t>& page);
+
+#endif
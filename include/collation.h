@@ -0,0 +1,25 @@
+#ifndef COLLATION_H
+#define COLLATION_H
+
+#include <string>
+#include <string_view>
+
+// Ключи сортировки названий для русского и английского: ключи сравниваются
+// побайтно (memcmp, std::string::compare), и этот порядок совпадает с
+// ORDER BY collation_key(name) COLLATE "C" в БД.
+//
+// Ключ состоит из трёх уровней, разделённых байтом 0x01:
+//   1. буквы без регистра, ё = е: латиница, затем кириллица по алфавиту;
+//   2. то же, но ё после е;
+//   3. регистр: строчная буква раньше прописной.
+// Остальные символы (цифры, пробелы, знаки) входят во все уровни как есть и
+// сравниваются по коду символа. Правила собраны в одну таблицу: из неё же
+// строится SQL-функция (collationKeyFunctionSql), поэтому порядок в памяти и
+// в БД не зависит от локали сервера PostgreSQL.
+std::string collationKey(std::string_view text);
+void appendCollationKey(std::string& key, std::string_view text);
+
+// CREATE OR REPLACE FUNCTION collation_key(text) через translate() по той же таблице
+std::string collationKeyFunctionSql();
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef DATA_VERSIONS_H
+#define DATA_VERSIONS_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Области данных с отдельными версиями
+enum class DataScope {
+    Catalog,   // интеграторы, лицензии, сертификаты, продукты и услуги интеграторов
+    Ratings    // оценки и отзывы
+};
+
+// Версии данных процесса для условных GET. Изменяющие методы Database
+// увеличивают версию своей области после записи в БД, поэтому ответ,
+// собранный после чтения версии, не старее её. Изменения, сделанные другими
+// процессами, не видны - как и для кэша каталога.
+class DataVersions {
+private:
+    std::atomic<uint64_t> catalogVersion{1};
+    std::atomic<uint64_t> ratingsVersion{1};
+    std::atomic<int64_t> modifiedAt;   // unix-время последнего изменения
+    std::string epoch;                 // случайная метка процесса: версии нового процесса начинаются заново
+
+    DataVersions();
+
+public:
+    static DataVersions& instance();
+
+    void bump(DataScope scope);
+    uint64_t catalog() const { return catalogVersion.load(std::memory_order_acquire); }
+    uint64_t ratings() const { return ratingsVersion.load(std::memory_order_acquire); }
+    int64_t lastModified() const { return modifiedAt.load(std::memory_order_acquire); }
+
+    // Слабый ETag W/"epoch.каталог.оценки.хеш": variant - всё, кроме данных,
+    // от чего зависит ответ (путь с параметрами, роль, имя пользователя)
+    std::string weakETag(std::string_view variant) const;
+};
+
+// Совпадает ли заголовок If-None-Match с etag (слабое сравнение, список через запятую, "*")
+bool etagMatches(std::string_view ifNoneMatch, std::string_view etag);
+
+#endif
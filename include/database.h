@@ -1,6 +1,7 @@
 #ifndef DATABASE_H
 #define DATABASE_H
 
+#include <optional>
 #include <string>
 #include <vector>
 #include <map>
@@ -23,11 +24,11 @@ struct Integrator {
     std::string city;
     std::string description;
     std::string website;
-    std::string country;
+    int countryId = 0;                // 0 - страна не указана
     std::vector<License> licenses;
     std::vector<Certificate> certificates;
-    std::string products;
-    std::string services;
+    std::vector<int> productIds;      // по возрастанию; названия - в справочниках снимка каталога
+    std::vector<int> serviceIds;
 };
 
 struct User {
@@ -44,6 +45,13 @@ struct Session {
     bool isAdmin;
 };
 
+// Запись об отзыве подписанного токена: tokenId или все токены userId до revokedAt
+struct SessionRevocation {
+    std::string tokenId;
+    int userId;
+    long long revokedAt;
+};
+
 struct Rating {
     int id;
     int integratorId;
@@ -54,6 +62,8 @@ struct Rating {
     std::string createdAt;
 };
 
+struct QueryMetrics;
+
 struct RatingStats {
     double average = 0.0;
     int count = 0;
@@ -64,8 +74,15 @@ private:
     PGconn* conn;
     std::string connectionString;
     std::map<std::string, std::string> queries;
+    std::map<std::string, QueryMetrics*> queryMetrics;
+    bool searchIndexAvailable;
     
-    bool loadQueries(const std::string& filename);
+    // Выполнение именованного запроса из queries.sql с учётом метрик.
+    // Наличие запроса проверяет вызывающий метод.
+    PGresult* execNamed(const std::string& key, int paramCount, const char* const* paramValues);
+    bool initializeSearchIndex();
+    // Удаление пачки просроченных строк запросом key; число строк или -1
+    int deleteExpiredBatch(const std::string& key, int batchSize);
 
 public:
     Database(const std::string& host, const std::string& port, 
@@ -73,13 +90,22 @@ public:
              const std::string& password);
     ~Database();
     
-    bool connect();
+    // initializeData=false - только соединение (для фоновых потоков со своим Database)
+    bool connect(bool initializeData = true);
     void disconnect();
+    // Разбор файла с блоками "-- QUERY: ИМЯ"; вызывается из конструктора
+    bool loadQueries(const std::string& filename);
+    const std::string& getConnectionString() const { return connectionString; }
+    bool isConnected() const { return conn && PQstatus(conn) == CONNECTION_OK; }
     
     // Методы для интеграторов
     std::vector<Integrator> getAllIntegrators();
     std::vector<Integrator> getIntegratorsByCity(const std::string& city);
     std::vector<Integrator> searchIntegratorsByCity(const std::string& cityPattern);
+    // Полнотекстовый поиск (tsvector): id в порядке релевантности
+    std::vector<int> searchIntegratorIds(const std::string& textQuery);
+    // Известно только соединению, выполнившему initializeDefaultData
+    bool isSearchIndexAvailable() const { return searchIndexAvailable; }
     std::vector<std::string> getAllCities();
     bool addIntegrator(const std::string& name, const std::string& city, 
                       const std::string& description);
@@ -94,18 +120,30 @@ public:
     bool deleteIntegrator(int id);
     
     // Методы для пользователей
-    User* getUserByUsername(const std::string& username);
-    bool createUser(const std::string& username, const std::string& password, bool isAdmin = false);
+    // nullopt - пользователя нет или ошибка запроса
+    std::optional<User> getUserByUsername(const std::string& username);
+    // passwordHash - строка из hashPassword (password_hasher.h)
+    bool createUser(const std::string& username, const std::string& passwordHash, bool isAdmin = false);
+    bool updatePasswordHash(int userId, const std::string& passwordHash);
     
     // Методы для сессий
     bool createSession(const std::string& sessionId, int userId);
-    Session* getSession(const std::string& sessionId);
+    std::optional<Session> getSession(const std::string& sessionId);
     bool deleteSession(const std::string& sessionId);
+    // Удаляет сессии из БД и отзывает подписанные токены пользователя
     bool deleteUserSessions(int userId);
+    bool revokeSessionToken(const std::string& tokenId, int userId, long long expiresAt);
+    // false - ошибка запроса; revocations тогда не использовать
+    bool getSessionRevocations(std::vector<SessionRevocation>& revocations);
+    // Очистка просроченных строк пачками до batchSize; число удалённых или -1
+    int deleteExpiredSessions(int batchSize);
+    int deleteExpiredSessionRevocations(int batchSize);
 
     // Методы для рейтингов и отзывов
     bool addOrUpdateRating(int integratorId, int userId, int ratingValue, const std::string& comment);
     std::vector<Rating> getRatingsByIntegrator(int integratorId);
+    // Отзывы нескольких интеграторов одним запросом (страница каталога)
+    std::map<int, std::vector<Rating>> getRatingsByIntegrators(const std::vector<int>& integratorIds);
     std::map<int, RatingStats> getRatingStats();
     
     // Методы для лицензий и сертификатов
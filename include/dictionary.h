@@ -0,0 +1,35 @@
+#ifndef DICTIONARY_H
+#define DICTIONARY_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Справочник (страны, продукты, услуги) снимка каталога: каждое название
+// хранится один раз, интеграторы ссылаются на записи по id. Поиск по id -
+// обращение к массиву, индексированному id (id из SERIAL идут плотно).
+class Dictionary {
+private:
+    std::vector<std::pair<int, std::string>> entries;   // в порядке справочника из БД
+    std::vector<int32_t> slotById;                      // id -> индекс в entries, -1 - нет
+
+public:
+    Dictionary() = default;
+    explicit Dictionary(std::vector<std::pair<int, std::string>> entries);
+
+    const std::vector<std::pair<int, std::string>>& all() const { return entries; }
+    size_t size() const { return entries.size(); }
+
+    // nullptr - такого id нет
+    const std::string* find(int id) const {
+        if (id < 0 || static_cast<size_t>(id) >= slotById.size() || slotById[id] < 0) return nullptr;
+        return &entries[slotById[id]].second;
+    }
+    // Пустая строка, если такого id нет
+    const std::string& name(int id) const;
+
+    size_t memoryUsage() const;
+};
+
+#endif
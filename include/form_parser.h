@@ -0,0 +1,62 @@
+#ifndef FORM_PARSER_H
+#define FORM_PARSER_H
+
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Все значения одного поля формы в порядке следования в теле запроса
+class FormValues {
+private:
+    const std::string_view* first;
+    const std::string_view* last;
+
+public:
+    FormValues(const std::string_view* first, const std::string_view* last) : first(first), last(last) {}
+    const std::string_view* begin() const { return first; }
+    const std::string_view* end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+    // Пустая строка, если значения с таким номером нет
+    std::string_view operator[](size_t i) const { return i < size() ? first[i] : std::string_view(); }
+};
+
+// Разбор тела application/x-www-form-urlencoded за один проход.
+// Ключи и значения - string_view в буфер тела; если в них есть %XX или '+',
+// они декодируются во внутренний буфер формы, выделяемый один раз.
+// Повторяющиеся поля (license_number[] и т.п.) сохраняют все значения.
+// Тело запроса должно жить не меньше, чем FormData. Служебные массивы и
+// буфер декодирования берутся из memory (в сервере - арена запроса).
+class FormData {
+private:
+    struct Field {
+        std::string_view key;
+        std::string_view value;
+        size_t position;   // номер в теле: порядок значений одного поля
+    };
+
+    std::pmr::vector<std::string_view> keys;     // отсортированы, равные ключи подряд
+    std::pmr::vector<std::string_view> values;   // в том же порядке, что и keys
+    std::pmr::string decoded;
+
+    std::string_view decode(std::string_view raw);
+
+public:
+    explicit FormData(std::string_view body, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    // Значения ссылаются на внутренний буфер, копирование их бы инвалидировало
+    FormData(const FormData&) = delete;
+    FormData& operator=(const FormData&) = delete;
+
+    FormValues getAll(std::string_view key) const;
+    // Последнее значение поля или пустая строка: при повторе поля побеждает
+    // последнее, как и в прежнем parsePostData (присваивание в std::map)
+    std::string_view get(std::string_view key) const;
+    bool has(std::string_view key) const { return !getAll(key).empty(); }
+    size_t fieldCount() const { return keys.size(); }
+};
+
+// Десятичное целое; false для пустой строки, лишних символов и переполнения
+bool parseFormInt(std::string_view value, int& result);
+
+#endif
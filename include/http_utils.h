@@ -0,0 +1,48 @@
+#ifndef HTTP_UTILS_H
+#define HTTP_UTILS_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+// Разбор и сборка HTTP: чистые функции без состояния, общие для сервера и
+// микробенчмарков (build/libinfosec.a)
+
+std::string urlDecode(const std::string& str);
+std::string urlEncode(const std::string& value);
+std::string htmlEscape(const std::string& str);
+std::string toLowerStr(const std::string& str);
+bool containsCaseInsensitive(const std::string& text, const std::string& pattern);
+
+// Тело application/x-www-form-urlencoded; при повторе ключа остаётся последнее значение
+std::map<std::string, std::string> parsePostData(const std::string& data);
+
+// Значение cookie из заголовков запроса, пусто если нет
+std::string getCookie(std::string_view headers, std::string_view name);
+// Значение заголовка запроса (имя без учёта регистра), пусто если нет
+std::string getHeader(std::string_view request, std::string_view name);
+// Цель запроса из стартовой строки: путь с параметрами
+std::string getRequestTarget(std::string_view request);
+// Декодированный параметр строки запроса из стартовой строки
+std::string getQueryParam(std::string_view request, std::string_view paramName);
+
+// "404 Not Found" и т.п. для стартовой строки ответа
+const char* httpStatusLine(int statusCode);
+
+// Дата для заголовков HTTP (IMF-fixdate)
+std::string formatHttpDate(int64_t unixSeconds);
+// Заголовки ETag, Last-Modified и Cache-Control для ответа, который клиент
+// должен перепроверять условным GET
+std::string cacheValidatorHeaders(const std::string& etag, int64_t lastModified);
+
+// extraHeaders - готовые строки заголовков с \r\n, например cacheValidatorHeaders
+std::string createHTTPResponse(const std::string& body, const std::string& setCookie = "",
+                               const std::string& extraHeaders = "");
+std::string createNotModifiedResponse(const std::string& validatorHeaders);
+std::string createJsonResponse(int statusCode, const std::string& body);
+std::string createRedirectResponse(const std::string& location);
+// 429 Too Many Requests или 503 Service Unavailable с Retry-After
+std::string createRetryLaterResponse(int statusCode, const std::string& body, int retryAfterSeconds);
+
+#endif
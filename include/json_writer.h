@@ -0,0 +1,50 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Потоковая запись JSON прямо в буфер ответа, без промежуточного дерева.
+// Запятые между элементами расставляет сам писатель; строки экранируются
+// по RFC 8259 (UTF-8 пишется как есть, управляющие символы - \uXXXX).
+// Вызывающий может забирать и очищать out между элементами (см. ResponseStream).
+//
+//   JsonWriter json(out);
+//   json.beginObject().key("id").value(7).key("name").value(name).endObject();
+class JsonWriter {
+private:
+    std::string& out;
+    uint64_t hasItems = 0;   // бит на уровень вложенности: на уровне уже есть элемент
+    int depth = 0;
+    bool afterKey = false;
+
+    void separate();
+    void writeString(std::string_view text);
+
+public:
+    // Глубже вложенность не поддерживается
+    static const int MAX_DEPTH = 64;
+
+    explicit JsonWriter(std::string& out) : out(out) {}
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+    JsonWriter& key(std::string_view name);
+
+    JsonWriter& value(std::string_view text);
+    // Без этой перегрузки строковый литерал выбрал бы value(bool)
+    JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+    JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+    JsonWriter& value(long long number);
+    JsonWriter& value(int number) { return value(static_cast<long long>(number)); }
+    JsonWriter& value(double number);
+    JsonWriter& value(bool flag);
+    JsonWriter& null();
+
+    int currentDepth() const { return depth; }
+};
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef LISTENERS_H
+#define LISTENERS_H
+
+#include <cstddef>
+
+// Слушающий TCP-сокет на всех адресах порта (0 - порт выберет ядро).
+// reusePort - SO_REUSEPORT: несколько сокетов одного порта, по сокету на цикл
+// обработки, ядро само распределяет между ними входящие соединения.
+// Возвращает дескриптор (FD_CLOEXEC) или -1.
+int openListener(int port, bool reusePort, int backlog);
+// Порт, к которому привязан сокет; 0 - ошибка
+int listenerPort(int fd);
+
+size_t cpuCount();
+// Закрепляет текущий поток за процессором (только Linux); false - не удалось
+bool pinCurrentThread(size_t cpu);
+
+#endif
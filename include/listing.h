@@ -0,0 +1,48 @@
+#ifndef LISTING_H
+#define LISTING_H
+
+#include "catalog.h"
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Интеграторов на странице по умолчанию и наибольшее значение per_page
+const int LISTING_PAGE_SIZE = 5;
+const int LISTING_MAX_PAGE_SIZE = 1000;
+
+// Параметры списка интеграторов из строки запроса; одинаковы для главной
+// страницы и /api/integrators
+struct ListingQuery {
+    std::string city;          // city - подстрока города
+    std::string filterCity;    // filter_city - точное совпадение
+    std::string name;
+    std::string text;          // q - описание, продукты, услуги
+    std::string product;       // id продукта, как в запросе
+    std::string service;
+    std::string sort;          // name_asc, name_desc, city_*, rating_*, relevance (только с useTextIndex)
+    int page = 1;
+    int pageSize = LISTING_PAGE_SIZE;   // per_page, приведён к 1..LISTING_MAX_PAGE_SIZE
+    bool useTextIndex = false; // q ищет полнотекстовый индекс БД
+};
+
+// textIndexAvailable - Database::isSearchIndexAvailable() соединения, готовившего схему
+ListingQuery parseListingQuery(std::string_view request, bool textIndexAvailable);
+
+// Страница выдачи; page приведён к диапазону 1..totalPages.
+// items указывают в снимок каталога: он должен жить, пока страница используется
+struct ListingPage {
+    std::vector<const Integrator*> items;
+    int total = 0;
+    int page = 1;
+    int totalPages = 1;
+    std::shared_ptr<const RatingSnapshot> ratings;   // оценки для отображения
+
+    const std::map<int, RatingStats>& ratingStats() const { return ratings->stats; }
+};
+
+// ratings - Catalog::ratings для того же снимка
+ListingPage buildListingPage(Database& db, const CatalogSnapshot& catalog,
+                             std::shared_ptr<const RatingSnapshot> ratings, const ListingQuery& query);
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+// Асинхронный журнал в формате JSON Lines.
+// Запись формируется в потоке-источнике и кладётся в его собственный кольцевой
+// буфер (один писатель, один читатель, без блокировок). Фоновый поток раз в
+// несколько миллисекунд забирает записи из всех буферов и пишет их одним write().
+// При переполнении буфера запись отбрасывается, поток запроса никогда не ждёт.
+//
+// Отключённый уровень стоит одного relaxed-чтения: макросы LOG_* не вычисляют
+// аргументы .field(...), если уровень ниже текущего.
+
+enum class LogLevel {
+    Debug = 0,
+    Info = 1,
+    Warn = 2,
+    Error = 3,
+    Off = 4
+};
+
+extern std::atomic<int> currentLogLevel;
+
+inline bool logEnabled(LogLevel level) {
+    return static_cast<int>(level) >= currentLogLevel.load(std::memory_order_relaxed);
+}
+
+// debug|info|warn|error|off; неизвестное значение - info
+LogLevel parseLogLevel(const std::string& name);
+
+// Запуск фонового потока записи; пустой path - стандартный вывод
+bool startLogger(LogLevel level, const std::string& path);
+// Дописывает накопленные записи и останавливает фоновый поток
+void stopLogger();
+
+// Одна запись журнала; отправляется в буфер потока в деструкторе.
+// Значения полей с чувствительными именами (password, token, session, cookie...)
+// заменяются на "***".
+class LogRecord {
+private:
+    std::string line;
+
+    void appendKey(const char* key);
+
+public:
+    LogRecord(LogLevel level, const char* message);
+    ~LogRecord();
+    LogRecord(const LogRecord&) = delete;
+    LogRecord& operator=(const LogRecord&) = delete;
+
+    LogRecord& field(const char* key, std::string_view value);
+    LogRecord& field(const char* key, const char* value) { return field(key, std::string_view(value ? value : "")); }
+    LogRecord& field(const char* key, const std::string& value) { return field(key, std::string_view(value)); }
+    LogRecord& field(const char* key, bool value);
+    LogRecord& field(const char* key, double value);
+
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value, LogRecord&>::type
+    field(const char* key, T value) {
+        appendKey(key);
+        line += std::to_string(value);
+        return *this;
+    }
+};
+
+#define LOG_AT(level, message) \
+    if (!logEnabled(level)) {} else LogRecord(level, message)
+
+#define LOG_DEBUG(message) LOG_AT(LogLevel::Debug, message)
+#define LOG_INFO(message) LOG_AT(LogLevel::Info, message)
+#define LOG_WARN(message) LOG_AT(LogLevel::Warn, message)
+#define LOG_ERROR(message) LOG_AT(LogLevel::Error, message)
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Метрики процесса. Запись (add/record) - только relaxed-атомики в ячейке
+// текущего потока без блокировок; ячейки выровнены по кэш-линии, чтобы потоки
+// не делили одну линию. Мьютекс реестра берётся лишь при регистрации и выгрузке.
+
+const size_t METRIC_SHARDS = 8;
+
+// Номер ячейки текущего потока (назначается по кругу при первом обращении)
+size_t metricShard();
+
+class Counter {
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> value{0};
+    };
+    Slot slots[METRIC_SHARDS];
+
+public:
+    void add(uint64_t n = 1) { slots[metricShard()].value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const;
+};
+
+class Gauge {
+private:
+    alignas(64) std::atomic<int64_t> current{0};
+
+public:
+    void add(int64_t n) { current.fetch_add(n, std::memory_order_relaxed); }
+    void set(int64_t n) { current.store(n, std::memory_order_relaxed); }
+    int64_t value() const { return current.load(std::memory_order_relaxed); }
+};
+
+// Гистограмма длительностей в микросекундах с логарифмически-линейными
+// корзинами (как в HdrHistogram): каждая степень двойки делится на
+// 2^SUB_BUCKET_BITS равных частей, относительная погрешность не более 12.5%
+class Histogram {
+public:
+    static const int SUB_BUCKET_BITS = 3;
+    static const uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int MAX_EXPONENT = 36;   // ~19 часов
+    static const size_t BUCKETS = SUB_BUCKETS + (MAX_EXPONENT - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    struct Snapshot {
+        std::vector<uint64_t> buckets;
+        uint64_t count = 0;
+        uint64_t sumMicros = 0;
+
+        // Верхняя граница корзины, в которую попал заданный квантиль
+        uint64_t quantileMicros(double q) const;
+    };
+
+    static size_t bucketIndex(uint64_t micros);
+    // Наименьшее значение, попадающее в корзину
+    static uint64_t bucketLowerBound(size_t index);
+
+    void record(uint64_t micros);
+    Snapshot snapshot() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> buckets[BUCKETS];
+        std::atomic<uint64_t> sumMicros;
+    };
+    std::unique_ptr<Shard[]> shards{new Shard[METRIC_SHARDS]()};
+};
+
+struct RouteMetrics {
+    Counter requests;
+    Counter bytesIn;
+    Counter bytesOut;
+    Histogram latency;
+};
+
+struct QueryMetrics {
+    Counter calls;
+    Counter errors;
+    Histogram latency;
+};
+
+struct CacheMetrics {
+    Counter hits;
+    Counter misses;
+};
+
+// Запросы, отклонённые до обработки: лимит клиента (429) и перегрузка (503)
+struct AdmissionMetrics {
+    Counter rateLimited;
+    Counter shed;
+};
+
+// Фоновые задачи обслуживания БД (очистка просроченных строк)
+struct MaintenanceMetrics {
+    Counter runs;
+    Counter rowsDeleted;
+    Counter errors;
+    Histogram duration;
+};
+
+class MetricsRegistry {
+private:
+    mutable std::mutex mutex;
+    std::map<std::string, std::unique_ptr<RouteMetrics>> routes;
+    std::map<std::string, std::unique_ptr<QueryMetrics>> queries;
+    std::map<std::string, std::unique_ptr<CacheMetrics>> caches;
+    std::map<std::string, std::unique_ptr<MaintenanceMetrics>> maintenanceTasks;
+    std::map<std::string, std::unique_ptr<AdmissionMetrics>> admissionClasses;
+    Gauge connections;
+
+public:
+    static MetricsRegistry& instance();
+
+    // Регистрация (или получение уже зарегистрированной) метрики по имени.
+    // Ссылки остаются валидными до конца работы процесса - их стоит сохранить
+    // один раз и обращаться к ним без повторного поиска.
+    RouteMetrics& route(const std::string& name);
+    QueryMetrics& query(const std::string& key);
+    CacheMetrics& cache(const std::string& name);
+    MaintenanceMetrics& maintenance(const std::string& task);
+    AdmissionMetrics& admission(const std::string& rateClass);
+    Gauge& activeConnections() { return connections; }
+
+    // Текстовый формат Prometheus (version 0.0.4)
+    std::string renderPrometheus() const;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef PAGES_H
+#define PAGES_H
+
+#include "database.h"
+#include "dictionary.h"
+#include "listing.h"
+#include "slow_query_log.h"
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// HTML-страницы сайта. Функции не обращаются к БД и сокетам: всё нужное
+// передаётся аргументами.
+
+std::string generateLoginPage(const std::string& error = "");
+std::string generateRegisterPage(const std::string& error = "", const std::string& username = "",
+                                 const std::string& password = "");
+std::string generateSlowQueriesPage(const std::vector<SlowQueryEntry>& entries, uint64_t thresholdMicros);
+std::string generateMainPage(
+    const std::vector<Integrator>& integrators,
+    bool isAdmin,
+    bool isLoggedIn,
+    const std::string& username,
+    const std::string& tabToken,
+    const std::vector<std::string>& cities,
+    const Dictionary& countries = {},
+    const Dictionary& products = {},
+    const Dictionary& services = {},
+    const std::string& cityQuery = "",
+    const std::string& filterCityParam = "",
+    const std::string& searchName = "",
+    const std::string& textQuery = "",
+    const std::string& productFilterParam = "",
+    const std::string& serviceFilterParam = "",
+    const std::string& sortOption = "name_asc",
+    int page = 1,
+    int totalPages = 1,
+    int totalCount = 0,
+    const std::map<int, RatingStats>& ratingStats = {},
+    const std::map<int, std::vector<Rating>>& integratorRatings = {},
+    int pageSize = 5,
+    bool relevanceSort = false   // ListingQuery::useTextIndex: предлагать сортировку по релевантности
+);
+
+// Интеграторов между вызовами flush в renderMainPageListing
+const size_t MAIN_PAGE_FLUSH_BATCH = 20;
+
+// Главная страница из двух частей (generateMainPage - обе подряд в строку).
+// Шапка с формой поиска зависит только от запроса и справочников, поэтому
+// может уйти клиенту до запросов выдачи и отзывов.
+void renderMainPageHeader(
+    std::ostream& html,
+    bool isAdmin,
+    const std::string& username,
+    const std::string& tabToken,
+    const std::vector<std::string>& cities,
+    const Dictionary& products,
+    const Dictionary& services,
+    const ListingQuery& query
+);
+
+// Выдача, пагинация и окно редактирования; интеграторы - указатели в снимок
+// каталога, без копий. flush, если задан, вызывается после каждых
+// MAIN_PAGE_FLUSH_BATCH интеграторов: накопленное можно отправлять клиенту,
+// не дожидаясь конца страницы. false из flush (клиент отключился) прекращает
+// отрисовку.
+void renderMainPageListing(
+    std::ostream& html,
+    const std::function<bool()>& flush,
+    const std::vector<const Integrator*>& integrators,
+    bool isAdmin,
+    bool isLoggedIn,
+    const Dictionary& countries,
+    const Dictionary& products,
+    const Dictionary& services,
+    const ListingQuery& query,
+    int page,
+    int totalPages,
+    int totalCount,
+    const std::map<int, RatingStats>& ratingStats,
+    const std::map<int, std::vector<Rating>>& integratorRatings
+);
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef PASSWORD_HASHER_H
+#define PASSWORD_HASHER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Хеши паролей: scrypt (OpenSSL EVP_PBE_scrypt) в формате
+//   $scrypt$ln=15,r=8,p=1$<соль base64>$<хеш base64>
+// Строки без префикса $scrypt$ - пароли, сохранённые до перехода на хеши;
+// они сверяются как есть и перехешируются после успешного входа.
+
+struct ScryptParams {
+    int logN = 15;   // N = 2^logN; при r=8 память 128 * r * N = 32 МБ
+    int r = 8;
+    int p = 1;
+};
+
+// Допустимая сложность для PASSWORD_SCRYPT_LOG_N: ниже 2^10 хеш подбирается
+// слишком быстро, выше 2^20 (1 ГБ на хеш при r=8) EVP_PBE_scrypt не получит память
+const int SCRYPT_MIN_LOG_N = 10;
+const int SCRYPT_MAX_LOG_N = 20;
+
+std::string hashPassword(const std::string& password, const ScryptParams& params);
+// needsRehash - пароль верный, но хранится открытым текстом или с устаревшими параметрами
+bool verifyPassword(const std::string& password, const std::string& stored, const ScryptParams& params,
+                    bool& needsRehash);
+
+// Ограниченный пул потоков для хеширования. Поток обработки запросов не ждёт:
+// submit кладёт задачу в очередь (или сразу отказывает, если очередь полна),
+// а готовые результаты сигнализируются через completionFd() для poll().
+// Пул один на процесс: потоки, память scrypt и глубина очереди не растут с
+// числом циклов обработки. Результат задачи возвращается её владельцу
+// (Job::owner, номер цикла) - через его completionFd(owner).
+class PasswordHasher {
+public:
+    enum class Kind { Hash, Verify };
+
+    struct Job {
+        uint64_t ticket = 0;         // номер ожидающего запроса в цикле сервера
+        size_t owner = 0;            // цикл, которому вернуть результат
+        Kind kind = Kind::Hash;
+        std::string password;
+        std::string stored;          // для Verify - хранимая строка
+        // Результат
+        bool verified = false;
+        std::string newHash;         // для Hash и для Verify с needsRehash
+    };
+
+private:
+    ScryptParams params;
+    size_t queueLimit;
+    std::mutex mutex;
+    std::condition_variable wake;
+    // Готовые результаты владельца и pipe, будящий его poll()
+    struct Completion {
+        std::vector<Job> jobs;
+        int pipeFds[2] = {-1, -1};
+    };
+
+    std::deque<Job> queue;
+    std::vector<Completion> completions;
+    std::vector<std::thread> workers;
+    size_t inFlight = 0;             // в очереди и в работе
+    bool stopping = false;
+
+    void workerLoop();
+
+public:
+    PasswordHasher(size_t threads, size_t queueLimit, const ScryptParams& params, size_t owners = 1);
+    ~PasswordHasher();
+    PasswordHasher(const PasswordHasher&) = delete;
+    PasswordHasher& operator=(const PasswordHasher&) = delete;
+
+    // false - пул перегружен, запрос нужно отклонить
+    bool submit(Job job);
+    // Читаемый конец pipe владельца: становится готовым, когда есть его результаты
+    int completionFd(size_t owner = 0) const { return completions[owner].pipeFds[0]; }
+    std::vector<Job> takeCompleted(size_t owner = 0);
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef PROCESS_CONTROL_H
+#define PROCESS_CONTROL_H
+
+#include <sys/types.h>
+#include <vector>
+
+// Сигналы управления процессом сервера:
+//   SIGTERM, SIGINT - плавная остановка: приём прекращается, начатые запросы дообслуживаются
+//   SIGUSR2         - перезапуск без простоя: новый процесс получает слушающие сокеты,
+//                     текущий принимает соединения, пока новый не сообщит о готовности,
+//                     затем завершается как по SIGTERM
+enum class ProcessSignal {
+    None,
+    Shutdown,
+    Restart
+};
+
+// Ставит обработчики (и игнорирует SIGPIPE от закрытых клиентом соединений).
+// Возвращает читаемый конец self-pipe для poll(); -1 - ошибка.
+int installProcessSignals();
+// Последний полученный сигнал (вычитывает pipe); Shutdown важнее Restart
+ProcessSignal takeProcessSignal(int fd);
+
+// Слушающие сокеты, унаследованные от предыдущего процесса (LISTEN_FD и
+// LISTEN_FD_COUNT) или от systemd (LISTEN_FDS/LISTEN_PID, сокеты с 3-го);
+// пустой вектор - сокетов нет
+std::vector<int> inheritedListenSockets();
+// Запуск нового экземпляра сервера (/proc/self/exe с теми же аргументами),
+// которому слушающие сокеты передаются как дескрипторы 3, 4, ..., а следом -
+// записывающий конец pipe готовности (LISTEN_READY_FD). Возвращает pid после
+// успешного exec или -1; readyFd - читаемый конец pipe готовности.
+pid_t spawnReplacement(const std::vector<int>& listenSockets, char** argv, int& readyFd);
+// Ждёт, пока новый процесс сообщит о готовности. Если он завершился или не
+// успел за timeoutSeconds, он останавливается и возвращается false - текущий
+// процесс продолжает работу. readyFd закрывается.
+bool waitReplacementReady(pid_t pid, int readyFd, int timeoutSeconds);
+// Вызывается новым процессом, когда циклы обработки запущены: сообщает
+// предыдущему (если он есть), что тот может прекращать приём
+void notifyReplacementReady();
+
+#endif
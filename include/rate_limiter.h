@@ -0,0 +1,84 @@
+#ifndef RATE_LIMITER_H
+#define RATE_LIMITER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+// Классы маршрутов с отдельными бюджетами запросов
+enum class RateClass {
+    Auth,    // вход и регистрация - дорогой хеш пароля
+    Read,    // страницы
+    Write,   // изменения каталога, оценки, выход
+    Count
+};
+
+const char* rateClassName(RateClass rateClass);
+
+// Ключ клиента для RateLimiter (FNV-1a с перемешиванием); prefix разводит
+// пространства ключей, например "ip" и "session"
+uint64_t rateKey(std::string_view prefix, std::string_view value);
+
+// Token bucket на клиента и класс маршрута в таблице фиксированного размера.
+// Таблица поделена на шарды со своим мьютексом; внутри шарда открытая адресация
+// с коротким окном проб. Если в окне нет места, вытесняется ячейка, к которой
+// дольше всех не обращались (приближённый LRU): память не растёт от числа
+// клиентов, а вытесненный клиент лишь получает полный бюджет заново.
+class RateLimiter {
+public:
+    struct Budget {
+        double ratePerSecond;
+        double burst;
+    };
+
+    RateLimiter(size_t slots, const Budget (&budgets)[static_cast<int>(RateClass::Count)]);
+
+    // true - запрос пропускается (токен списан); иначе retryAfterSeconds -
+    // через сколько секунд появится токен
+    bool allow(uint64_t key, RateClass rateClass, int& retryAfterSeconds);
+
+private:
+    static const size_t SHARDS = 16;
+    static const size_t PROBE_WINDOW = 8;
+
+    struct Slot {
+        uint64_t key = 0;       // 0 - свободна
+        float tokens = 0;
+        uint32_t lastMillis = 0;
+    };
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unique_ptr<Slot[]> slots;
+    };
+
+    std::unique_ptr<Shard[]> shards;
+    size_t slotsPerShard;
+    Budget budgets[static_cast<int>(RateClass::Count)];
+    std::chrono::steady_clock::time_point epoch;
+};
+
+// Ограничение числа одновременно обрабатываемых запросов (включая ожидающие
+// пула хеширования): сверх лимита запрос сразу получает 503
+class ConcurrencyLimiter {
+private:
+    std::atomic<int> inFlight{0};
+    int limit;
+
+public:
+    explicit ConcurrencyLimiter(int limit) : limit(limit) {}
+
+    bool tryAcquire() {
+        if (inFlight.fetch_add(1, std::memory_order_relaxed) >= limit) {
+            inFlight.fetch_sub(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+    void release() { inFlight.fetch_sub(1, std::memory_order_relaxed); }
+    int current() const { return inFlight.load(std::memory_order_relaxed); }
+};
+
+#endif
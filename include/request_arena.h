@@ -0,0 +1,30 @@
+#ifndef REQUEST_ARENA_H
+#define REQUEST_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+// Память под короткоживущие объекты одного запроса (сейчас - разбор формы).
+// Выделение - сдвиг указателя в блоке, созданном один раз на цикл обработки;
+// освобождения по одному объекту нет, reset() после ответа возвращает весь
+// блок сразу. Если запросу блока не хватило, добавочные куски берутся из
+// кучи и отдаются в reset(). Не потокобезопасна: по арене на цикл.
+class RequestArena {
+private:
+    std::unique_ptr<char[]> block;
+    std::pmr::monotonic_buffer_resource resource;
+
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit RequestArena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    RequestArena(const RequestArena&) = delete;
+    RequestArena& operator=(const RequestArena&) = delete;
+
+    std::pmr::memory_resource* memory() { return &resource; }
+    // Всё выделенное с прошлого reset() становится недействительным
+    void reset() { resource.release(); }
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef RESPONSE_STREAM_H
+#define RESPONSE_STREAM_H
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+// std::streambuf, дописывающий в строку: std::ostream поверх него пишет
+// прямо в целевой буфер, без копии, которую делает ostringstream::str()
+class StringAppendBuffer : public std::streambuf {
+private:
+    std::string& target;
+
+protected:
+    int_type overflow(int_type c) override {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            target += traits_type::to_char_type(c);
+        }
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char* data, std::streamsize size) override {
+        target.append(data, static_cast<size_t>(size));
+        return size;
+    }
+
+public:
+    explicit StringAppendBuffer(std::string& target) : target(target) {}
+};
+
+// Ответ, тело которого отправляется клиенту по мере формирования.
+// Пока тело меньше chunkThreshold, оно копится в body() и уходит одним send
+// с Content-Length. Если при flush() набралось больше - заголовки уходят с
+// Transfer-Encoding: chunked, накопленное - очередным куском, а буфер
+// очищается: память ответа не растёт с размером выдачи. flush(true)
+// отправляет накопленное сразу - например, шапку страницы до её тела.
+class ResponseStream {
+private:
+    int socket;
+    std::string head;        // стартовая строка и заголовки без длины тела
+    std::string buffer;
+    StringAppendBuffer bodyBuffer{buffer};
+    std::ostream bodyOut{&bodyBuffer};
+    size_t chunkThreshold;
+    bool chunked = false;
+    bool failed = false;
+    size_t bytesSent = 0;
+
+    bool sendAll(const char* data, size_t size);
+    void sendChunk();
+
+public:
+    ResponseStream(int socket, int statusCode, const char* contentType, size_t chunkThreshold = 16 * 1024);
+
+    // Дополнительные строки заголовков с \r\n; только до первой отправки
+    void addHeaders(const std::string& headers) { head += headers; }
+    std::string& body() { return buffer; }
+    // Поток поверх body() для отрисовки через operator<<
+    std::ostream& bodyStream() { return bodyOut; }
+    // Отправка накопленного куском, если набралось не меньше порога или force
+    void flush(bool force = false);
+    // Завершение ответа; возвращает число отправленных байт
+    size_t finish();
+    // false - клиент отключился, формировать тело дальше незачем
+    bool ok() const { return !failed; }
+};
+
+#endif
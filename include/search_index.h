@@ -0,0 +1,80 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include "database.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+// Сжатое отсортированное множество номеров строк: дельты в varint (LEB128)
+// и таблица пропусков каждые SKIP_INTERVAL значений для быстрого advanceTo()
+class PostingList {
+private:
+    static const uint32_t SKIP_INTERVAL = 64;
+
+    std::vector<uint8_t> bytes;
+    std::vector<std::pair<uint32_t, uint32_t>> skips;   // (предыдущее значение, смещение в bytes)
+    uint32_t count = 0;
+    uint32_t last = 0;
+
+public:
+    class Iterator {
+    private:
+        const PostingList* list;
+        const uint8_t* p;
+        const uint8_t* end;
+        uint32_t current = 0;
+        bool valid = false;
+
+    public:
+        explicit Iterator(const PostingList* list);
+        bool isValid() const { return valid; }
+        uint32_t value() const { return current; }
+        void next();
+        // Переход к первому значению >= target
+        void advanceTo(uint32_t target);
+    };
+
+    // Значения должны добавляться строго по возрастанию
+    void append(uint32_t value);
+    uint32_t size() const { return count; }
+    size_t byteSize() const { return bytes.size() + skips.size() * sizeof(skips[0]); }
+    Iterator begin() const { return Iterator(this); }
+    std::vector<uint32_t> decode() const;
+};
+
+struct SearchQuery {
+    std::string name;      // подстрока названия
+    std::string city;      // подстрока города
+    int productId = 0;     // 0 - любой продукт
+    int serviceId = 0;
+};
+
+// Инвертированный индекс каталога: n-граммы (1..3 символа) по названию и городу,
+// списки строк по id продуктов и услуг. Строится из снимка каталога, обращений к БД нет.
+class SearchIndex {
+private:
+    std::unordered_map<uint64_t, PostingList> nameGrams;
+    std::unordered_map<uint64_t, PostingList> cityGrams;
+    std::unordered_map<int, PostingList> productRows;
+    std::unordered_map<int, PostingList> serviceRows;
+    std::vector<std::string> foldedNames;
+    std::vector<std::string> foldedCities;
+    uint32_t rowCount = 0;
+
+    static void indexGrams(std::unordered_map<uint64_t, PostingList>& grams, const std::string& folded, uint32_t row);
+    // Списки n-грамм образца; false, если какой-то n-граммы нет в индексе
+    static bool collectGrams(const std::unordered_map<uint64_t, PostingList>& grams, const std::string& foldedPattern,
+                             std::vector<const PostingList*>& lists);
+
+public:
+    void build(const std::vector<Integrator>& integrators);
+
+    // Номера строк снимка (по возрастанию), удовлетворяющих всем непустым условиям
+    std::vector<uint32_t> search(const SearchQuery& query) const;
+
+    size_t memoryUsage() const;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef SESSION_SWEEPER_H
+#define SESSION_SWEEPER_H
+
+#include "database.h"
+#include "metrics.h"
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Фоновая очистка просроченных сессий и записей об отзыве токенов.
+// Поток работает на собственном соединении (свой Database): основной цикл
+// сервера не ждёт очистку, а очистка не делит с ним соединение.
+//
+// Раз в interval удаляет строки пачками по batchSize, каждая пачка - отдельная
+// короткая транзакция; между пачками пауза, чтобы не занимать БД подряд.
+class SessionSweeper {
+private:
+    std::unique_ptr<Database> db;
+    std::chrono::seconds interval;
+    int batchSize;
+    MaintenanceMetrics& sessionMetrics = MetricsRegistry::instance().maintenance("expired_sessions");
+    MaintenanceMetrics& revocationMetrics = MetricsRegistry::instance().maintenance("expired_session_revocations");
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::thread thread;
+
+    void run();
+    // false - остановка во время очистки
+    bool sweep(const char* task, int (Database::*deleteBatch)(int), MaintenanceMetrics& metrics);
+    // Ожидание с выходом по stop(); false - пора останавливаться
+    bool sleepFor(std::chrono::milliseconds duration);
+
+public:
+    SessionSweeper(std::unique_ptr<Database> db, std::chrono::seconds interval, int batchSize);
+    ~SessionSweeper();
+    SessionSweeper(const SessionSweeper&) = delete;
+    SessionSweeper& operator=(const SessionSweeper&) = delete;
+
+    void start();
+    void stop();
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef SESSION_TOKENS_H
+#define SESSION_TOKENS_H
+
+#include "database.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Случайная строка из bytes байт в шестнадцатеричном виде (RAND_bytes)
+std::string randomHex(size_t bytes);
+
+// Подписанные токены сессий (SESSION_MODE=token). Cookie session_id содержит
+//   <kid>.<данные base64url>.<HMAC-SHA256 base64url>
+// где данные - "uid:admin:iat:exp:jti:username". Проверка токена не обращается
+// к БД: подпись, срок и список отзыва в памяти.
+//
+// Ключи задаются строкой "kid1:секрет1,kid2:секрет2": первым ключом подписываются
+// новые токены, остальные только проверяются - так ключ меняется без выхода
+// пользователей (новый ключ ставится первым, старый удаляется через время жизни токена).
+//
+// Отзыв: /logout отзывает jti токена, deleteUserSessions - все токены пользователя,
+// выданные до момента отзыва. Записи хранятся в таблице session_revocations;
+// отзывы своего процесса действуют сразу, чужих - после refreshRevocations.
+//
+// Ключи задаются до запуска циклов обработки и дальше только читаются; списки
+// отзыва защищены мьютексом - объект общий для всех циклов.
+class SessionTokens {
+private:
+    std::unordered_map<std::string, std::string> keys;
+    std::string signingKid;
+    int64_t ttlSeconds;
+    mutable std::mutex revocationMutex;
+    std::atomic<int64_t> revocationsRefreshedAt{0};   // мс steady_clock
+    std::unordered_set<std::string> revokedTokens;
+    std::unordered_map<int, int64_t> userRevokedAt;   // user_id -> время отзыва (unix)
+
+    struct Claims {
+        int userId = 0;
+        bool isAdmin = false;
+        int64_t issuedAt = 0;
+        int64_t expiresAt = 0;
+        std::string tokenId;
+        std::string username;
+    };
+
+    std::string sign(const std::string& kid, const std::string& data) const;
+    // Проверяет подпись и разбирает данные; срок и отзыв не проверяются
+    bool decode(const std::string& token, Claims& claims) const;
+
+public:
+    SessionTokens(int64_t ttlSeconds) : ttlSeconds(ttlSeconds) {}
+
+    // false - строка ключей пустая или некорректная
+    bool configureKeys(const std::string& spec);
+    // Случайный ключ на время жизни процесса (без SESSION_KEYS)
+    void generateKey();
+
+    std::string issue(int userId, const std::string& username, bool isAdmin);
+    // nullopt - токен поддельный, просрочен или отозван
+    std::optional<Session> verify(const std::string& token) const;
+
+    // Отзыв токена при выходе; в БД и в памяти процесса
+    bool revoke(Database& db, const std::string& token);
+    bool refreshRevocations(Database& db);
+    // Обновление списка отзыва, если с прошлого прошло не меньше interval;
+    // из нескольких циклов, которым оно пора, обновляет один
+    void refreshRevocationsIfDue(Database& db, std::chrono::seconds interval);
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef SLOW_QUERY_LOG_H
+#define SLOW_QUERY_LOG_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Журнал медленных именованных запросов. Для каждого ключа из queries.sql
+// хранится число превышений порога и самое медленное выполнение: параметры
+// (с маскировкой строк), длительность, число строк и, если включено, план.
+// План снимается в фоновом потоке на отдельном соединении, поток запроса его
+// не ждёт. SELECT выполняется повторно под EXPLAIN (ANALYZE, BUFFERS) внутри
+// транзакции с ROLLBACK; для изменяющих запросов - только EXPLAIN без
+// выполнения: повторный прогон сдвигал бы последовательности, вызывал
+// триггеры и держал блокировки строк, которые пишет сервер.
+struct SlowQueryEntry {
+    std::string key;
+    uint64_t count = 0;             // сколько раз превышен порог
+    uint64_t totalMicros = 0;
+    uint64_t maxMicros = 0;
+    std::string maxParams;          // параметры самого медленного выполнения
+    long long maxRows = 0;
+    std::string maxTime;            // когда оно было (UTC)
+    std::string plan;               // план самого медленного выполнения (если снят)
+    std::string planCommand;        // чем снят план: EXPLAIN (ANALYZE, BUFFERS) или EXPLAIN
+};
+
+class SlowQueryLog {
+private:
+    struct ExplainJob {
+        uint64_t sample;
+        std::string key;
+        std::string sql;
+        std::vector<std::string> params;
+    };
+
+    mutable std::mutex mutex;
+    std::map<std::string, SlowQueryEntry> entries;
+    std::map<std::string, uint64_t> sampleByKey;   // номер выполнения, для которого нужен план
+    std::atomic<uint64_t> threshold{UINT64_MAX};
+    uint64_t nextSample = 0;
+
+    std::string explainConnectionString;           // пусто - EXPLAIN не снимается
+    std::deque<ExplainJob> explainQueue;
+    std::condition_variable explainWake;
+    std::thread explainThread;
+    bool stopping = false;
+
+    void explainLoop();
+
+public:
+    static SlowQueryLog& instance();
+
+    // thresholdMicros == 0 - журнал выключен. Непустая строка подключения
+    // включает снятие планов на отдельном соединении.
+    void configure(uint64_t thresholdMicros, const std::string& explainConnection);
+    void stop();
+
+    uint64_t thresholdMicros() const { return threshold.load(std::memory_order_relaxed); }
+
+    // Вызывается из Database::execNamed, когда запрос выполнялся дольше порога
+    void record(const std::string& key, const std::string& sql, int paramCount, const char* const* paramValues,
+                uint64_t micros, long long rows);
+
+    // Ключи, упорядоченные по убыванию самого медленного выполнения
+    std::vector<SlowQueryEntry> top(size_t limit) const;
+};
+
+#endif
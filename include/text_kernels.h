@@ -0,0 +1,51 @@
+#ifndef TEXT_KERNELS_H
+#define TEXT_KERNELS_H
+
+#include <string>
+#include <memory_resource>
+#include <cstddef>
+#include <cstdint>
+
+// Векторные ядра для экранирования и декодирования строк.
+// Блоки по 16 (SSE4.2) или 32 (AVX2) байта проверяются на наличие специальных
+// символов; участки без них копируются в результат целиком.
+// Реализация выбирается один раз при запуске по возможностям процессора,
+// переменная окружения TEXT_KERNELS=scalar|sse42|avx2 позволяет её ограничить.
+
+enum class TextKernelLevel {
+    Scalar,
+    SSE42,
+    AVX2
+};
+
+TextKernelLevel textKernelLevel();
+const char* textKernelName(TextKernelLevel level);
+// Возвращает false, если процессор не поддерживает запрошенный уровень
+bool setTextKernelLevel(TextKernelLevel level);
+
+// Набор из не более чем 8 байтов. Каждому байту отводится свой бит в таблицах
+// по младшему и старшему полубайту: байт входит в набор, если low[c & 15] & high[c >> 4] != 0.
+// Так классификация блока занимает два PSHUFB независимо от размера набора.
+struct ByteSet {
+    uint8_t low[16];
+    uint8_t high[16];
+    bool table[256];
+
+    explicit ByteSet(const char* chars);
+    bool contains(char c) const { return table[static_cast<unsigned char>(c)]; }
+};
+
+// Смещение первого байта из набора или size, если таких нет
+size_t findFirstOf(const char* data, size_t size, const ByteSet& set);
+
+// %XX и '+' -> ' '; некорректные последовательности '%' копируются как есть
+void appendUrlDecoded(std::string& out, const char* data, size_t size);
+void appendUrlDecoded(std::pmr::string& out, const char* data, size_t size);
+// & < > " '
+void appendHtmlEscaped(std::string& out, const char* data, size_t size);
+// Для строковых литералов JS: \ -> \\, " -> \", перевод строки -> \n, \r удаляется
+void appendJsEscaped(std::string& out, const char* data, size_t size);
+// true, если appendJsEscaped изменит строку
+bool needsJsEscape(const char* data, size_t size);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Трассировка запросов. У каждого запроса есть trace id (попадает в журнал);
+// для доли запросов, выбранной сэмплированием, вложенные интервалы (span)
+// накапливаются в памяти потока и по окончании запроса дописываются в файл
+// в формате Chrome Trace Event (открывается в chrome://tracing и Perfetto).
+//
+// Для несэмплированного запроса TraceSpan стоит одной проверки thread_local.
+
+// sampleRate от 0 до 1; пустой path - трассировка выключена
+bool startTracing(double sampleRate, const std::string& path);
+void stopTracing();
+
+// Начало обработки запроса в текущем потоке; возвращает trace id
+uint64_t beginTrace();
+// Завершает корневой интервал запроса и записывает трассу, если она сэмплирована
+void endTrace(const char* route);
+uint64_t currentTraceId();
+// Trace id в виде 16 шестнадцатеричных цифр
+std::string formatTraceId(uint64_t traceId);
+
+// Интервал от создания до разрушения объекта. name должен жить до конца
+// запроса (строковый литерал); detail копируется, только если трасса пишется.
+class TraceSpan {
+private:
+    size_t index;
+    bool active;
+
+public:
+    explicit TraceSpan(const char* name, std::string_view detail = std::string_view());
+    ~TraceSpan();
+    // Досрочное завершение интервала (повторные вызовы и деструктор ничего не делают)
+    void end();
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <string>
+#include <cstdint>
+
+// Декодирование одного символа UTF-8; p сдвигается на следующий символ.
+// Некорректные байты возвращаются как U+FFFD.
+uint32_t utf8Decode(const char*& p, const char* end);
+void utf8Append(std::string& out, uint32_t codePoint);
+
+// Перевод в нижний регистр для латиницы (включая Latin-1 и Latin Extended-A) и кириллицы
+uint32_t foldCodePoint(uint32_t codePoint);
+std::string utf8ToLower(const std::string& str);
+
+// Нормализация для поиска: нижний регистр и ё -> е
+uint32_t foldForSearch(uint32_t codePoint);
+std::string utf8FoldForSearch(const std::string& str);
+
+#endif
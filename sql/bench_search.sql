@@ -0,0 +1,80 @@
+-- Замер латентности поиска интеграторов на 100 000 записей
+-- Запуск: psql -U postgres -d infosec_db -f sql/bench_search.sql
+-- Все изменения выполняются в одной транзакции и откатываются в конце,
+-- поэтому скрипт можно запускать на рабочей базе
+
+\timing on
+
+BEGIN;
+
+-- Генерация 100 000 интеграторов (триггеры отключены на время массовой вставки)
+ALTER TABLE integrators DISABLE TRIGGER trg_integrators_search_vector;
+ALTER TABLE integrator_products DISABLE TRIGGER trg_integrator_products_search_vector;
+
+INSERT INTO integrators (name, city, description, website, country_id)
+SELECT 'Интегратор ' || g || ' ' || substr(md5(g::text), 1, 8),
+       (ARRAY['Москва', 'Санкт-Петербург', 'Новосибирск', 'Екатеринбург',
+              'Казань', 'Нижний Новгород', 'Самара', 'Тель-Авив'])[1 + g % 8],
+       'Компания занимается ' ||
+       (ARRAY['аудитом информационной безопасности', 'защитой от утечек данных',
+              'тестированием на проникновение', 'мониторингом инцидентов',
+              'внедрением межсетевых экранов'])[1 + g % 5] ||
+       ' и обучением персонала. Код ' || md5(g::text),
+       'https://integrator' || g || '.example',
+       NULL
+FROM generate_series(1, 100000) AS g;
+
+INSERT INTO integrator_products (integrator_id, product_id)
+SELECT i.id, p.id
+FROM integrators i
+JOIN products p ON p.id % 5 = i.id % 5
+WHERE i.website LIKE 'https://integrator%.example'
+ON CONFLICT DO NOTHING;
+
+ALTER TABLE integrators ENABLE TRIGGER trg_integrators_search_vector;
+ALTER TABLE integrator_products ENABLE TRIGGER trg_integrator_products_search_vector;
+
+SELECT count(*) FROM (
+    SELECT refresh_integrator_search_vector(id) FROM integrators WHERE search_vector IS NULL
+) AS refreshed;
+
+ANALYZE integrators;
+
+-- 1. Подстрока в названии (триграммный индекс idx_integrators_name_trgm)
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, name, city FROM integrators WHERE name ILIKE '%' || '4e7a' || '%';
+
+-- 2. Подстрока в городе (idx_integrators_city_trgm), прежний SEARCH_INTEGRATORS_BY_CITY
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, name, city FROM integrators WHERE city ILIKE '%новгород%' ORDER BY name;
+
+-- 3. Полнотекстовый поиск по описанию, продуктам и услугам с ранжированием
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, name, ts_rank_cd(search_vector, websearch_to_tsquery('russian', 'утечки данных')) AS rank
+FROM integrators
+WHERE search_vector @@ websearch_to_tsquery('russian', 'утечки данных')
+ORDER BY rank DESC, name
+LIMIT 50;
+
+-- 4. Название, город и текст одним запросом с ранжированием
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT i.id, i.name, i.city,
+       ts_rank_cd(i.search_vector, websearch_to_tsquery('russian', 'аудит'))
+       + similarity(i.name, '77') + similarity(i.city, 'моск') AS rank
+FROM integrators i
+WHERE i.name ILIKE '%77%'
+  AND i.city ILIKE '%моск%'
+  AND i.search_vector @@ websearch_to_tsquery('russian', 'аудит')
+ORDER BY rank DESC, i.name;
+
+-- Для сравнения: те же подстроки без индексов (последовательное сканирование)
+SET LOCAL enable_bitmapscan = off;
+SET LOCAL enable_indexscan = off;
+
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, name, city FROM integrators WHERE name ILIKE '%' || '4e7a' || '%';
+
+EXPLAIN (ANALYZE, BUFFERS)
+SELECT id, name, city FROM integrators WHERE city ILIKE '%новгород%' ORDER BY name;
+
+ROLLBACK;
@@ -16,6 +16,14 @@ DROP TABLE IF EXISTS products CASCADE;
 DROP TABLE IF EXISTS countries CASCADE;
 DROP TABLE IF EXISTS users CASCADE;
 
+-- Функции поиска (триггеры удаляются вместе с таблицами)
+DROP FUNCTION IF EXISTS integrator_links_search_vector_trigger() CASCADE;
+DROP FUNCTION IF EXISTS integrators_search_vector_trigger() CASCADE;
+DROP FUNCTION IF EXISTS refresh_integrator_search_vector(INTEGER) CASCADE;
+
+-- Ключ сортировки названий
+DROP FUNCTION IF EXISTS collation_key(TEXT) CASCADE;
+
 -- Альтернативный способ: удалить все таблицы через цикл
 -- DO $$
 -- DECLARE
@@ -78,6 +78,9 @@ CREATE TABLE IF NOT EXISTS sessions (
     expires_at TIMESTAMP NOT NULL
 );
 
+-- Очистка просроченных сессий выбирает строки по expires_at
+CREATE INDEX IF NOT EXISTS idx_sessions_expires_at ON sessions (expires_at);
+
 -- Создание таблицы рейтингов и отзывов
 CREATE TABLE IF NOT EXISTS ratings (
     id SERIAL PRIMARY KEY,
@@ -89,6 +92,35 @@ CREATE TABLE IF NOT EXISTS ratings (
     UNIQUE (integrator_id, user_id)
 );
 
+-- Отзыв подписанных токенов сессий (SESSION_MODE=token): token_id - один токен,
+-- пустой token_id - все токены пользователя, выданные не позже revoked_at
+CREATE TABLE IF NOT EXISTS session_revocations (
+    id SERIAL PRIMARY KEY,
+    token_id VARCHAR(64) UNIQUE,
+    user_id INTEGER REFERENCES users(id) ON DELETE CASCADE,
+    revoked_at TIMESTAMPTZ NOT NULL DEFAULT NOW(),
+    expires_at TIMESTAMPTZ NOT NULL
+);
+
+CREATE INDEX IF NOT EXISTS idx_session_revocations_expires_at ON session_revocations (expires_at);
+
+-- Ключ сортировки названий: буквы без регистра (ё = е), затем ё после е, затем
+-- регистр (строчные раньше). ORDER BY collation_key(name) COLLATE "C" даёт тот же
+-- порядок, что каталог в памяти сервера, при любой локали БД. Сервер при старте
+-- пересоздаёт функцию по своей таблице (collation.cpp)
+CREATE OR REPLACE FUNCTION collation_key(t TEXT) RETURNS TEXT AS $$
+    SELECT translate(t, 'aAbBcCdDeEfFgGhHiIjJkKlLmMnNoOpPqQrRsStTuUvVwWxXyYzZаАбБвВгГдДеЕжЖзЗиИйЙкКлЛмМнНоОпПрРсСтТуУфФхХцЦчЧшШщЩъЪыЫьЬэЭюЮяЯёЁ',
+                        'aabbccddeeffgghhiijjkkllmmnnooppqqrrssttuuvvwwxxyyzzааббввггддеежжззииййккллммннооппррссттууффххццччшшщщъъыыььээююяяее') || chr(1) ||
+           translate(t, 'aAbBcCdDeEfFgGhHiIjJkKlLmMnNoOpPqQrRsStTuUvVwWxXyYzZаАбБвВгГдДеЕжЖзЗиИйЙкКлЛмМнНоОпПрРсСтТуУфФхХцЦчЧшШщЩъЪыЫьЬэЭюЮяЯёЁ',
+                        'aabbccddeeffgghhiijjkkllmmnnooppqqrrssttuuvvwwxxyyzzааббввггддеежжззииййккллммннооппррссттууффххццччшшщщъъыыььээююяяёё') || chr(1) ||
+           translate(t, 'aAbBcCdDeEfFgGhHiIjJkKlLmMnNoOpPqQrRsStTuUvVwWxXyYzZаАбБвВгГдДеЕжЖзЗиИйЙкКлЛмМнНоОпПрРсСтТуУфФхХцЦчЧшШщЩъЪыЫьЬэЭюЮяЯёЁ',
+                        'ababababababababababababababababababababababababababababababababababababababababababababababababababababababababababab')
+$$ LANGUAGE sql IMMUTABLE STRICT;
+
+-- Индексированный поиск (pg_trgm, колонка search_vector, GIN-индексы и триггеры)
+-- создаёт сервер при старте: Database::initializeSearchIndex. Это единственное
+-- определение - здесь его нет, чтобы две копии не расходились.
+
 -- Создание администратора по умолчанию (пароль: admin123)
 INSERT INTO users (username, password_hash, is_admin) 
 VALUES ('admin', 'admin123', TRUE) 
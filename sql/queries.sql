@@ -14,9 +14,15 @@ CREATE TABLE IF NOT EXISTS integrators (
     city VARCHAR(100) NOT NULL,
     description TEXT,
     website VARCHAR(255),
-    country_id INTEGER REFERENCES countries(id)
+    country_id INTEGER REFERENCES countries(id),
+    search_vector tsvector
 );
 
+-- Индексы поиска (pg_trgm + полнотекстовый), функции и триггеры пересчёта search_vector см. в init.sql
+-- CREATE INDEX idx_integrators_name_trgm ON integrators USING GIN (name gin_trgm_ops);
+-- CREATE INDEX idx_integrators_city_trgm ON integrators USING GIN (city gin_trgm_ops);
+-- CREATE INDEX idx_integrators_search_vector ON integrators USING GIN (search_vector);
+
 -- Создание таблицы лицензий
 CREATE TABLE IF NOT EXISTS licenses (
     id SERIAL PRIMARY KEY,
@@ -79,74 +85,74 @@ CREATE TABLE IF NOT EXISTS sessions (
 );
 
 -- Получение всех интеграторов с дополнительной информацией
+-- Названия упорядочены по collation_key - так же, как каталог в памяти (collation.h).
+-- Страна, продукты и услуги - id (продукты и услуги через запятую), названия берутся из справочников
 -- QUERY: GET_ALL_INTEGRATORS
 SELECT i.id, i.name, i.city, i.description, i.website, 
-       c.name as country_name,
+       COALESCE(i.country_id, 0) as country_id,
        COALESCE(
-           (SELECT string_agg(p.name, ', ')
+           (SELECT string_agg(ip.product_id::text, ',' ORDER BY ip.product_id)
             FROM integrator_products ip
-            JOIN products p ON ip.product_id = p.id
             WHERE ip.integrator_id = i.id),
            ''
-       ) as products,
+       ) as product_ids,
        COALESCE(
-           (SELECT string_agg(s.name, ', ')
+           (SELECT string_agg(iserv.service_id::text, ',' ORDER BY iserv.service_id)
             FROM integrator_services iserv
-            JOIN services s ON iserv.service_id = s.id
             WHERE iserv.integrator_id = i.id),
            ''
-       ) as services
+       ) as service_ids
 FROM integrators i
-LEFT JOIN countries c ON i.country_id = c.id
-ORDER BY i.name;
+ORDER BY collation_key(i.name) COLLATE "C", i.id;
 
 -- Получение интеграторов по городу
 -- QUERY: GET_INTEGRATORS_BY_CITY
 SELECT i.id, i.name, i.city, i.description, i.website, 
-       c.name as country_name,
+       COALESCE(i.country_id, 0) as country_id,
        COALESCE(
-           (SELECT string_agg(p.name, ', ')
+           (SELECT string_agg(ip.product_id::text, ',' ORDER BY ip.product_id)
             FROM integrator_products ip
-            JOIN products p ON ip.product_id = p.id
             WHERE ip.integrator_id = i.id),
            ''
-       ) as products,
+       ) as product_ids,
        COALESCE(
-           (SELECT string_agg(s.name, ', ')
+           (SELECT string_agg(iserv.service_id::text, ',' ORDER BY iserv.service_id)
             FROM integrator_services iserv
-            JOIN services s ON iserv.service_id = s.id
             WHERE iserv.integrator_id = i.id),
            ''
-       ) as services
+       ) as service_ids
 FROM integrators i
-LEFT JOIN countries c ON i.country_id = c.id
-WHERE i.city = $1 ORDER BY i.name;
+WHERE i.city = $1 ORDER BY collation_key(i.name) COLLATE "C", i.id;
 
 -- Поиск интеграторов по городу (частичное совпадение)
 -- QUERY: SEARCH_INTEGRATORS_BY_CITY
 SELECT i.id, i.name, i.city, i.description, i.website, 
-       c.name as country_name,
+       COALESCE(i.country_id, 0) as country_id,
        COALESCE(
-           (SELECT string_agg(p.name, ', ')
+           (SELECT string_agg(ip.product_id::text, ',' ORDER BY ip.product_id)
             FROM integrator_products ip
-            JOIN products p ON ip.product_id = p.id
             WHERE ip.integrator_id = i.id),
            ''
-       ) as products,
+       ) as product_ids,
        COALESCE(
-           (SELECT string_agg(s.name, ', ')
+           (SELECT string_agg(iserv.service_id::text, ',' ORDER BY iserv.service_id)
             FROM integrator_services iserv
-            JOIN services s ON iserv.service_id = s.id
             WHERE iserv.integrator_id = i.id),
            ''
-       ) as services
+       ) as service_ids
+FROM integrators i
+WHERE i.city ILIKE $1 ORDER BY collation_key(i.name) COLLATE "C", i.id;
+
+-- Полнотекстовый поиск: только ID в порядке релевантности (остальное берётся из каталога в памяти)
+-- QUERY: SEARCH_INTEGRATOR_IDS
+SELECT i.id
 FROM integrators i
-LEFT JOIN countries c ON i.country_id = c.id
-WHERE i.city ILIKE $1 ORDER BY i.name;
+WHERE i.search_vector @@ websearch_to_tsquery('russian', $1)
+ORDER BY ts_rank_cd(i.search_vector, websearch_to_tsquery('russian', $1)) DESC, collation_key(i.name) COLLATE "C", i.id;
 
 -- Получение списка всех уникальных городов
 -- QUERY: GET_ALL_CITIES
-SELECT DISTINCT city FROM integrators ORDER BY city;
+SELECT city FROM integrators GROUP BY city ORDER BY collation_key(city) COLLATE "C";
 
 -- Добавление интегратора (используется с параметрами)
 -- QUERY: ADD_INTEGRATOR
@@ -178,6 +184,10 @@ SELECT id, username, password_hash, is_admin FROM users WHERE username = $1;
 -- QUERY: CREATE_USER
 INSERT INTO users (username, password_hash, is_admin) VALUES ($1, $2, $3);
 
+-- Замена хеша пароля (перехеширование при входе)
+-- QUERY: UPDATE_PASSWORD_HASH
+UPDATE users SET password_hash = $2 WHERE id = $1;
+
 -- Создание сессии
 -- QUERY: CREATE_SESSION
 INSERT INTO sessions (session_id, user_id, expires_at) VALUES ($1, $2, NOW() + INTERVAL '24 hours');
@@ -197,6 +207,44 @@ DELETE FROM sessions WHERE session_id = $1;
 -- QUERY: DELETE_USER_SESSIONS
 DELETE FROM sessions WHERE user_id = $1;
 
+-- Отзыв одного подписанного токена до конца его срока ($3 - unix-время)
+-- QUERY: REVOKE_SESSION_TOKEN
+INSERT INTO session_revocations (token_id, user_id, expires_at)
+VALUES ($1, $2, to_timestamp($3))
+ON CONFLICT (token_id) DO NOTHING;
+
+-- Отзыв всех подписанных токенов пользователя (время жизни токена - 24 часа)
+-- QUERY: REVOKE_USER_TOKENS
+INSERT INTO session_revocations (user_id, expires_at) VALUES ($1, NOW() + INTERVAL '24 hours');
+
+-- Очистка просроченных сессий пачкой до $1 строк. Строки, заблокированные
+-- другими транзакциями, пропускаются: очистка никого не ждёт, а блокирует
+-- не больше одной пачки на время короткой транзакции
+-- QUERY: DELETE_EXPIRED_SESSIONS
+DELETE FROM sessions WHERE id IN (
+    SELECT id FROM sessions
+    WHERE expires_at <= NOW()
+    ORDER BY expires_at
+    LIMIT $1
+    FOR UPDATE SKIP LOCKED
+);
+
+-- Очистка записей об отзыве, переживших срок отозванных токенов
+-- QUERY: DELETE_EXPIRED_SESSION_REVOCATIONS
+DELETE FROM session_revocations WHERE id IN (
+    SELECT id FROM session_revocations
+    WHERE expires_at <= NOW()
+    ORDER BY expires_at
+    LIMIT $1
+    FOR UPDATE SKIP LOCKED
+);
+
+-- Действующие записи об отзыве токенов
+-- QUERY: GET_SESSION_REVOCATIONS
+SELECT COALESCE(token_id, ''), user_id, EXTRACT(EPOCH FROM revoked_at)::BIGINT
+FROM session_revocations
+WHERE expires_at > NOW();
+
 -- Добавление/обновление рейтинга (upsert)
 -- QUERY: UPSERT_RATING
 INSERT INTO ratings (integrator_id, user_id, rating, comment)
@@ -214,6 +262,14 @@ JOIN users u ON r.user_id = u.id
 WHERE r.integrator_id = $1
 ORDER BY r.created_at DESC;
 
+-- Получение рейтингов нескольких интеграторов (страница каталога) одним запросом
+-- QUERY: GET_RATINGS_BY_INTEGRATORS
+SELECT r.id, r.integrator_id, r.user_id, r.rating, r.comment, r.created_at, u.username
+FROM ratings r
+JOIN users u ON r.user_id = u.id
+WHERE r.integrator_id = ANY($1::int[])
+ORDER BY r.integrator_id, r.created_at DESC;
+
 -- Получение агрегированной статистики рейтингов по всем интеграторам
 -- QUERY: GET_RATING_STATS
 SELECT integrator_id, AVG(rating) AS avg_rating, COUNT(*) AS rating_count
@@ -227,15 +283,15 @@ ON CONFLICT (username) DO NOTHING;
 
 -- Получение всех стран
 -- QUERY: GET_ALL_COUNTRIES
-SELECT id, name FROM countries ORDER BY name;
+SELECT id, name FROM countries ORDER BY collation_key(name) COLLATE "C";
 
 -- Получение всех продуктов
 -- QUERY: GET_ALL_PRODUCTS
-SELECT id, name FROM products ORDER BY name;
+SELECT id, name FROM products ORDER BY collation_key(name) COLLATE "C";
 
 -- Получение всех услуг
 -- QUERY: GET_ALL_SERVICES
-SELECT id, name FROM services ORDER BY name;
+SELECT id, name FROM services ORDER BY collation_key(name) COLLATE "C";
 
 -- Добавление лицензии
 -- QUERY: ADD_LICENSE
@@ -283,15 +339,15 @@ SELECT certificate_name, certificate_number, issued_by FROM certificates WHERE i
 
 -- Получение всех стран с ID
 -- QUERY: GET_ALL_COUNTRIES_WITH_ID
-SELECT id, name FROM countries ORDER BY name;
+SELECT id, name FROM countries ORDER BY collation_key(name) COLLATE "C";
 
 -- Получение всех продуктов с ID
 -- QUERY: GET_ALL_PRODUCTS_WITH_ID
-SELECT id, name FROM products ORDER BY name;
+SELECT id, name FROM products ORDER BY collation_key(name) COLLATE "C";
 
 -- Получение всех услуг с ID
 -- QUERY: GET_ALL_SERVICES_WITH_ID
-SELECT id, name FROM services ORDER BY name;
+SELECT id, name FROM services ORDER BY collation_key(name) COLLATE "C";
 
 -- Добавление лицензии
 -- QUERY: ADD_LICENSE
@@ -0,0 +1,208 @@
+#include "api.h"
+#include "http_utils.h"
+#include "listing.h"
+#include "response_stream.h"
+#include "tracing.h"
+#include <algorithm>
+
+namespace {
+
+const char JSON_CONTENT_TYPE[] = "application/json; charset=utf-8";
+
+// Неотрицательное целое из строки целиком; false - не число
+bool parseId(std::string_view text, int& id) {
+    if (text.empty() || text.size() > 9) return false;
+    id = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        id = id * 10 + (c - '0');
+    }
+    return true;
+}
+
+void writeNameList(JsonWriter& json, const Dictionary& dictionary, const std::vector<int>& ids) {
+    json.beginArray();
+    for (int id : ids) {
+        const std::string* name = dictionary.find(id);
+        if (name) json.value(*name);
+    }
+    json.endArray();
+}
+
+void writeDictionary(JsonWriter& json, const Dictionary& dictionary) {
+    json.beginObject().key("items").beginArray();
+    for (const auto& entry : dictionary.all()) {
+        json.beginObject().key("id").value(entry.first).key("name").value(entry.second).endObject();
+    }
+    json.endArray().endObject();
+}
+
+size_t sendError(int clientSocket, int statusCode, const char* error) {
+    ResponseStream stream(clientSocket, statusCode, JSON_CONTENT_TYPE);
+    JsonWriter(stream.body()).beginObject().key("error").value(error).endObject();
+    return stream.finish();
+}
+
+} // namespace
+
+ApiEndpoint parseApiEndpoint(std::string_view request, int& id) {
+    const std::string_view prefix = "GET /api/";
+    if (request.compare(0, prefix.size(), prefix) != 0) {
+        return ApiEndpoint::None;
+    }
+    size_t end = request.find_first_of(" ?", prefix.size());
+    if (end == std::string_view::npos) end = request.size();
+    std::string_view path = request.substr(prefix.size(), end - prefix.size());
+
+    if (path == "integrators") return ApiEndpoint::Integrators;
+    if (path == "countries") return ApiEndpoint::Countries;
+    if (path == "products") return ApiEndpoint::Products;
+    if (path == "services") return ApiEndpoint::Services;
+
+    const std::string_view collection = "integrators/";
+    if (path.compare(0, collection.size(), collection) != 0) {
+        return ApiEndpoint::None;
+    }
+    std::string_view rest = path.substr(collection.size());
+    size_t slash = rest.find('/');
+    if (!parseId(rest.substr(0, slash), id)) {
+        return ApiEndpoint::None;
+    }
+    if (slash == std::string_view::npos) return ApiEndpoint::Integrator;
+    if (rest.substr(slash) == "/ratings") return ApiEndpoint::Ratings;
+    return ApiEndpoint::None;
+}
+
+void writeIntegratorJson(JsonWriter& json, const Integrator& integrator, const CatalogSnapshot& catalog,
+                         const RatingStats* stats) {
+    json.beginObject()
+        .key("id").value(integrator.id)
+        .key("name").value(integrator.name)
+        .key("city").value(integrator.city)
+        .key("country").value(catalog.countries.name(integrator.countryId))
+        .key("website").value(integrator.website)
+        .key("description").value(integrator.description);
+    json.key("products");
+    writeNameList(json, catalog.products, integrator.productIds);
+    json.key("services");
+    writeNameList(json, catalog.services, integrator.serviceIds);
+
+    json.key("licenses").beginArray();
+    for (const auto& license : integrator.licenses) {
+        json.beginObject()
+            .key("number").value(license.number)
+            .key("issued_by").value(license.issuedBy)
+            .endObject();
+    }
+    json.endArray();
+    json.key("certificates").beginArray();
+    for (const auto& cert : integrator.certificates) {
+        json.beginObject()
+            .key("name").value(cert.name)
+            .key("number").value(cert.number)
+            .key("issued_by").value(cert.issuedBy)
+            .endObject();
+    }
+    json.endArray();
+
+    json.key("rating").beginObject()
+        .key("average").value(stats ? stats->average : 0.0)
+        .key("count").value(stats ? stats->count : 0)
+        .endObject();
+    json.endObject();
+}
+
+void writeRatingJson(JsonWriter& json, const Rating& rating) {
+    json.beginObject()
+        .key("id").value(rating.id)
+        .key("user").value(rating.username)
+        .key("value").value(rating.value)
+        .key("comment").value(rating.comment)
+        .key("created_at").value(rating.createdAt)
+        .endObject();
+}
+
+size_t serveApiRequest(int clientSocket, std::string_view request, ApiEndpoint endpoint, int id,
+                       Database& db, Catalog& catalog, bool searchIndexAvailable,
+                       const std::string& validatorHeaders) {
+    std::shared_ptr<const CatalogSnapshot> snapshot = catalog.get(db);
+
+    switch (endpoint) {
+        case ApiEndpoint::Integrators: {
+            ListingQuery query = parseListingQuery(request, searchIndexAvailable);
+            // Страница приводит per_page к допустимому, API сообщает об ошибке
+            int pageSize = 0;
+            std::string perPage = getQueryParam(request, "per_page");
+            if (!perPage.empty() && (!parseId(perPage, pageSize) || pageSize < 1 || pageSize > LISTING_MAX_PAGE_SIZE)) {
+                return sendError(clientSocket, 400, "invalid_per_page");
+            }
+            ListingPage listing = buildListingPage(db, *snapshot, catalog.ratings(db, snapshot), query);
+
+            TraceSpan span("render.apiIntegrators");
+            ResponseStream stream(clientSocket, 200, JSON_CONTENT_TYPE);
+            stream.addHeaders(validatorHeaders);
+            JsonWriter json(stream.body());
+            json.beginObject()
+                .key("page").value(listing.page)
+                .key("per_page").value(query.pageSize)
+                .key("total").value(listing.total)
+                .key("total_pages").value(listing.totalPages)
+                .key("sort").value(query.sort)
+                .key("items").beginArray();
+            for (const Integrator* integrator : listing.items) {
+                auto stats = listing.ratingStats().find(integrator->id);
+                writeIntegratorJson(json, *integrator, *snapshot, stats == listing.ratingStats().end() ? nullptr : &stats->second);
+                stream.flush();
+                if (!stream.ok()) break;
+            }
+            json.endArray().endObject();
+            return stream.finish();
+        }
+        case ApiEndpoint::Integrator: {
+            const Integrator* integrator = snapshot->findById(id);
+            if (!integrator) {
+                return sendError(clientSocket, 404, "not_found");
+            }
+            std::shared_ptr<const RatingSnapshot> ratings = catalog.ratings(db, snapshot);
+            auto stats = ratings->stats.find(id);
+            ResponseStream stream(clientSocket, 200, JSON_CONTENT_TYPE);
+            stream.addHeaders(validatorHeaders);
+            JsonWriter json(stream.body());
+            writeIntegratorJson(json, *integrator, *snapshot, stats == ratings->stats.end() ? nullptr : &stats->second);
+            return stream.finish();
+        }
+        case ApiEndpoint::Ratings: {
+            if (!snapshot->findById(id)) {
+                return sendError(clientSocket, 404, "not_found");
+            }
+            std::vector<Rating> ratings = db.getRatingsByIntegrator(id);
+            ResponseStream stream(clientSocket, 200, JSON_CONTENT_TYPE);
+            stream.addHeaders(validatorHeaders);
+            JsonWriter json(stream.body());
+            json.beginObject()
+                .key("integrator_id").value(id)
+                .key("total").value(static_cast<int>(ratings.size()))
+                .key("items").beginArray();
+            for (const auto& rating : ratings) {
+                writeRatingJson(json, rating);
+                stream.flush();
+                if (!stream.ok()) break;
+            }
+            json.endArray().endObject();
+            return stream.finish();
+        }
+        case ApiEndpoint::Countries:
+        case ApiEndpoint::Products:
+        case ApiEndpoint::Services: {
+            ResponseStream stream(clientSocket, 200, JSON_CONTENT_TYPE);
+            stream.addHeaders(validatorHeaders);
+            JsonWriter json(stream.body());
+            writeDictionary(json, endpoint == ApiEndpoint::Countries ? snapshot->countries
+                                  : endpoint == ApiEndpoint::Products ? snapshot->products
+                                  : snapshot->services);
+            return stream.finish();
+        }
+        default:
+            return sendError(clientSocket, 404, "not_found");
+    }
+}
@@ -0,0 +1,103 @@
+#include "catalog.h"
+#include "data_versions.h"
+#include "logger.h"
+#include "tracing.h"
+#include <chrono>
+
+const Integrator* CatalogSnapshot::findById(int id) const {
+    auto it = rowById.find(id);
+    return it == rowById.end() ? nullptr : &integrators[it->second];
+}
+
+void Catalog::invalidate() {
+    std::lock_guard<std::mutex> lock(mutex);
+    dirty = true;
+}
+
+std::shared_ptr<const CatalogSnapshot> Catalog::get(Database& db) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Версия читается до загрузки: изменение во время загрузки вызовет ещё одну
+    uint64_t version = DataVersions::instance().catalog();
+    if (!dirty && snapshot && snapshotVersion == version) {
+        metrics.hits.add();
+        return snapshot;
+    }
+    metrics.misses.add();
+    TraceSpan span("catalog.reload");
+
+    auto start = std::chrono::steady_clock::now();
+
+    auto fresh = std::make_shared<CatalogSnapshot>();
+    fresh->integrators = db.getAllIntegrators();
+    fresh->cities = db.getAllCities();
+    fresh->countries = Dictionary(db.getAllCountries());
+    fresh->products = Dictionary(db.getAllProducts());
+    fresh->services = Dictionary(db.getAllServices());
+    for (uint32_t row = 0; row < fresh->integrators.size(); row++) {
+        fresh->rowById[fresh->integrators[row].id] = row;
+    }
+    fresh->index.build(fresh->integrators);
+    fresh->columns.build(fresh->integrators);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    LOG_INFO("Каталог загружен")
+        .field("integrators", fresh->integrators.size())
+        .field("index_kb", fresh->index.memoryUsage() / 1024)
+        .field("columns_kb", fresh->columns.memoryUsage() / 1024)
+        .field("dictionaries_kb", (fresh->countries.memoryUsage() + fresh->products.memoryUsage() +
+                                   fresh->services.memoryUsage()) / 1024)
+        .field("duration_ms", static_cast<long long>(elapsed.count()));
+
+    snapshot = fresh;
+    snapshotVersion = version;
+    dirty = false;
+    return snapshot;
+}
+
+std::shared_ptr<const RatingSnapshot> Catalog::ratings(Database& db, const std::shared_ptr<const CatalogSnapshot>& snapshot) {
+    std::lock_guard<std::mutex> lock(ratingsMutex);
+    uint64_t version = DataVersions::instance().ratings();
+    std::shared_ptr<const RatingSnapshot> previous = ratingSnapshot;
+    if (previous && previous->catalog == snapshot && ratingsVersion == version) {
+        ratingsMetrics.hits.add();
+        return previous;
+    }
+    ratingsMetrics.misses.add();
+    TraceSpan span("catalog.ratings");
+
+    auto fresh = std::make_shared<RatingSnapshot>();
+    fresh->catalog = snapshot;
+    fresh->stats = db.getRatingStats();
+    fresh->averages.assign(snapshot->integrators.size(), 0.0);
+    for (const auto& entry : fresh->stats) {
+        auto it = snapshot->rowById.find(entry.first);
+        if (it != snapshot->rowById.end()) fresh->averages[it->second] = entry.second.average;
+    }
+
+    // Для того же снимка переставляются только строки с изменившейся средней
+    const CatalogColumns& columns = snapshot->columns;
+    std::vector<uint32_t> changedRows;
+    bool incremental = previous && previous->catalog == snapshot;
+    if (incremental) {
+        for (uint32_t row = 0; row < fresh->averages.size(); row++) {
+            if (fresh->averages[row] != previous->averages[row]) changedRows.push_back(row);
+        }
+        incremental = changedRows.size() * 4 < fresh->averages.size();
+    }
+    if (incremental) {
+        fresh->byRatingDesc = previous->byRatingDesc;
+        fresh->byRatingAsc = previous->byRatingAsc;
+        columns.updateRatingOrdering(fresh->byRatingDesc, CatalogOrder::RatingDesc, fresh->averages, changedRows);
+        columns.updateRatingOrdering(fresh->byRatingAsc, CatalogOrder::RatingAsc, fresh->averages, changedRows);
+    } else {
+        columns.buildRatingOrdering(fresh->byRatingDesc, CatalogOrder::RatingDesc, fresh->averages);
+        columns.buildRatingOrdering(fresh->byRatingAsc, CatalogOrder::RatingAsc, fresh->averages);
+    }
+    LOG_DEBUG("Оценки каталога обновлены")
+        .field("ratings", fresh->stats.size())
+        .field("changed", incremental ? static_cast<long long>(changedRows.size()) : -1LL);
+
+    ratingSnapshot = fresh;
+    ratingsVersion = version;
+    return ratingSnapshot;
+}
@@ -0,0 +1,188 @@
+#include "catalog_columns.h"
+#include "collation.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Основной признак и место по названию; место уникально, поэтому ключи
+// разных строк не равны и сортировка детерминирована
+struct SortKey {
+    uint64_t primary;
+    uint32_t nameRank;
+
+    bool operator<(const SortKey& other) const {
+        return primary != other.primary ? primary < other.primary : nameRank < other.nameRank;
+    }
+};
+
+// Для неотрицательных double порядок битового представления совпадает с порядком чисел
+uint64_t ratingBits(double average) {
+    uint64_t bits;
+    memcpy(&bits, &average, sizeof(bits));
+    return average > 0 ? bits : 0;
+}
+
+SortKey makeKey(CatalogOrder order, uint32_t cityId, uint32_t nameRank, double average) {
+    switch (order) {
+        case CatalogOrder::NameAsc: return {0, nameRank};
+        case CatalogOrder::NameDesc: return {0, ~nameRank};
+        case CatalogOrder::CityAsc: return {cityId, nameRank};
+        case CatalogOrder::CityDesc: return {~static_cast<uint64_t>(cityId), nameRank};
+        case CatalogOrder::RatingAsc: return {ratingBits(average), nameRank};
+        case CatalogOrder::RatingDesc: return {~ratingBits(average), nameRank};
+    }
+    return {0, nameRank};
+}
+
+void fillPositions(CatalogOrdering& ordering) {
+    ordering.positions.resize(ordering.rows.size());
+    for (uint32_t position = 0; position < ordering.rows.size(); position++) {
+        ordering.positions[ordering.rows[position]] = position;
+    }
+}
+
+// Доля строк, ниже которой выгоднее сортировать их места, чем обходить порядок
+const size_t SPARSE_ROWS_DIVISOR = 16;
+
+} // namespace
+
+void CatalogColumns::build(const std::vector<Integrator>& integrators) {
+    uint32_t count = static_cast<uint32_t>(integrators.size());
+
+    // Ключи сортировки считаются один раз на загрузку; дальше сравнение - memcmp
+    std::vector<std::string> nameKeys(count);
+    for (uint32_t row = 0; row < count; row++) nameKeys[row] = collationKey(integrators[row].name);
+    byName.rows.resize(count);
+    for (uint32_t row = 0; row < count; row++) byName.rows[row] = row;
+    std::stable_sort(byName.rows.begin(), byName.rows.end(), [&](uint32_t a, uint32_t b) {
+        return nameKeys[a] < nameKeys[b];
+    });
+    fillPositions(byName);
+
+    std::vector<std::pair<std::string, std::string>> cities;   // ключ и название
+    cities.reserve(count);
+    for (const auto& integrator : integrators) cities.emplace_back(collationKey(integrator.city), integrator.city);
+    std::sort(cities.begin(), cities.end());
+    cities.erase(std::unique(cities.begin(), cities.end()), cities.end());
+    cityIdByName.clear();
+    cityIdByName.reserve(cities.size());
+    for (uint32_t id = 0; id < cities.size(); id++) cityIdByName.emplace(std::move(cities[id].second), id);
+    cityIds.resize(count);
+    for (uint32_t row = 0; row < count; row++) cityIds[row] = cityIdByName.at(integrators[row].city);
+
+    byNameDesc.rows.assign(byName.rows.rbegin(), byName.rows.rend());
+    fillPositions(byNameDesc);
+    std::vector<double> noAverages;
+    sortOrdering(byCity, CatalogOrder::CityAsc, noAverages);
+    sortOrdering(byCityDesc, CatalogOrder::CityDesc, noAverages);
+}
+
+uint32_t CatalogColumns::cityId(const std::string& city) const {
+    auto it = cityIdByName.find(city);
+    return it == cityIdByName.end() ? NO_CITY : it->second;
+}
+
+void CatalogColumns::filterByCity(std::vector<uint32_t>& rows, uint32_t cityId) const {
+    const uint32_t* cities = cityIds.data();
+    size_t kept = 0;
+    for (uint32_t row : rows) {
+        rows[kept] = row;
+        kept += cities[row] == cityId;
+    }
+    rows.resize(kept);
+}
+
+const CatalogOrdering& CatalogColumns::ordering(CatalogOrder order) const {
+    switch (order) {
+        case CatalogOrder::NameDesc: return byNameDesc;
+        case CatalogOrder::CityAsc: return byCity;
+        case CatalogOrder::CityDesc: return byCityDesc;
+        default: return byName;
+    }
+}
+
+void CatalogColumns::sortOrdering(CatalogOrdering& ordering, CatalogOrder order, const std::vector<double>& averages) const {
+    uint32_t count = static_cast<uint32_t>(cityIds.size());
+    std::vector<SortKey> keys(count);
+    for (uint32_t row = 0; row < count; row++) {
+        keys[row] = makeKey(order, cityIds[row], byName.positions[row], averages.empty() ? 0.0 : averages[row]);
+    }
+    std::sort(keys.begin(), keys.end());
+    ordering.rows.resize(count);
+    for (uint32_t i = 0; i < count; i++) ordering.rows[i] = byName.rows[keys[i].nameRank];
+    fillPositions(ordering);
+}
+
+void CatalogColumns::buildRatingOrdering(CatalogOrdering& ordering, CatalogOrder order,
+                                         const std::vector<double>& averages) const {
+    sortOrdering(ordering, order, averages);
+}
+
+void CatalogColumns::updateRatingOrdering(CatalogOrdering& ordering, CatalogOrder order, const std::vector<double>& averages,
+                                          const std::vector<uint32_t>& changedRows) const {
+    if (changedRows.empty()) return;
+    auto keyOf = [&](uint32_t row) { return makeKey(order, cityIds[row], byName.positions[row], averages[row]); };
+
+    // Остальные строки уже упорядочены: их ключи не менялись
+    std::vector<char> changed(ordering.rows.size(), 0);
+    for (uint32_t row : changedRows) changed[row] = 1;
+    std::vector<uint32_t> kept;
+    kept.reserve(ordering.rows.size() - changedRows.size());
+    for (uint32_t row : ordering.rows) {
+        if (!changed[row]) kept.push_back(row);
+    }
+    std::vector<uint32_t> moved = changedRows;
+    std::sort(moved.begin(), moved.end(), [&](uint32_t a, uint32_t b) { return keyOf(a) < keyOf(b); });
+
+    std::merge(kept.begin(), kept.end(), moved.begin(), moved.end(), ordering.rows.begin(),
+               [&](uint32_t a, uint32_t b) { return keyOf(a) < keyOf(b); });
+    fillPositions(ordering);
+}
+
+size_t CatalogColumns::memoryUsage() const {
+    size_t bytes = cityIds.capacity() * sizeof(uint32_t);
+    for (const CatalogOrdering* ordering : {&byName, &byNameDesc, &byCity, &byCityDesc}) {
+        bytes += (ordering->rows.capacity() + ordering->positions.capacity()) * sizeof(uint32_t);
+    }
+    for (const auto& city : cityIdByName) bytes += city.first.capacity() + sizeof(city);
+    return bytes;
+}
+
+void selectOrderedPage(const CatalogOrdering& ordering, const std::vector<uint32_t>& rows, size_t start, size_t count,
+                       std::vector<uint32_t>& page) {
+    page.clear();
+    size_t total = ordering.rows.size();
+    if (start >= rows.size()) return;
+    count = std::min(count, rows.size() - start);
+    page.reserve(count);
+
+    // Без фильтров страница - готовый срез порядка
+    if (rows.size() == total) {
+        page.assign(ordering.rows.begin() + start, ordering.rows.begin() + start + count);
+        return;
+    }
+
+    // Малая выборка: упорядочиваются только первые start + count мест её строк
+    if (rows.size() * SPARSE_ROWS_DIVISOR < total) {
+        std::vector<uint32_t> positions(rows.size());
+        for (size_t i = 0; i < rows.size(); i++) positions[i] = ordering.positions[rows[i]];
+        std::partial_sort(positions.begin(), positions.begin() + start + count, positions.end());
+        for (size_t i = start; i < start + count; i++) page.push_back(ordering.rows[positions[i]]);
+        return;
+    }
+
+    // Обход готового порядка с остановкой на заполненной странице
+    std::vector<uint64_t> selected((total + 63) / 64, 0);
+    for (uint32_t row : rows) selected[row >> 6] |= uint64_t(1) << (row & 63);
+    size_t skipped = 0;
+    for (uint32_t row : ordering.rows) {
+        if (!(selected[row >> 6] >> (row & 63) & 1)) continue;
+        if (skipped < start) {
+            skipped++;
+            continue;
+        }
+        page.push_back(row);
+        if (page.size() == count) break;
+    }
+}
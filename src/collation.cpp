@@ -0,0 +1,124 @@
+#include "collation.h"
+#include "utf8.h"
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+const char LEVEL_SEPARATOR = '\x01';
+
+// Буква и её значения на уровнях ключа
+struct CollationEntry {
+    uint32_t codePoint;
+    uint32_t primary;     // без регистра, ё = е
+    uint32_t secondary;   // без регистра
+    char caseWeight;      // 'a' - строчная, 'b' - прописная
+};
+
+std::vector<CollationEntry> buildTable() {
+    std::vector<CollationEntry> table;
+    for (uint32_t c = 'a'; c <= 'z'; c++) {
+        table.push_back({c, c, c, 'a'});
+        table.push_back({c - 'a' + 'A', c, c, 'b'});
+    }
+    // а..я (U+0430..U+044F) и А..Я (U+0410..U+042F) идут в кодах по алфавиту
+    for (uint32_t c = 0x0430; c <= 0x044F; c++) {
+        table.push_back({c, c, c, 'a'});
+        table.push_back({c - 0x20, c, c, 'b'});
+    }
+    table.push_back({0x0451, 0x0435, 0x0451, 'a'});   // ё
+    table.push_back({0x0401, 0x0435, 0x0451, 'b'});   // Ё
+    return table;
+}
+
+const std::vector<CollationEntry>& table() {
+    static const std::vector<CollationEntry> entries = buildTable();
+    return entries;
+}
+
+// Индекс записи по коду символа для ASCII и блока U+0400..U+045F; -1 - символа нет в таблице
+struct CollationIndex {
+    int16_t ascii[128];
+    int16_t cyrillic[0x60];
+
+    CollationIndex() {
+        for (auto& entry : ascii) entry = -1;
+        for (auto& entry : cyrillic) entry = -1;
+        const std::vector<CollationEntry>& entries = table();
+        for (size_t i = 0; i < entries.size(); i++) {
+            uint32_t c = entries[i].codePoint;
+            if (c < 128) ascii[c] = static_cast<int16_t>(i);
+            else cyrillic[c - 0x0400] = static_cast<int16_t>(i);
+        }
+    }
+
+    const CollationEntry* find(uint32_t c) const {
+        int16_t i = c < 128 ? ascii[c] : (c >= 0x0400 && c < 0x0460) ? cyrillic[c - 0x0400] : -1;
+        return i < 0 ? nullptr : &table()[i];
+    }
+};
+
+const CollationIndex& collationIndex() {
+    static const CollationIndex index;
+    return index;
+}
+
+// Один уровень ключа: символы из таблицы заменяются, остальные копируются
+template <typename Weight>
+void appendLevel(std::string& key, std::string_view text, Weight weight) {
+    const CollationIndex& index = collationIndex();
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        // ASCII вне таблицы (цифры, пробелы, знаки) - основной случай, без декодирования
+        unsigned char byte = static_cast<unsigned char>(*p);
+        if (byte < 128 && index.ascii[byte] < 0) {
+            key += *p++;
+            continue;
+        }
+        const char* start = p;
+        uint32_t c = utf8Decode(p, end);
+        const CollationEntry* entry = index.find(c);
+        if (entry) {
+            weight(key, *entry);
+        } else {
+            key.append(start, p - start);
+        }
+    }
+}
+
+} // namespace
+
+void appendCollationKey(std::string& key, std::string_view text) {
+    key.reserve(key.size() + text.size() * 3 + 2);
+    appendLevel(key, text, [](std::string& out, const CollationEntry& entry) { utf8Append(out, entry.primary); });
+    key += LEVEL_SEPARATOR;
+    appendLevel(key, text, [](std::string& out, const CollationEntry& entry) { utf8Append(out, entry.secondary); });
+    key += LEVEL_SEPARATOR;
+    appendLevel(key, text, [](std::string& out, const CollationEntry& entry) { out += entry.caseWeight; });
+}
+
+std::string collationKey(std::string_view text) {
+    std::string key;
+    appendCollationKey(key, text);
+    return key;
+}
+
+std::string collationKeyFunctionSql() {
+    std::string from;
+    std::string primary;
+    std::string secondary;
+    std::string caseWeights;
+    for (const CollationEntry& entry : table()) {
+        utf8Append(from, entry.codePoint);
+        utf8Append(primary, entry.primary);
+        utf8Append(secondary, entry.secondary);
+        caseWeights += entry.caseWeight;
+    }
+    // В таблице нет кавычек и обратной косой черты, строки вставляются без экранирования
+    return "CREATE OR REPLACE FUNCTION collation_key(t TEXT) RETURNS TEXT AS $$ "
+           "SELECT translate(t, '" + from + "', '" + primary + "') || chr(1) || "
+           "translate(t, '" + from + "', '" + secondary + "') || chr(1) || "
+           "translate(t, '" + from + "', '" + caseWeights + "') "
+           "$$ LANGUAGE sql IMMUTABLE STRICT;";
+}
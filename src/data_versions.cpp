@@ -0,0 +1,55 @@
+#include "data_versions.h"
+#include <cstdio>
+#include <ctime>
+#include <random>
+
+DataVersions::DataVersions() : modifiedAt(time(nullptr)) {
+    std::random_device random;
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%llx%08x", static_cast<unsigned long long>(time(nullptr)), random());
+    epoch = buffer;
+}
+
+DataVersions& DataVersions::instance() {
+    static DataVersions versions;
+    return versions;
+}
+
+void DataVersions::bump(DataScope scope) {
+    modifiedAt.store(time(nullptr), std::memory_order_release);
+    (scope == DataScope::Catalog ? catalogVersion : ratingsVersion).fetch_add(1, std::memory_order_acq_rel);
+}
+
+std::string DataVersions::weakETag(std::string_view variant) const {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : variant) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "W/\"%s.%llu.%llu.%016llx\"", epoch.c_str(),
+             static_cast<unsigned long long>(catalog()), static_cast<unsigned long long>(ratings()),
+             static_cast<unsigned long long>(hash));
+    return buffer;
+}
+
+bool etagMatches(std::string_view ifNoneMatch, std::string_view etag) {
+    // Слабое сравнение: префикс W/ не учитывается
+    auto opaque = [](std::string_view tag) {
+        if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+        return tag;
+    };
+    std::string_view target = opaque(etag);
+    size_t pos = 0;
+    while (pos < ifNoneMatch.size()) {
+        size_t end = ifNoneMatch.find(',', pos);
+        if (end == std::string_view::npos) end = ifNoneMatch.size();
+        std::string_view candidate = ifNoneMatch.substr(pos, end - pos);
+        while (!candidate.empty() && (candidate.front() == ' ' || candidate.front() == '\t')) candidate.remove_prefix(1);
+        while (!candidate.empty() && (candidate.back() == ' ' || candidate.back() == '\t')) candidate.remove_suffix(1);
+        if (candidate == "*" || opaque(candidate) == target) {
+            return true;
+        }
+        pos = end + 1;
+    }
+    return false;
+}
@@ -1,8 +1,15 @@
 #include "database.h"
+#include "metrics.h"
+#include "logger.h"
+#include "tracing.h"
+#include "slow_query_log.h"
+#include "data_versions.h"
+#include "collation.h"
 #include <iostream>
 #include <cstring>
 #include <fstream>
 #include <sstream>
+#include <chrono>
 
 Database::Database(const std::string& host, const std::string& port, 
                    const std::string& dbname, const std::string& user, 
@@ -13,6 +20,7 @@ Database::Database(const std::string& host, const std::string& port,
                       " user=" + user + 
                       " password=" + password;
     conn = nullptr;
+    searchIndexAvailable = false;
     loadQueries("sql/queries.sql");
 }
 
@@ -143,11 +151,42 @@ bool Database::loadQueries(const std::string& filename) {
     }
     
     file.close();
+    
+    // Метрики регистрируются сразу для всех запросов, чтобы /metrics показывал и невызванные
+    for (const auto& query : queries) {
+        queryMetrics[query.first] = &MetricsRegistry::instance().query(query.first);
+    }
+    
     std::cout << "Загружено SQL запросов: " << queries.size() << std::endl;
     return true;
 }
 
-bool Database::connect() {
+PGresult* Database::execNamed(const std::string& key, int paramCount, const char* const* paramValues) {
+    QueryMetrics& metrics = *queryMetrics.at(key);
+    auto query = queries.find(key);
+    TraceSpan span(query->first.c_str());
+    auto start = std::chrono::steady_clock::now();
+    
+    PGresult* res = PQexecParams(conn, query->second.c_str(), paramCount, nullptr, paramValues,
+                                 nullptr, nullptr, 0);
+    
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    metrics.calls.add();
+    metrics.latency.record(elapsed.count());
+    ExecStatusType status = PQresultStatus(res);
+    if (status != PGRES_TUPLES_OK && status != PGRES_COMMAND_OK) {
+        metrics.errors.add();
+    }
+    
+    SlowQueryLog& slowQueries = SlowQueryLog::instance();
+    if (static_cast<uint64_t>(elapsed.count()) >= slowQueries.thresholdMicros()) {
+        long long rows = status == PGRES_TUPLES_OK ? PQntuples(res) : atoll(PQcmdTuples(res));
+        slowQueries.record(key, query->second, paramCount, paramValues, elapsed.count(), rows);
+    }
+    return res;
+}
+
+bool Database::connect(bool initializeData) {
     conn = PQconnectdb(connectionString.c_str());
     
     if (PQstatus(conn) != CONNECTION_OK) {
@@ -158,7 +197,9 @@ bool Database::connect() {
     std::cout << "Подключение к БД успешно" << std::endl;
     
     // Проверяем и инициализируем данные по умолчанию, если их нет
-    initializeDefaultData();
+    if (initializeData) {
+        initializeDefaultData();
+    }
     
     return true;
 }
@@ -170,42 +211,72 @@ void Database::disconnect() {
     }
 }
 
+namespace {
+
+// Список id через запятую (string_agg в запросах интеграторов)
+std::vector<int> parseIdList(const char* text) {
+    std::vector<int> ids;
+    int value = 0;
+    bool inNumber = false;
+    for (const char* p = text; ; p++) {
+        if (*p >= '0' && *p <= '9') {
+            value = value * 10 + (*p - '0');
+            inNumber = true;
+        } else {
+            if (inNumber) ids.push_back(value);
+            value = 0;
+            inNumber = false;
+            if (*p == '\0') break;
+        }
+    }
+    return ids;
+}
+
+// Поля интегратора из строки результата GET_ALL_INTEGRATORS и похожих запросов;
+// лицензии и сертификаты загружаются отдельно
+Integrator readIntegratorRow(PGresult* res, int row) {
+    Integrator integrator;
+    integrator.id = std::stoi(PQgetvalue(res, row, 0));
+    integrator.name = PQgetvalue(res, row, 1);
+    integrator.city = PQgetvalue(res, row, 2);
+    integrator.description = PQgetvalue(res, row, 3);
+    integrator.website = PQgetvalue(res, row, 4);
+    integrator.countryId = atoi(PQgetvalue(res, row, 5));
+    integrator.productIds = parseIdList(PQgetvalue(res, row, 6));
+    integrator.serviceIds = parseIdList(PQgetvalue(res, row, 7));
+    return integrator;
+}
+
+} // namespace
+
 std::vector<Integrator> Database::getAllIntegrators() {
+    TraceSpan span("db.getAllIntegrators");
     std::vector<Integrator> integrators;
     
     if (queries.find("GET_ALL_INTEGRATORS") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_ALL_INTEGRATORS не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "GET_ALL_INTEGRATORS");
         return integrators;
     }
     
-    const char* query = queries["GET_ALL_INTEGRATORS"].c_str();
-    
-    PGresult* res = PQexec(conn, query);
+    PGresult* res = execNamed("GET_ALL_INTEGRATORS", 0, nullptr);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "Ошибка запроса: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка запроса").field("error", PQerrorMessage(conn));
         PQclear(res);
         return integrators;
     }
     
     int rows = PQntuples(res);
+    integrators.reserve(rows);
     
     for (int i = 0; i < rows; i++) {
-        Integrator integrator;
-        integrator.id = std::stoi(PQgetvalue(res, i, 0));
-        integrator.name = PQgetvalue(res, i, 1);
-        integrator.city = PQgetvalue(res, i, 2);
-        integrator.description = PQgetvalue(res, i, 3);
-        integrator.website = PQgetvalue(res, i, 4) ? PQgetvalue(res, i, 4) : "";
-        integrator.country = PQgetvalue(res, i, 5) ? PQgetvalue(res, i, 5) : "";
-        integrator.products = PQgetvalue(res, i, 6) ? PQgetvalue(res, i, 6) : "";
-        integrator.services = PQgetvalue(res, i, 7) ? PQgetvalue(res, i, 7) : "";
+        Integrator integrator = readIntegratorRow(res, i);
         
         // Загружаем лицензии и сертификаты отдельно
         integrator.licenses = getLicensesByIntegrator(integrator.id);
         integrator.certificates = getCertificatesByIntegrator(integrator.id);
         
-        integrators.push_back(integrator);
+        integrators.push_back(std::move(integrator));
     }
     
     PQclear(res);
@@ -213,44 +284,35 @@ std::vector<Integrator> Database::getAllIntegrators() {
 }
 
 std::vector<Integrator> Database::getIntegratorsByCity(const std::string& city) {
+    TraceSpan span("db.getIntegratorsByCity");
     std::vector<Integrator> integrators;
     
     if (queries.find("GET_INTEGRATORS_BY_CITY") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_INTEGRATORS_BY_CITY не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "GET_INTEGRATORS_BY_CITY");
         return integrators;
     }
     
-    const char* query = queries["GET_INTEGRATORS_BY_CITY"].c_str();
-    
     const char* paramValues[1] = { city.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("GET_INTEGRATORS_BY_CITY", 1, paramValues);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "Ошибка запроса: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка запроса").field("error", PQerrorMessage(conn));
         PQclear(res);
         return integrators;
     }
     
     int rows = PQntuples(res);
+    integrators.reserve(rows);
     
     for (int i = 0; i < rows; i++) {
-        Integrator integrator;
-        integrator.id = std::stoi(PQgetvalue(res, i, 0));
-        integrator.name = PQgetvalue(res, i, 1);
-        integrator.city = PQgetvalue(res, i, 2);
-        integrator.description = PQgetvalue(res, i, 3);
-        integrator.website = PQgetvalue(res, i, 4) ? PQgetvalue(res, i, 4) : "";
-        integrator.country = PQgetvalue(res, i, 5) ? PQgetvalue(res, i, 5) : "";
-        integrator.products = PQgetvalue(res, i, 6) ? PQgetvalue(res, i, 6) : "";
-        integrator.services = PQgetvalue(res, i, 7) ? PQgetvalue(res, i, 7) : "";
+        Integrator integrator = readIntegratorRow(res, i);
         
         // Загружаем лицензии и сертификаты отдельно
         integrator.licenses = getLicensesByIntegrator(integrator.id);
         integrator.certificates = getCertificatesByIntegrator(integrator.id);
         
-        integrators.push_back(integrator);
+        integrators.push_back(std::move(integrator));
     }
     
     PQclear(res);
@@ -258,66 +320,85 @@ std::vector<Integrator> Database::getIntegratorsByCity(const std::string& city)
 }
 
 std::vector<Integrator> Database::searchIntegratorsByCity(const std::string& cityPattern) {
+    TraceSpan span("db.searchIntegratorsByCity");
     std::vector<Integrator> integrators;
     
     if (queries.find("SEARCH_INTEGRATORS_BY_CITY") == queries.end()) {
-        std::cerr << "Ошибка: запрос SEARCH_INTEGRATORS_BY_CITY не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "SEARCH_INTEGRATORS_BY_CITY");
         return integrators;
     }
     
-    const char* query = queries["SEARCH_INTEGRATORS_BY_CITY"].c_str();
-    
     // Формируем паттерн для поиска (добавляем % для частичного совпадения)
     std::string pattern = "%" + cityPattern + "%";
     const char* paramValues[1] = { pattern.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("SEARCH_INTEGRATORS_BY_CITY", 1, paramValues);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "Ошибка запроса: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка запроса").field("error", PQerrorMessage(conn));
         PQclear(res);
         return integrators;
     }
     
     int rows = PQntuples(res);
+    integrators.reserve(rows);
     
     for (int i = 0; i < rows; i++) {
-        Integrator integrator;
-        integrator.id = std::stoi(PQgetvalue(res, i, 0));
-        integrator.name = PQgetvalue(res, i, 1);
-        integrator.city = PQgetvalue(res, i, 2);
-        integrator.description = PQgetvalue(res, i, 3);
-        integrator.website = PQgetvalue(res, i, 4) ? PQgetvalue(res, i, 4) : "";
-        integrator.country = PQgetvalue(res, i, 5) ? PQgetvalue(res, i, 5) : "";
-        integrator.products = PQgetvalue(res, i, 6) ? PQgetvalue(res, i, 6) : "";
-        integrator.services = PQgetvalue(res, i, 7) ? PQgetvalue(res, i, 7) : "";
+        Integrator integrator = readIntegratorRow(res, i);
         
         // Загружаем лицензии и сертификаты отдельно
         integrator.licenses = getLicensesByIntegrator(integrator.id);
         integrator.certificates = getCertificatesByIntegrator(integrator.id);
         
-        integrators.push_back(integrator);
+        integrators.push_back(std::move(integrator));
     }
     
     PQclear(res);
     return integrators;
 }
 
+std::vector<int> Database::searchIntegratorIds(const std::string& textQuery) {
+    TraceSpan span("db.searchIntegratorIds");
+    std::vector<int> ids;
+    
+    if (queries.find("SEARCH_INTEGRATOR_IDS") == queries.end()) {
+        LOG_ERROR("Запрос не найден").field("query", "SEARCH_INTEGRATOR_IDS");
+        return ids;
+    }
+    
+    const char* paramValues[1] = { textQuery.c_str() };
+    
+    PGresult* res = execNamed("SEARCH_INTEGRATOR_IDS", 1, paramValues);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("Ошибка поиска").field("error", PQerrorMessage(conn));
+        PQclear(res);
+        return ids;
+    }
+    
+    int rows = PQntuples(res);
+    ids.reserve(rows);
+    for (int i = 0; i < rows; i++) {
+        ids.push_back(std::stoi(PQgetvalue(res, i, 0)));
+    }
+    
+    PQclear(res);
+    return ids;
+}
+
 std::vector<std::string> Database::getAllCities() {
+    TraceSpan span("db.getAllCities");
     std::vector<std::string> cities;
     
     if (queries.find("GET_ALL_CITIES") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_ALL_CITIES не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "GET_ALL_CITIES");
         return cities;
     }
     
-    const char* query = queries["GET_ALL_CITIES"].c_str();
-    
-    PGresult* res = PQexec(conn, query);
+    PGresult* res = execNamed("GET_ALL_CITIES", 0, nullptr);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "Ошибка запроса: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка запроса").field("error", PQerrorMessage(conn));
         PQclear(res);
         return cities;
     }
@@ -334,18 +415,18 @@ std::vector<std::string> Database::getAllCities() {
 
 bool Database::addIntegrator(const std::string& name, const std::string& city, 
                              const std::string& description) {
+    TraceSpan span("db.addIntegrator");
     return addIntegrator(name, city, description, "", 0);
 }
 
 bool Database::addIntegrator(const std::string& name, const std::string& city, 
                              const std::string& description, const std::string& website, int countryId) {
+    TraceSpan span("db.addIntegrator");
     if (queries.find("ADD_INTEGRATOR") == queries.end()) {
-        std::cerr << "Ошибка: запрос ADD_INTEGRATOR не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "ADD_INTEGRATOR");
         return false;
     }
     
-    const char* query = queries["ADD_INTEGRATOR"].c_str();
-    
     // Подготовка параметров
     std::string websiteParam = website.empty() ? "" : website;
     std::string countryIdParam = (countryId > 0) ? std::to_string(countryId) : "";
@@ -358,11 +439,11 @@ bool Database::addIntegrator(const std::string& name, const std::string& city,
         countryIdParam.c_str()
     };
     
-    PGresult* res = PQexecParams(conn, query, 5, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("ADD_INTEGRATOR", 5, paramValues);
+    DataVersions::instance().bump(DataScope::Catalog);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK && PQresultStatus(res) != PGRES_COMMAND_OK) {
-        std::cerr << "Ошибка добавления: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка добавления").field("error", PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
@@ -373,13 +454,12 @@ bool Database::addIntegrator(const std::string& name, const std::string& city,
 
 int Database::addIntegratorAndGetId(const std::string& name, const std::string& city, 
                                     const std::string& description, const std::string& website, int countryId) {
+    TraceSpan span("db.addIntegratorAndGetId");
     if (queries.find("ADD_INTEGRATOR") == queries.end()) {
-        std::cerr << "Ошибка: запрос ADD_INTEGRATOR не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "ADD_INTEGRATOR");
         return 0;
     }
     
-    const char* query = queries["ADD_INTEGRATOR"].c_str();
-    
     std::string websiteParam = website.empty() ? "" : website;
     std::string countryIdParam = (countryId > 0) ? std::to_string(countryId) : "";
     
@@ -391,8 +471,8 @@ int Database::addIntegratorAndGetId(const std::string& name, const std::string&
         countryIdParam.c_str()
     };
     
-    PGresult* res = PQexecParams(conn, query, 5, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("ADD_INTEGRATOR", 5, paramValues);
+    DataVersions::instance().bump(DataScope::Catalog);
     
     if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
         int id = std::stoi(PQgetvalue(res, 0, 0));
@@ -412,7 +492,7 @@ int Database::addIntegratorAndGetId(const std::string& name, const std::string&
         PQclear(res);
         return 0;
     } else {
-        std::cerr << "Ошибка добавления: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка добавления").field("error", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
@@ -420,18 +500,18 @@ int Database::addIntegratorAndGetId(const std::string& name, const std::string&
 
 bool Database::updateIntegrator(int id, const std::string& name, const std::string& city, 
                                const std::string& description) {
+    TraceSpan span("db.updateIntegrator");
     return updateIntegrator(id, name, city, description, "", 0);
 }
 
 bool Database::updateIntegrator(int id, const std::string& name, const std::string& city, 
                                const std::string& description, const std::string& website, int countryId) {
+    TraceSpan span("db.updateIntegrator");
     if (queries.find("UPDATE_INTEGRATOR") == queries.end()) {
-        std::cerr << "Ошибка: запрос UPDATE_INTEGRATOR не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "UPDATE_INTEGRATOR");
         return false;
     }
     
-    const char* query = queries["UPDATE_INTEGRATOR"].c_str();
-    
     // Подготовка параметров
     std::string websiteParam = website.empty() ? "" : website;
     std::string countryIdParam = (countryId > 0) ? std::to_string(countryId) : "";
@@ -446,11 +526,11 @@ bool Database::updateIntegrator(int id, const std::string& name, const std::stri
         idStr.c_str()
     };
     
-    PGresult* res = PQexecParams(conn, query, 6, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("UPDATE_INTEGRATOR", 6, paramValues);
+    DataVersions::instance().bump(DataScope::Catalog);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        std::cerr << "Ошибка обновления: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка обновления").field("error", PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
@@ -460,21 +540,21 @@ bool Database::updateIntegrator(int id, const std::string& name, const std::stri
 }
 
 bool Database::deleteIntegrator(int id) {
+    TraceSpan span("db.deleteIntegrator");
     if (queries.find("DELETE_INTEGRATOR") == queries.end()) {
-        std::cerr << "Ошибка: запрос DELETE_INTEGRATOR не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "DELETE_INTEGRATOR");
         return false;
     }
     
-    const char* query = queries["DELETE_INTEGRATOR"].c_str();
-    
     std::string idStr = std::to_string(id);
     const char* paramValues[1] = { idStr.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("DELETE_INTEGRATOR", 1, paramValues);
+    DataVersions::instance().bump(DataScope::Catalog);
+    DataVersions::instance().bump(DataScope::Ratings);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        std::cerr << "Ошибка удаления: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка удаления").field("error", PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
@@ -483,25 +563,23 @@ bool Database::deleteIntegrator(int id) {
     return true;
 }
 
-User* Database::getUserByUsername(const std::string& username) {
+std::optional<User> Database::getUserByUsername(const std::string& username) {
+    TraceSpan span("db.getUserByUsername");
     if (queries.find("GET_USER") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_USER не найден" << std::endl;
-        return nullptr;
+        LOG_ERROR("Запрос не найден").field("query", "GET_USER");
+        return std::nullopt;
     }
     
-    const char* query = queries["GET_USER"].c_str();
-    
     const char* paramValues[1] = { username.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("GET_USER", 1, paramValues);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         PQclear(res);
-        return nullptr;
+        return std::nullopt;
     }
     
-    User* user = new User();
+    std::optional<User> user(std::in_place);
     user->id = std::stoi(PQgetvalue(res, 0, 0));
     user->username = PQgetvalue(res, 0, 1);
     user->passwordHash = PQgetvalue(res, 0, 2);
@@ -511,26 +589,49 @@ User* Database::getUserByUsername(const std::string& username) {
     return user;
 }
 
-bool Database::createUser(const std::string& username, const std::string& password, bool isAdmin) {
+bool Database::createUser(const std::string& username, const std::string& passwordHash, bool isAdmin) {
+    TraceSpan span("db.createUser");
     if (queries.find("CREATE_USER") == queries.end()) {
-        std::cerr << "Ошибка: запрос CREATE_USER не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "CREATE_USER");
         return false;
     }
     
-    const char* query = queries["CREATE_USER"].c_str();
-    
     std::string isAdminStr = isAdmin ? "true" : "false";
     const char* paramValues[3] = {
         username.c_str(),
-        password.c_str(),
+        passwordHash.c_str(),
         isAdminStr.c_str()
     };
     
-    PGresult* res = PQexecParams(conn, query, 3, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("CREATE_USER", 3, paramValues);
+    
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("Ошибка создания пользователя").field("error", PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    PQclear(res);
+    return true;
+}
+
+bool Database::updatePasswordHash(int userId, const std::string& passwordHash) {
+    TraceSpan span("db.updatePasswordHash");
+    if (queries.find("UPDATE_PASSWORD_HASH") == queries.end()) {
+        LOG_ERROR("Запрос не найден").field("query", "UPDATE_PASSWORD_HASH");
+        return false;
+    }
+    
+    std::string userIdStr = std::to_string(userId);
+    const char* paramValues[2] = {
+        userIdStr.c_str(),
+        passwordHash.c_str()
+    };
+    
+    PGresult* res = execNamed("UPDATE_PASSWORD_HASH", 2, paramValues);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        std::cerr << "Ошибка создания пользователя: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка обновления хеша пароля").field("error", PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
@@ -540,24 +641,22 @@ bool Database::createUser(const std::string& username, const std::string& passwo
 }
 
 bool Database::createSession(const std::string& sessionId, int userId) {
+    TraceSpan span("db.createSession");
     if (queries.find("CREATE_SESSION") == queries.end()) {
-        std::cerr << "Ошибка: запрос CREATE_SESSION не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "CREATE_SESSION");
         return false;
     }
     
-    const char* query = queries["CREATE_SESSION"].c_str();
-    
     std::string userIdStr = std::to_string(userId);
     const char* paramValues[2] = {
         sessionId.c_str(),
         userIdStr.c_str()
     };
     
-    PGresult* res = PQexecParams(conn, query, 2, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("CREATE_SESSION", 2, paramValues);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        std::cerr << "Ошибка создания сессии: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка создания сессии").field("error", PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
@@ -566,25 +665,23 @@ bool Database::createSession(const std::string& sessionId, int userId) {
     return true;
 }
 
-Session* Database::getSession(const std::string& sessionId) {
+std::optional<Session> Database::getSession(const std::string& sessionId) {
+    TraceSpan span("db.getSession");
     if (queries.find("GET_SESSION") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_SESSION не найден" << std::endl;
-        return nullptr;
+        LOG_ERROR("Запрос не найден").field("query", "GET_SESSION");
+        return std::nullopt;
     }
     
-    const char* query = queries["GET_SESSION"].c_str();
-    
     const char* paramValues[1] = { sessionId.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("GET_SESSION", 1, paramValues);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         PQclear(res);
-        return nullptr;
+        return std::nullopt;
     }
     
-    Session* session = new Session();
+    std::optional<Session> session(std::in_place);
     session->sessionId = PQgetvalue(res, 0, 0);
     session->userId = std::stoi(PQgetvalue(res, 0, 1));
     session->username = PQgetvalue(res, 0, 2);
@@ -595,17 +692,15 @@ Session* Database::getSession(const std::string& sessionId) {
 }
 
 bool Database::deleteSession(const std::string& sessionId) {
+    TraceSpan span("db.deleteSession");
     if (queries.find("DELETE_SESSION") == queries.end()) {
-        std::cerr << "Ошибка: запрос DELETE_SESSION не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "DELETE_SESSION");
         return false;
     }
     
-    const char* query = queries["DELETE_SESSION"].c_str();
-    
     const char* paramValues[1] = { sessionId.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("DELETE_SESSION", 1, paramValues);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
         PQclear(res);
@@ -617,21 +712,33 @@ bool Database::deleteSession(const std::string& sessionId) {
 }
 
 bool Database::deleteUserSessions(int userId) {
+    TraceSpan span("db.deleteUserSessions");
     if (queries.find("DELETE_USER_SESSIONS") == queries.end()) {
-        std::cerr << "Ошибка: запрос DELETE_USER_SESSIONS не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "DELETE_USER_SESSIONS");
         return false;
     }
     
-    const char* query = queries["DELETE_USER_SESSIONS"].c_str();
-    
     std::string userIdStr = std::to_string(userId);
     const char* paramValues[1] = { userIdStr.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, 
-                                 nullptr, nullptr, 0);
+    PGresult* res = execNamed("DELETE_USER_SESSIONS", 1, paramValues);
+    
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("Ошибка удаления сессий пользователя").field("error", PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    PQclear(res);
+    
+    // Подписанные токены не хранятся в sessions - отзываем их отдельной записью
+    if (queries.find("REVOKE_USER_TOKENS") == queries.end()) {
+        LOG_ERROR("Запрос не найден").field("query", "REVOKE_USER_TOKENS");
+        return false;
+    }
+    res = execNamed("REVOKE_USER_TOKENS", 1, paramValues);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        std::cerr << "Ошибка удаления сессий пользователя: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка отзыва токенов пользователя").field("error", PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
@@ -640,14 +747,102 @@ bool Database::deleteUserSessions(int userId) {
     return true;
 }
 
+bool Database::revokeSessionToken(const std::string& tokenId, int userId, long long expiresAt) {
+    TraceSpan span("db.revokeSessionToken");
+    if (queries.find("REVOKE_SESSION_TOKEN") == queries.end()) {
+        LOG_ERROR("Запрос не найден").field("query", "REVOKE_SESSION_TOKEN");
+        return false;
+    }
+    
+    std::string userIdStr = std::to_string(userId);
+    std::string expiresAtStr = std::to_string(expiresAt);
+    const char* paramValues[3] = {
+        tokenId.c_str(),
+        userIdStr.c_str(),
+        expiresAtStr.c_str()
+    };
+    
+    PGresult* res = execNamed("REVOKE_SESSION_TOKEN", 3, paramValues);
+    
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("Ошибка отзыва токена").field("error", PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    PQclear(res);
+    return true;
+}
+
+int Database::deleteExpiredBatch(const std::string& key, int batchSize) {
+    if (queries.find(key) == queries.end()) {
+        LOG_ERROR("Запрос не найден").field("query", key);
+        return -1;
+    }
+    
+    std::string batchSizeStr = std::to_string(batchSize);
+    const char* paramValues[1] = { batchSizeStr.c_str() };
+    
+    PGresult* res = execNamed(key, 1, paramValues);
+    
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        LOG_ERROR("Ошибка очистки просроченных строк").field("query", key).field("error", PQerrorMessage(conn));
+        PQclear(res);
+        return -1;
+    }
+    
+    int deleted = atoi(PQcmdTuples(res));
+    PQclear(res);
+    return deleted;
+}
+
+int Database::deleteExpiredSessions(int batchSize) {
+    TraceSpan span("db.deleteExpiredSessions");
+    return deleteExpiredBatch("DELETE_EXPIRED_SESSIONS", batchSize);
+}
+
+int Database::deleteExpiredSessionRevocations(int batchSize) {
+    TraceSpan span("db.deleteExpiredSessionRevocations");
+    return deleteExpiredBatch("DELETE_EXPIRED_SESSION_REVOCATIONS", batchSize);
+}
+
+bool Database::getSessionRevocations(std::vector<SessionRevocation>& revocations) {
+    TraceSpan span("db.getSessionRevocations");
+    revocations.clear();
+    
+    if (queries.find("GET_SESSION_REVOCATIONS") == queries.end()) {
+        LOG_ERROR("Запрос не найден").field("query", "GET_SESSION_REVOCATIONS");
+        return false;
+    }
+    
+    PGresult* res = execNamed("GET_SESSION_REVOCATIONS", 0, nullptr);
+    
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("Ошибка запроса отозванных токенов").field("error", PQerrorMessage(conn));
+        PQclear(res);
+        return false;
+    }
+    
+    int rows = PQntuples(res);
+    for (int i = 0; i < rows; i++) {
+        SessionRevocation revocation;
+        revocation.tokenId = PQgetvalue(res, i, 0);
+        revocation.userId = std::stoi(PQgetvalue(res, i, 1));
+        revocation.revokedAt = std::stoll(PQgetvalue(res, i, 2));
+        revocations.push_back(revocation);
+    }
+    
+    PQclear(res);
+    return true;
+}
+
 bool Database::addOrUpdateRating(int integratorId, int userId, int ratingValue, const std::string& comment) {
+    TraceSpan span("db.addOrUpdateRating");
     if (queries.find("UPSERT_RATING") == queries.end()) {
-        std::cerr << "Ошибка: запрос UPSERT_RATING не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "UPSERT_RATING");
         return false;
     }
 
-    const char* query = queries["UPSERT_RATING"].c_str();
-
     std::string integratorIdStr = std::to_string(integratorId);
     std::string userIdStr = std::to_string(userId);
     std::string ratingStr = std::to_string(ratingValue);
@@ -659,10 +854,11 @@ bool Database::addOrUpdateRating(int integratorId, int userId, int ratingValue,
         comment.c_str()
     };
 
-    PGresult* res = PQexecParams(conn, query, 4, nullptr, paramValues, nullptr, nullptr, 0);
+    PGresult* res = execNamed("UPSERT_RATING", 4, paramValues);
+    DataVersions::instance().bump(DataScope::Ratings);
 
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        std::cerr << "Ошибка сохранения рейтинга: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка сохранения рейтинга").field("error", PQerrorMessage(conn));
         PQclear(res);
         return false;
     }
@@ -671,37 +867,89 @@ bool Database::addOrUpdateRating(int integratorId, int userId, int ratingValue,
     return true;
 }
 
+namespace {
+
+// Строка результата GET_RATINGS_BY_INTEGRATOR / GET_RATINGS_BY_INTEGRATORS
+Rating readRatingRow(PGresult* res, int row) {
+    Rating r;
+    r.id = std::stoi(PQgetvalue(res, row, 0));
+    r.integratorId = std::stoi(PQgetvalue(res, row, 1));
+    r.userId = std::stoi(PQgetvalue(res, row, 2));
+    r.value = std::stoi(PQgetvalue(res, row, 3));
+    r.comment = PQgetvalue(res, row, 4);
+    r.createdAt = PQgetvalue(res, row, 5);
+    r.username = PQgetvalue(res, row, 6);
+    return r;
+}
+
+} // namespace
+
 std::vector<Rating> Database::getRatingsByIntegrator(int integratorId) {
+    TraceSpan span("db.getRatingsByIntegrator");
     std::vector<Rating> ratings;
 
     if (queries.find("GET_RATINGS_BY_INTEGRATOR") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_RATINGS_BY_INTEGRATOR не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "GET_RATINGS_BY_INTEGRATOR");
         return ratings;
     }
 
-    const char* query = queries["GET_RATINGS_BY_INTEGRATOR"].c_str();
     std::string integratorIdStr = std::to_string(integratorId);
     const char* paramValues[1] = { integratorIdStr.c_str() };
 
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, nullptr, nullptr, 0);
+    PGresult* res = execNamed("GET_RATINGS_BY_INTEGRATOR", 1, paramValues);
 
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "Ошибка запроса рейтингов: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка запроса рейтингов").field("error", PQerrorMessage(conn));
         PQclear(res);
         return ratings;
     }
 
     int rows = PQntuples(res);
     for (int i = 0; i < rows; i++) {
-        Rating r;
-        r.id = std::stoi(PQgetvalue(res, i, 0));
-        r.integratorId = std::stoi(PQgetvalue(res, i, 1));
-        r.userId = std::stoi(PQgetvalue(res, i, 2));
-        r.value = std::stoi(PQgetvalue(res, i, 3));
-        r.comment = PQgetvalue(res, i, 4);
-        r.createdAt = PQgetvalue(res, i, 5);
-        r.username = PQgetvalue(res, i, 6);
-        ratings.push_back(r);
+        ratings.push_back(readRatingRow(res, i));
+    }
+
+    PQclear(res);
+    return ratings;
+}
+
+std::map<int, std::vector<Rating>> Database::getRatingsByIntegrators(const std::vector<int>& integratorIds) {
+    TraceSpan span("db.getRatingsByIntegrators");
+    std::map<int, std::vector<Rating>> ratings;
+    if (integratorIds.empty()) {
+        return ratings;
+    }
+
+    if (queries.find("GET_RATINGS_BY_INTEGRATORS") == queries.end()) {
+        LOG_ERROR("Запрос не найден").field("query", "GET_RATINGS_BY_INTEGRATORS");
+        return ratings;
+    }
+
+    // Массив id литералом PostgreSQL: {1,2,3}
+    std::string idArray = "{";
+    for (size_t i = 0; i < integratorIds.size(); i++) {
+        if (i > 0) idArray += ',';
+        idArray += std::to_string(integratorIds[i]);
+    }
+    idArray += '}';
+    const char* paramValues[1] = { idArray.c_str() };
+
+    PGresult* res = execNamed("GET_RATINGS_BY_INTEGRATORS", 1, paramValues);
+
+    if (PQresultStatus(res) != PGRES_TUPLES_OK) {
+        LOG_ERROR("Ошибка запроса рейтингов").field("error", PQerrorMessage(conn));
+        PQclear(res);
+        return ratings;
+    }
+
+    // Пустые списки для интеграторов без отзывов - как у getRatingsByIntegrator
+    for (int id : integratorIds) {
+        ratings[id];
+    }
+    int rows = PQntuples(res);
+    for (int i = 0; i < rows; i++) {
+        Rating r = readRatingRow(res, i);
+        ratings[r.integratorId].push_back(std::move(r));
     }
 
     PQclear(res);
@@ -709,18 +957,18 @@ std::vector<Rating> Database::getRatingsByIntegrator(int integratorId) {
 }
 
 std::map<int, RatingStats> Database::getRatingStats() {
+    TraceSpan span("db.getRatingStats");
     std::map<int, RatingStats> stats;
 
     if (queries.find("GET_RATING_STATS") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_RATING_STATS не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "GET_RATING_STATS");
         return stats;
     }
 
-    const char* query = queries["GET_RATING_STATS"].c_str();
-    PGresult* res = PQexec(conn, query);
+    PGresult* res = execNamed("GET_RATING_STATS", 0, nullptr);
 
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "Ошибка запроса статистики рейтингов: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка запроса статистики рейтингов").field("error", PQerrorMessage(conn));
         PQclear(res);
         return stats;
     }
@@ -738,21 +986,21 @@ std::map<int, RatingStats> Database::getRatingStats() {
 }
 
 std::vector<License> Database::getLicensesByIntegrator(int integratorId) {
+    TraceSpan span("db.getLicensesByIntegrator");
     std::vector<License> licenses;
     
     if (queries.find("GET_LICENSES_BY_INTEGRATOR") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_LICENSES_BY_INTEGRATOR не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "GET_LICENSES_BY_INTEGRATOR");
         return licenses;
     }
     
-    const char* query = queries["GET_LICENSES_BY_INTEGRATOR"].c_str();
     std::string integratorIdStr = std::to_string(integratorId);
     const char* paramValues[1] = { integratorIdStr.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, nullptr, nullptr, 0);
+    PGresult* res = execNamed("GET_LICENSES_BY_INTEGRATOR", 1, paramValues);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "Ошибка запроса лицензий: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка запроса лицензий").field("error", PQerrorMessage(conn));
         PQclear(res);
         return licenses;
     }
@@ -770,21 +1018,21 @@ std::vector<License> Database::getLicensesByIntegrator(int integratorId) {
 }
 
 std::vector<Certificate> Database::getCertificatesByIntegrator(int integratorId) {
+    TraceSpan span("db.getCertificatesByIntegrator");
     std::vector<Certificate> certificates;
     
     if (queries.find("GET_CERTIFICATES_BY_INTEGRATOR") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_CERTIFICATES_BY_INTEGRATOR не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "GET_CERTIFICATES_BY_INTEGRATOR");
         return certificates;
     }
     
-    const char* query = queries["GET_CERTIFICATES_BY_INTEGRATOR"].c_str();
     std::string integratorIdStr = std::to_string(integratorId);
     const char* paramValues[1] = { integratorIdStr.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, nullptr, nullptr, 0);
+    PGresult* res = execNamed("GET_CERTIFICATES_BY_INTEGRATOR", 1, paramValues);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "Ошибка запроса сертификатов: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка запроса сертификатов").field("error", PQerrorMessage(conn));
         PQclear(res);
         return certificates;
     }
@@ -803,88 +1051,92 @@ std::vector<Certificate> Database::getCertificatesByIntegrator(int integratorId)
 }
 
 bool Database::addLicense(int integratorId, const std::string& licenseNumber, const std::string& issuedBy) {
+    TraceSpan span("db.addLicense");
     if (queries.find("ADD_LICENSE") == queries.end()) {
-        std::cerr << "Ошибка: запрос ADD_LICENSE не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "ADD_LICENSE");
         return false;
     }
     
-    const char* query = queries["ADD_LICENSE"].c_str();
     std::string integratorIdStr = std::to_string(integratorId);
     const char* paramValues[3] = { integratorIdStr.c_str(), licenseNumber.c_str(), issuedBy.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 3, nullptr, paramValues, nullptr, nullptr, 0);
+    PGresult* res = execNamed("ADD_LICENSE", 3, paramValues);
+    DataVersions::instance().bump(DataScope::Catalog);
     bool success = (PQresultStatus(res) == PGRES_COMMAND_OK);
     if (!success) {
-        std::cerr << "Ошибка добавления лицензии: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка добавления лицензии").field("error", PQerrorMessage(conn));
     }
     PQclear(res);
     return success;
 }
 
 bool Database::deleteLicenses(int integratorId) {
+    TraceSpan span("db.deleteLicenses");
     if (queries.find("DELETE_LICENSES") == queries.end()) {
-        std::cerr << "Ошибка: запрос DELETE_LICENSES не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "DELETE_LICENSES");
         return false;
     }
     
-    const char* query = queries["DELETE_LICENSES"].c_str();
     std::string integratorIdStr = std::to_string(integratorId);
     const char* paramValues[1] = { integratorIdStr.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, nullptr, nullptr, 0);
+    PGresult* res = execNamed("DELETE_LICENSES", 1, paramValues);
+    DataVersions::instance().bump(DataScope::Catalog);
     bool success = (PQresultStatus(res) == PGRES_COMMAND_OK);
     PQclear(res);
     return success;
 }
 
 bool Database::addCertificate(int integratorId, const std::string& certificateName, const std::string& certificateNumber, const std::string& issuedBy) {
+    TraceSpan span("db.addCertificate");
     if (queries.find("ADD_CERTIFICATE") == queries.end()) {
-        std::cerr << "Ошибка: запрос ADD_CERTIFICATE не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "ADD_CERTIFICATE");
         return false;
     }
     
-    const char* query = queries["ADD_CERTIFICATE"].c_str();
     std::string integratorIdStr = std::to_string(integratorId);
     const char* paramValues[4] = { integratorIdStr.c_str(), certificateName.c_str(), certificateNumber.c_str(), issuedBy.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 4, nullptr, paramValues, nullptr, nullptr, 0);
+    PGresult* res = execNamed("ADD_CERTIFICATE", 4, paramValues);
+    DataVersions::instance().bump(DataScope::Catalog);
     bool success = (PQresultStatus(res) == PGRES_COMMAND_OK);
     if (!success) {
-        std::cerr << "Ошибка добавления сертификата: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка добавления сертификата").field("error", PQerrorMessage(conn));
     }
     PQclear(res);
     return success;
 }
 
 bool Database::deleteCertificates(int integratorId) {
+    TraceSpan span("db.deleteCertificates");
     if (queries.find("DELETE_CERTIFICATES") == queries.end()) {
-        std::cerr << "Ошибка: запрос DELETE_CERTIFICATES не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "DELETE_CERTIFICATES");
         return false;
     }
     
-    const char* query = queries["DELETE_CERTIFICATES"].c_str();
     std::string integratorIdStr = std::to_string(integratorId);
     const char* paramValues[1] = { integratorIdStr.c_str() };
     
-    PGresult* res = PQexecParams(conn, query, 1, nullptr, paramValues, nullptr, nullptr, 0);
+    PGresult* res = execNamed("DELETE_CERTIFICATES", 1, paramValues);
+    DataVersions::instance().bump(DataScope::Catalog);
     bool success = (PQresultStatus(res) == PGRES_COMMAND_OK);
     PQclear(res);
     return success;
 }
 
 std::vector<std::pair<int, std::string>> Database::getAllCountries() {
+    TraceSpan span("db.getAllCountries");
     std::vector<std::pair<int, std::string>> countries;
     
     if (queries.find("GET_ALL_COUNTRIES_WITH_ID") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_ALL_COUNTRIES_WITH_ID не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "GET_ALL_COUNTRIES_WITH_ID");
         return countries;
     }
     
-    const char* query = queries["GET_ALL_COUNTRIES_WITH_ID"].c_str();
-    PGresult* res = PQexec(conn, query);
+    PGresult* res = execNamed("GET_ALL_COUNTRIES_WITH_ID", 0, nullptr);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "Ошибка запроса стран: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка запроса стран").field("error", PQerrorMessage(conn));
         PQclear(res);
         return countries;
     }
@@ -899,18 +1151,18 @@ std::vector<std::pair<int, std::string>> Database::getAllCountries() {
 }
 
 std::vector<std::pair<int, std::string>> Database::getAllProducts() {
+    TraceSpan span("db.getAllProducts");
     std::vector<std::pair<int, std::string>> products;
     
     if (queries.find("GET_ALL_PRODUCTS_WITH_ID") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_ALL_PRODUCTS_WITH_ID не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "GET_ALL_PRODUCTS_WITH_ID");
         return products;
     }
     
-    const char* query = queries["GET_ALL_PRODUCTS_WITH_ID"].c_str();
-    PGresult* res = PQexec(conn, query);
+    PGresult* res = execNamed("GET_ALL_PRODUCTS_WITH_ID", 0, nullptr);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "Ошибка запроса продуктов: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка запроса продуктов").field("error", PQerrorMessage(conn));
         PQclear(res);
         return products;
     }
@@ -925,18 +1177,18 @@ std::vector<std::pair<int, std::string>> Database::getAllProducts() {
 }
 
 std::vector<std::pair<int, std::string>> Database::getAllServices() {
+    TraceSpan span("db.getAllServices");
     std::vector<std::pair<int, std::string>> services;
     
     if (queries.find("GET_ALL_SERVICES_WITH_ID") == queries.end()) {
-        std::cerr << "Ошибка: запрос GET_ALL_SERVICES_WITH_ID не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "GET_ALL_SERVICES_WITH_ID");
         return services;
     }
     
-    const char* query = queries["GET_ALL_SERVICES_WITH_ID"].c_str();
-    PGresult* res = PQexec(conn, query);
+    PGresult* res = execNamed("GET_ALL_SERVICES_WITH_ID", 0, nullptr);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        std::cerr << "Ошибка запроса услуг: " << PQerrorMessage(conn) << std::endl;
+        LOG_ERROR("Ошибка запроса услуг").field("error", PQerrorMessage(conn));
         PQclear(res);
         return services;
     }
@@ -951,58 +1203,115 @@ std::vector<std::pair<int, std::string>> Database::getAllServices() {
 }
 
 bool Database::setIntegratorProducts(int integratorId, const std::vector<int>& productIds) {
+    TraceSpan span("db.setIntegratorProducts");
     // Удаляем старые связи
     if (queries.find("DELETE_INTEGRATOR_PRODUCTS") == queries.end()) {
-        std::cerr << "Ошибка: запрос DELETE_INTEGRATOR_PRODUCTS не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "DELETE_INTEGRATOR_PRODUCTS");
         return false;
     }
     
     std::string integratorIdStr = std::to_string(integratorId);
     const char* paramValues[1] = { integratorIdStr.c_str() };
-    PGresult* res = PQexecParams(conn, queries["DELETE_INTEGRATOR_PRODUCTS"].c_str(), 1, nullptr, paramValues, nullptr, nullptr, 0);
+    PGresult* res = execNamed("DELETE_INTEGRATOR_PRODUCTS", 1, paramValues);
     PQclear(res);
     
     // Добавляем новые связи
     if (queries.find("ADD_INTEGRATOR_PRODUCT") == queries.end()) {
-        std::cerr << "Ошибка: запрос ADD_INTEGRATOR_PRODUCT не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "ADD_INTEGRATOR_PRODUCT");
         return false;
     }
     
     for (int productId : productIds) {
         std::string productIdStr = std::to_string(productId);
         const char* params[2] = { integratorIdStr.c_str(), productIdStr.c_str() };
-        res = PQexecParams(conn, queries["ADD_INTEGRATOR_PRODUCT"].c_str(), 2, nullptr, params, nullptr, nullptr, 0);
+        res = execNamed("ADD_INTEGRATOR_PRODUCT", 2, params);
         PQclear(res);
     }
     
+    DataVersions::instance().bump(DataScope::Catalog);
     return true;
 }
 
 bool Database::setIntegratorServices(int integratorId, const std::vector<int>& serviceIds) {
+    TraceSpan span("db.setIntegratorServices");
     // Удаляем старые связи
     if (queries.find("DELETE_INTEGRATOR_SERVICES") == queries.end()) {
-        std::cerr << "Ошибка: запрос DELETE_INTEGRATOR_SERVICES не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "DELETE_INTEGRATOR_SERVICES");
         return false;
     }
     
     std::string integratorIdStr = std::to_string(integratorId);
     const char* paramValues[1] = { integratorIdStr.c_str() };
-    PGresult* res = PQexecParams(conn, queries["DELETE_INTEGRATOR_SERVICES"].c_str(), 1, nullptr, paramValues, nullptr, nullptr, 0);
+    PGresult* res = execNamed("DELETE_INTEGRATOR_SERVICES", 1, paramValues);
     PQclear(res);
     
     // Добавляем новые связи
     if (queries.find("ADD_INTEGRATOR_SERVICE") == queries.end()) {
-        std::cerr << "Ошибка: запрос ADD_INTEGRATOR_SERVICE не найден" << std::endl;
+        LOG_ERROR("Запрос не найден").field("query", "ADD_INTEGRATOR_SERVICE");
         return false;
     }
     
     for (int serviceId : serviceIds) {
         std::string serviceIdStr = std::to_string(serviceId);
         const char* params[2] = { integratorIdStr.c_str(), serviceIdStr.c_str() };
-        res = PQexecParams(conn, queries["ADD_INTEGRATOR_SERVICE"].c_str(), 2, nullptr, params, nullptr, nullptr, 0);
+        res = execNamed("ADD_INTEGRATOR_SERVICE", 2, params);
         PQclear(res);
     }
     
+    DataVersions::instance().bump(DataScope::Catalog);
+    return true;
+}
+
+bool Database::initializeSearchIndex() {
+    // pg_trgm, колонка search_vector, GIN-индексы и триггеры. Единственное определение:
+    // init.sql его не содержит, сервер создаёт всё при каждом старте (идемпотентно)
+    std::string setupSearch =
+        "CREATE EXTENSION IF NOT EXISTS pg_trgm;"
+        "ALTER TABLE integrators ADD COLUMN IF NOT EXISTS search_vector tsvector;"
+        "CREATE INDEX IF NOT EXISTS idx_integrators_name_trgm ON integrators USING GIN (name gin_trgm_ops);"
+        "CREATE INDEX IF NOT EXISTS idx_integrators_city_trgm ON integrators USING GIN (city gin_trgm_ops);"
+        "CREATE INDEX IF NOT EXISTS idx_integrators_search_vector ON integrators USING GIN (search_vector);"
+        "CREATE OR REPLACE FUNCTION refresh_integrator_search_vector(p_integrator_id INTEGER) RETURNS VOID AS $$ "
+        "BEGIN "
+        "UPDATE integrators i SET search_vector = "
+        "setweight(to_tsvector('russian', COALESCE(i.name, '')), 'A') || "
+        "setweight(to_tsvector('russian', COALESCE((SELECT string_agg(p.name, ' ') FROM integrator_products ip "
+        "JOIN products p ON ip.product_id = p.id WHERE ip.integrator_id = i.id), '')), 'B') || "
+        "setweight(to_tsvector('russian', COALESCE((SELECT string_agg(s.name, ' ') FROM integrator_services iserv "
+        "JOIN services s ON iserv.service_id = s.id WHERE iserv.integrator_id = i.id), '')), 'B') || "
+        "setweight(to_tsvector('russian', COALESCE(i.description, '')), 'C') "
+        "WHERE i.id = p_integrator_id; "
+        "END; $$ LANGUAGE plpgsql;"
+        "CREATE OR REPLACE FUNCTION integrators_search_vector_trigger() RETURNS TRIGGER AS $$ "
+        "BEGIN PERFORM refresh_integrator_search_vector(NEW.id); RETURN NULL; END; $$ LANGUAGE plpgsql;"
+        "CREATE OR REPLACE FUNCTION integrator_links_search_vector_trigger() RETURNS TRIGGER AS $$ "
+        "BEGIN "
+        "IF TG_OP = 'DELETE' THEN PERFORM refresh_integrator_search_vector(OLD.integrator_id); "
+        "ELSE PERFORM refresh_integrator_search_vector(NEW.integrator_id); END IF; "
+        "RETURN NULL; END; $$ LANGUAGE plpgsql;"
+        "DROP TRIGGER IF EXISTS trg_integrators_search_vector ON integrators;"
+        "CREATE TRIGGER trg_integrators_search_vector AFTER INSERT OR UPDATE OF name, description ON integrators "
+        "FOR EACH ROW EXECUTE FUNCTION integrators_search_vector_trigger();"
+        "DROP TRIGGER IF EXISTS trg_integrator_products_search_vector ON integrator_products;"
+        "CREATE TRIGGER trg_integrator_products_search_vector AFTER INSERT OR DELETE ON integrator_products "
+        "FOR EACH ROW EXECUTE FUNCTION integrator_links_search_vector_trigger();"
+        "DROP TRIGGER IF EXISTS trg_integrator_services_search_vector ON integrator_services;"
+        "CREATE TRIGGER trg_integrator_services_search_vector AFTER INSERT OR DELETE ON integrator_services "
+        "FOR EACH ROW EXECUTE FUNCTION integrator_links_search_vector_trigger();"
+        // Заполняем search_vector для строк, добавленных до появления триггеров
+        "SELECT refresh_integrator_search_vector(id) FROM integrators WHERE search_vector IS NULL;";
+    
+    PGresult* res = PQexec(conn, setupSearch.c_str());
+    if (PQresultStatus(res) != PGRES_COMMAND_OK && PQresultStatus(res) != PGRES_TUPLES_OK) {
+        // Без pg_trgm (нет прав на CREATE EXTENSION) сервер продолжает работать с поиском в памяти
+        std::cerr << "Индексы поиска недоступны: " << PQerrorMessage(conn) << std::endl;
+        PQclear(res);
+        searchIndexAvailable = false;
+        return false;
+    }
+    PQclear(res);
+    searchIndexAvailable = true;
+    std::cout << "Индексы поиска созданы/проверены." << std::endl;
     return true;
 }
 
@@ -1030,7 +1339,40 @@ bool Database::initializeDefaultData() {
         return false;
     }
     PQclear(res);
+
+    // Отзыв токенов сессий (SESSION_MODE=token): без таблицы выход и отзыв
+    // токенов не работают на БД, созданной до её появления в init.sql
+    res = PQexec(conn,
+        "CREATE TABLE IF NOT EXISTS session_revocations (id SERIAL PRIMARY KEY, token_id VARCHAR(64) UNIQUE, user_id INTEGER REFERENCES users(id) ON DELETE CASCADE, revoked_at TIMESTAMPTZ NOT NULL DEFAULT NOW(), expires_at TIMESTAMPTZ NOT NULL);");
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        std::cerr << "Ошибка создания таблицы session_revocations: " << PQerrorMessage(conn) << std::endl;
+        PQclear(res);
+        return false;
+    }
+    PQclear(res);
+
+    // Индексы по сроку действия для фоновой очистки просроченных сессий и отзывов
+    res = PQexec(conn,
+        "CREATE INDEX IF NOT EXISTS idx_sessions_expires_at ON sessions (expires_at);"
+        "CREATE INDEX IF NOT EXISTS idx_session_revocations_expires_at ON session_revocations (expires_at);");
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        std::cerr << "Ошибка создания индексов сроков сессий: " << PQerrorMessage(conn) << std::endl;
+        PQclear(res);
+        return false;
+    }
+    PQclear(res);
     std::cout << "Таблицы созданы/проверены." << std::endl;
+
+    // collation_key(text) для ORDER BY по названиям: порядок тот же, что у каталога в памяти
+    res = PQexec(conn, collationKeyFunctionSql().c_str());
+    if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+        std::cerr << "Ошибка создания функции collation_key: " << PQerrorMessage(conn) << std::endl;
+        PQclear(res);
+        return false;
+    }
+    PQclear(res);
+    
+    initializeSearchIndex();
     
     // Проверяем, есть ли уже интеграторы в БД
     PGresult* checkRes = PQexec(conn, "SELECT COUNT(*) FROM integrators");
@@ -0,0 +1,23 @@
+#include "dictionary.h"
+#include <algorithm>
+
+Dictionary::Dictionary(std::vector<std::pair<int, std::string>> source) : entries(std::move(source)) {
+    int maxId = 0;
+    for (const auto& entry : entries) maxId = std::max(maxId, entry.first);
+    slotById.assign(static_cast<size_t>(maxId) + 1, -1);
+    for (size_t slot = 0; slot < entries.size(); slot++) {
+        if (entries[slot].first >= 0) slotById[entries[slot].first] = static_cast<int32_t>(slot);
+    }
+}
+
+const std::string& Dictionary::name(int id) const {
+    static const std::string empty;
+    const std::string* found = find(id);
+    return found ? *found : empty;
+}
+
+size_t Dictionary::memoryUsage() const {
+    size_t bytes = slotById.capacity() * sizeof(int32_t) + entries.capacity() * sizeof(entries[0]);
+    for (const auto& entry : entries) bytes += entry.second.capacity();
+    return bytes;
+}
@@ -0,0 +1,77 @@
+#include "form_parser.h"
+#include "text_kernels.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+const ByteSet URL_ESCAPES("%+");
+
+} // namespace
+
+std::string_view FormData::decode(std::string_view raw) {
+    if (findFirstOf(raw.data(), raw.size(), URL_ESCAPES) == raw.size()) {
+        return raw;
+    }
+    // Буфер зарезервирован под размер тела, а декодированная строка не длиннее
+    // исходной, поэтому перераспределений нет и выданные string_view остаются валидными
+    size_t start = decoded.size();
+    appendUrlDecoded(decoded, raw.data(), raw.size());
+    return std::string_view(decoded.data() + start, decoded.size() - start);
+}
+
+FormData::FormData(std::string_view body, std::pmr::memory_resource* memory)
+    : keys(memory), values(memory), decoded(memory) {
+    decoded.reserve(body.size());
+
+    std::pmr::vector<Field> fields(memory);
+    fields.reserve(std::count(body.begin(), body.end(), '&') + 1);
+
+    const char* p = body.data();
+    size_t remaining = body.size();
+    while (remaining > 0) {
+        const char* amp = static_cast<const char*>(memchr(p, '&', remaining));
+        size_t pairLength = amp ? static_cast<size_t>(amp - p) : remaining;
+        const char* eq = static_cast<const char*>(memchr(p, '=', pairLength));
+        if (eq != nullptr) {
+            size_t keyLength = eq - p;
+            fields.push_back({decode(std::string_view(p, keyLength)),
+                              decode(std::string_view(eq + 1, pairLength - keyLength - 1)), fields.size()});
+        }
+        if (pairLength == remaining) break;
+        p += pairLength + 1;
+        remaining -= pairLength + 1;
+    }
+
+    // Порядок значений внутри поля сохраняет номер в теле; stable_sort дал бы
+    // то же, но берёт временный буфер из кучи в обход memory
+    std::sort(fields.begin(), fields.end(), [](const Field& a, const Field& b) {
+        int order = a.key.compare(b.key);
+        return order != 0 ? order < 0 : a.position < b.position;
+    });
+    keys.reserve(fields.size());
+    values.reserve(fields.size());
+    for (const auto& field : fields) {
+        keys.push_back(field.key);
+        values.push_back(field.value);
+    }
+}
+
+FormValues FormData::getAll(std::string_view key) const {
+    auto range = std::equal_range(keys.begin(), keys.end(), key);
+    const std::string_view* base = values.data();
+    return FormValues(base + (range.first - keys.begin()), base + (range.second - keys.begin()));
+}
+
+std::string_view FormData::get(std::string_view key) const {
+    FormValues all = getAll(key);
+    return all.empty() ? std::string_view() : all[all.size() - 1];
+}
+
+bool parseFormInt(std::string_view value, int& result) {
+    if (value.empty()) return false;
+    const char* end = value.data() + value.size();
+    auto parsed = std::from_chars(value.data(), end, result);
+    return parsed.ec == std::errc() && parsed.ptr == end;
+}
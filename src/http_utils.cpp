@@ -0,0 +1,236 @@
+#include "http_utils.h"
+#include "text_kernels.h"
+#include "utf8.h"
+#include <sstream>
+#include <iomanip>
+#include <cstring>
+#include <cctype>
+#include <cstdio>
+#include <ctime>
+#include <strings.h>
+
+std::string urlDecode(const std::string& str) {
+    std::string result;
+    result.reserve(str.size());
+    appendUrlDecoded(result, str.data(), str.size());
+    return result;
+}
+
+std::string urlEncode(const std::string& value) {
+    std::ostringstream escaped;
+    escaped << std::hex << std::uppercase;
+    for (unsigned char c : value) {
+        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            escaped << c;
+        } else if (c == ' ') {
+            escaped << '+';
+        } else {
+            escaped << '%' << std::setw(2) << int(c) << std::setw(0);
+        }
+    }
+    return escaped.str();
+}
+
+std::string htmlEscape(const std::string& str) {
+    std::string result;
+    result.reserve(str.size() + str.size() / 8);
+    appendHtmlEscaped(result, str.data(), str.size());
+    return result;
+}
+
+std::string toLowerStr(const std::string& str) {
+    return utf8ToLower(str);
+}
+
+bool containsCaseInsensitive(const std::string& text, const std::string& pattern) {
+    if (pattern.empty()) return true;
+    std::string lowerText = toLowerStr(text);
+    std::string lowerPattern = toLowerStr(pattern);
+    return lowerText.find(lowerPattern) != std::string::npos;
+}
+
+std::map<std::string, std::string> parsePostData(const std::string& data) {
+    std::map<std::string, std::string> params;
+    const char* p = data.data();
+    size_t remaining = data.size();
+    
+    // Один проход без промежуточных копий пар:
+    // ключ и значение декодируются прямо из буфера запроса
+    while (remaining > 0) {
+        const char* amp = static_cast<const char*>(memchr(p, '&', remaining));
+        size_t pairLength = amp ? static_cast<size_t>(amp - p) : remaining;
+        const char* eqPos = static_cast<const char*>(memchr(p, '=', pairLength));
+        if (eqPos != nullptr) {
+            size_t eq = eqPos - p;
+            std::string key;
+            appendUrlDecoded(key, p, eq);
+            std::string& value = params[key];
+            value.clear();
+            appendUrlDecoded(value, p + eq + 1, pairLength - eq - 1);
+        }
+        if (pairLength == remaining) break;
+        p += pairLength + 1;
+        remaining -= pairLength + 1;
+    }
+    return params;
+}
+
+std::string getCookie(std::string_view headers, std::string_view name) {
+    size_t pos = headers.find("Cookie:");
+    if (pos == std::string_view::npos) return "";
+    
+    // Имя целиком: после него '=', перед ним начало списка cookie
+    size_t start = headers.find(name, pos);
+    while (start != std::string_view::npos && (headers.compare(start + name.size(), 1, "=") != 0 ||
+                                               (headers[start - 1] != ' ' && headers[start - 1] != ':' &&
+                                                headers[start - 1] != ';'))) {
+        start = headers.find(name, start + 1);
+    }
+    if (start == std::string_view::npos) return "";
+    
+    start += name.length() + 1;
+    size_t end = headers.find_first_of(";\r\n", start);
+    if (end == std::string_view::npos) end = headers.length();
+    
+    return std::string(headers.substr(start, end - start));
+}
+
+std::string getHeader(std::string_view request, std::string_view name) {
+    size_t headersEnd = request.find("\r\n\r\n");
+    if (headersEnd == std::string_view::npos) headersEnd = request.size();
+    size_t pos = request.find("\r\n");
+    while (pos != std::string_view::npos && pos < headersEnd) {
+        size_t lineStart = pos + 2;
+        size_t lineEnd = request.find("\r\n", lineStart);
+        if (lineEnd == std::string_view::npos) lineEnd = request.size();
+        size_t colon = request.find(':', lineStart);
+        if (colon != std::string_view::npos && colon < lineEnd && colon - lineStart == name.size() &&
+            strncasecmp(request.data() + lineStart, name.data(), name.size()) == 0) {
+            size_t valueStart = request.find_first_not_of(" \t", colon + 1);
+            if (valueStart == std::string_view::npos || valueStart > lineEnd) return "";
+            size_t valueEnd = lineEnd;
+            while (valueEnd > valueStart && (request[valueEnd - 1] == ' ' || request[valueEnd - 1] == '\t')) valueEnd--;
+            return std::string(request.substr(valueStart, valueEnd - valueStart));
+        }
+        pos = lineEnd;
+    }
+    return "";
+}
+
+std::string getRequestTarget(std::string_view request) {
+    size_t start = request.find(' ');
+    if (start == std::string_view::npos) return "";
+    size_t end = request.find_first_of(" \r\n", start + 1);
+    if (end == std::string_view::npos) end = request.size();
+    return std::string(request.substr(start + 1, end - start - 1));
+}
+
+std::string getQueryParam(std::string_view request, std::string_view paramName) {
+    size_t queryStart = request.find("?");
+    if (queryStart == std::string_view::npos) return "";
+    
+    size_t queryEnd = request.find(" ", queryStart);
+    if (queryEnd == std::string_view::npos) queryEnd = request.find("\r\n", queryStart);
+    if (queryEnd == std::string_view::npos) return "";
+    
+    std::string_view queryString = request.substr(queryStart + 1, queryEnd - queryStart - 1);
+    
+    // Имя целиком: page не должен находиться внутри per_page
+    size_t paramPos = queryString.find(paramName);
+    while (paramPos != std::string_view::npos && (queryString.compare(paramPos + paramName.size(), 1, "=") != 0 ||
+                                                  (paramPos > 0 && queryString[paramPos - 1] != '&'))) {
+        paramPos = queryString.find(paramName, paramPos + 1);
+    }
+    if (paramPos == std::string_view::npos) return "";
+    
+    size_t valueStart = paramPos + paramName.length() + 1;
+    size_t valueEnd = queryString.find("&", valueStart);
+    if (valueEnd == std::string_view::npos) valueEnd = queryString.length();
+    
+    std::string value;
+    value.reserve(valueEnd - valueStart);
+    appendUrlDecoded(value, queryString.data() + valueStart, valueEnd - valueStart);
+    return value;
+}
+
+const char* httpStatusLine(int statusCode) {
+    switch (statusCode) {
+        case 200: return "200 OK";
+        case 302: return "302 Found";
+        case 304: return "304 Not Modified";
+        case 400: return "400 Bad Request";
+        case 401: return "401 Unauthorized";
+        case 404: return "404 Not Found";
+        case 429: return "429 Too Many Requests";
+        case 503: return "503 Service Unavailable";
+        default: return "500 Internal Server Error";
+    }
+}
+
+std::string formatHttpDate(int64_t unixSeconds) {
+    time_t seconds = static_cast<time_t>(unixSeconds);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    // strftime зависит от локали, поэтому названия дней и месяцев заданы явно
+    static const char* const DAYS[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+    static const char* const MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                         "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    char buffer[40];
+    snprintf(buffer, sizeof(buffer), "%s, %02d %s %04d %02d:%02d:%02d GMT", DAYS[utc.tm_wday], utc.tm_mday,
+             MONTHS[utc.tm_mon], utc.tm_year + 1900, utc.tm_hour, utc.tm_min, utc.tm_sec);
+    return buffer;
+}
+
+std::string cacheValidatorHeaders(const std::string& etag, int64_t lastModified) {
+    // private: страница зависит от пользователя; no-cache: перед показом клиент перепроверяет ETag
+    return "ETag: " + etag + "\r\nLast-Modified: " + formatHttpDate(lastModified) +
+           "\r\nCache-Control: private, no-cache\r\n";
+}
+
+std::string createNotModifiedResponse(const std::string& validatorHeaders) {
+    return "HTTP/1.1 304 Not Modified\r\n" + validatorHeaders + "Connection: close\r\n\r\n";
+}
+
+std::string createHTTPResponse(const std::string& body, const std::string& setCookie, const std::string& extraHeaders) {
+    std::ostringstream response;
+    response << "HTTP/1.1 200 OK\r\n"
+             << "Content-Type: text/html; charset=utf-8\r\n"
+             << "Content-Length: " << body.length() << "\r\n";
+    
+    if (!setCookie.empty()) {
+        response << "Set-Cookie: session_id=" << setCookie << "; Path=/; HttpOnly\r\n";
+    }
+    response << extraHeaders;
+    
+    response << "Connection: close\r\n\r\n" << body;
+    return response.str();
+}
+
+std::string createJsonResponse(int statusCode, const std::string& body) {
+    std::ostringstream response;
+    response << "HTTP/1.1 " << httpStatusLine(statusCode) << "\r\n"
+             << "Content-Type: application/json; charset=utf-8\r\n"
+             << "Content-Length: " << body.length() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << body;
+    return response.str();
+}
+
+std::string createRedirectResponse(const std::string& location) {
+    std::ostringstream response;
+    response << "HTTP/1.1 302 Found\r\n"
+             << "Location: " << location << "\r\n"
+             << "Connection: close\r\n\r\n";
+    return response.str();
+}
+
+std::string createRetryLaterResponse(int statusCode, const std::string& body, int retryAfterSeconds) {
+    std::ostringstream response;
+    response << "HTTP/1.1 " << httpStatusLine(statusCode) << "\r\n"
+             << "Content-Type: text/html; charset=utf-8\r\n"
+             << "Retry-After: " << retryAfterSeconds << "\r\n"
+             << "Content-Length: " << body.length() << "\r\n"
+             << "Connection: close\r\n\r\n"
+             << body;
+    return response.str();
+}
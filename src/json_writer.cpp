@@ -0,0 +1,117 @@
+#include "json_writer.h"
+#include <charconv>
+#include <cmath>
+
+void JsonWriter::separate() {
+    if (afterKey) {
+        afterKey = false;
+        return;
+    }
+    if (depth == 0) return;
+    uint64_t bit = 1ULL << (depth - 1);
+    if (hasItems & bit) {
+        out += ',';
+    }
+    hasItems |= bit;
+}
+
+void JsonWriter::writeString(std::string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+    out += '"';
+    size_t plain = 0;   // начало ещё не скопированного куска без экранирования
+    for (size_t i = 0; i < text.size(); i++) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.append(text.data() + plain, i - plain);
+        plain = i + 1;
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            case '\b': out += "\\b"; break;
+            case '\f': out += "\\f"; break;
+            default:
+                out += "\\u00";
+                out += HEX[c >> 4];
+                out += HEX[c & 15];
+        }
+    }
+    out.append(text.data() + plain, text.size() - plain);
+    out += '"';
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    separate();
+    out += '{';
+    depth++;
+    hasItems &= ~(1ULL << (depth - 1));
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    depth--;
+    out += '}';
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray() {
+    separate();
+    out += '[';
+    depth++;
+    hasItems &= ~(1ULL << (depth - 1));
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+    depth--;
+    out += ']';
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(std::string_view name) {
+    separate();
+    writeString(name);
+    out += ':';
+    afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::string_view text) {
+    separate();
+    writeString(text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(long long number) {
+    separate();
+    char buffer[24];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    out.append(buffer, result.ptr - buffer);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number) {
+    // NaN и бесконечность в JSON не представимы
+    if (!std::isfinite(number)) {
+        return null();
+    }
+    separate();
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    out.append(buffer, result.ptr - buffer);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag) {
+    separate();
+    out += flag ? "true" : "false";
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    separate();
+    out += "null";
+    return *this;
+}
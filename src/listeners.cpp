@@ -0,0 +1,74 @@
+#include "listeners.h"
+#include "logger.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+int openListener(int port, bool reusePort, int backlog) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        LOG_ERROR("Ошибка создания сокета").field("error", strerror(errno));
+        return -1;
+    }
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reusePort && setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        LOG_ERROR("SO_REUSEPORT не поддерживается").field("error", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = INADDR_ANY;
+    address.sin_port = htons(port);
+
+    if (bind(fd, (sockaddr*)&address, sizeof(address)) < 0) {
+        LOG_ERROR("Ошибка привязки сокета").field("port", port).field("error", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    if (listen(fd, backlog) < 0) {
+        LOG_ERROR("Ошибка прослушивания").field("port", port).field("error", strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int listenerPort(int fd) {
+    sockaddr_in address;
+    socklen_t length = sizeof(address);
+    if (getsockname(fd, (sockaddr*)&address, &length) < 0) {
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
+
+size_t cpuCount() {
+    unsigned count = std::thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+bool pinCurrentThread(size_t cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
@@ -0,0 +1,126 @@
+#include "listing.h"
+#include "http_utils.h"
+#include <algorithm>
+
+ListingQuery parseListingQuery(std::string_view request, bool textIndexAvailable) {
+    ListingQuery query;
+    query.city = getQueryParam(request, "city");
+    query.filterCity = getQueryParam(request, "filter_city");
+    query.name = getQueryParam(request, "name");
+    query.text = getQueryParam(request, "q");
+    query.product = getQueryParam(request, "product");
+    query.service = getQueryParam(request, "service");
+    query.useTextIndex = !query.text.empty() && textIndexAvailable;
+    query.sort = getQueryParam(request, "sort");
+    // При полнотекстовом поиске по умолчанию сортируем по релевантности
+    if (query.sort.empty()) query.sort = query.useTextIndex ? "relevance" : "name_asc";
+    // relevance - только порядок полнотекстового поиска, без него это был бы порядок строк индекса
+    if (query.sort != "name_asc" && query.sort != "name_desc" &&
+        query.sort != "city_asc" && query.sort != "city_desc" &&
+        query.sort != "rating_desc" && query.sort != "rating_asc" &&
+        (query.sort != "relevance" || !query.useTextIndex)) {
+        query.sort = "name_asc";
+    }
+
+    std::string pageParam = getQueryParam(request, "page");
+    if (!pageParam.empty()) {
+        try { query.page = std::max(1, std::stoi(pageParam)); } catch (...) { query.page = 1; }
+    }
+    std::string perPage = getQueryParam(request, "per_page");
+    if (!perPage.empty()) {
+        try {
+            query.pageSize = std::min(LISTING_MAX_PAGE_SIZE, std::max(1, std::stoi(perPage)));
+        } catch (...) {
+            query.pageSize = LISTING_PAGE_SIZE;
+        }
+    }
+    return query;
+}
+
+ListingPage buildListingPage(Database& db, const CatalogSnapshot& catalog,
+                             std::shared_ptr<const RatingSnapshot> ratings, const ListingQuery& query) {
+    ListingPage result;
+    result.ratings = std::move(ratings);
+
+    // Поиск по индексу снимка каталога в памяти (название, город, продукт, услуга)
+    SearchQuery searchQuery;
+    searchQuery.name = query.name;
+    searchQuery.city = query.city;
+    // Продукт и услуга, которых нет в справочнике, не фильтруют
+    if (!query.product.empty()) {
+        try {
+            int productId = std::stoi(query.product);
+            if (catalog.products.find(productId)) searchQuery.productId = productId;
+        } catch (...) {}
+    }
+    if (!query.service.empty()) {
+        try {
+            int serviceId = std::stoi(query.service);
+            if (catalog.services.find(serviceId)) searchQuery.serviceId = serviceId;
+        } catch (...) {}
+    }
+    std::vector<uint32_t> rows = catalog.index.search(searchQuery);
+
+    // Полнотекстовый поиск выполняет БД; строки идут в порядке релевантности
+    if (query.useTextIndex && !rows.empty()) {
+        std::vector<char> matched(catalog.integrators.size(), 0);
+        for (uint32_t row : rows) matched[row] = 1;
+        rows.clear();
+        for (int id : db.searchIntegratorIds(query.text)) {
+            auto it = catalog.rowById.find(id);
+            if (it != catalog.rowById.end() && matched[it->second]) {
+                rows.push_back(it->second);
+            }
+        }
+    }
+
+    // Фильтры сужают набор строк по колонкам снимка (catalog.columns), строки
+    // интеграторов читает только поиск по тексту без индекса
+    const CatalogColumns& columns = catalog.columns;
+    if (!query.filterCity.empty()) {
+        columns.filterByCity(rows, columns.cityId(query.filterCity));
+    }
+    if (!query.text.empty() && !query.useTextIndex) {
+        auto anyNameMatches = [&](const Dictionary& dictionary, const std::vector<int>& ids) {
+            for (int id : ids) {
+                if (containsCaseInsensitive(dictionary.name(id), query.text)) return true;
+            }
+            return false;
+        };
+        rows.erase(std::remove_if(rows.begin(), rows.end(), [&](uint32_t row) {
+            const Integrator& itg = catalog.integrators[row];
+            return !containsCaseInsensitive(itg.description, query.text) &&
+                   !anyNameMatches(catalog.products, itg.productIds) &&
+                   !anyNameMatches(catalog.services, itg.serviceIds);
+        }), rows.end());
+    }
+
+    // Пагинация
+    int pageSize = query.pageSize;
+    result.total = static_cast<int>(rows.size());
+    result.totalPages = std::max(1, (result.total + pageSize - 1) / pageSize);
+    result.page = std::min(query.page, result.totalPages);
+    size_t start = static_cast<size_t>(result.page - 1) * pageSize;
+
+    // Страница берётся из готового порядка для sort (колонки снимка и
+    // RatingSnapshot); порядок релевантности уже задан запросом поиска
+    std::vector<uint32_t> pageRows;
+    const std::string& sortOption = query.sort;
+    if (sortOption == "relevance") {
+        size_t end = std::min(start + pageSize, rows.size());
+        if (start < end) pageRows.assign(rows.begin() + start, rows.begin() + end);
+    } else {
+        const CatalogOrdering& ordering = sortOption == "rating_desc" ? result.ratings->byRatingDesc
+                                        : sortOption == "rating_asc" ? result.ratings->byRatingAsc
+                                        : columns.ordering(sortOption == "name_desc" ? CatalogOrder::NameDesc
+                                                         : sortOption == "city_asc" ? CatalogOrder::CityAsc
+                                                         : sortOption == "city_desc" ? CatalogOrder::CityDesc
+                                                         : CatalogOrder::NameAsc);
+        selectOrderedPage(ordering, rows, start, pageSize, pageRows);
+    }
+
+    // Интеграторы страницы - указатели в снимок, без копий
+    result.items.reserve(pageRows.size());
+    for (uint32_t row : pageRows) result.items.push_back(&catalog.integrators[row]);
+    return result;
+}
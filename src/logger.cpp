@@ -0,0 +1,289 @@
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+std::atomic<int> currentLogLevel{static_cast<int>(LogLevel::Info)};
+
+namespace {
+
+const char* const LEVEL_NAMES[] = {"debug", "info", "warn", "error", "off"};
+const size_t RING_CAPACITY = 1 << 16;   // байт на поток
+const auto FLUSH_INTERVAL = std::chrono::milliseconds(20);
+
+// Кольцевой буфер байтов: пишет только поток-владелец, читает только поток записи.
+// Каждая запись хранится как [uint32 длина][байты]; позиции растут монотонно.
+class LogRing {
+private:
+    char data[RING_CAPACITY];
+    alignas(64) std::atomic<uint64_t> head{0};   // позиция записи (владелец)
+    alignas(64) std::atomic<uint64_t> tail{0};   // позиция чтения (поток записи)
+
+    void copyIn(uint64_t pos, const char* src, size_t size) {
+        size_t offset = pos & (RING_CAPACITY - 1);
+        size_t first = std::min(size, RING_CAPACITY - offset);
+        memcpy(data + offset, src, first);
+        memcpy(data, src + first, size - first);
+    }
+
+    void copyOut(uint64_t pos, char* dst, size_t size) const {
+        size_t offset = pos & (RING_CAPACITY - 1);
+        size_t first = std::min(size, RING_CAPACITY - offset);
+        memcpy(dst, data + offset, first);
+        memcpy(dst + first, data, size - first);
+    }
+
+public:
+    std::atomic<uint64_t> dropped{0};
+
+    bool push(const std::string& record) {
+        uint32_t size = static_cast<uint32_t>(record.size());
+        uint64_t writePos = head.load(std::memory_order_relaxed);
+        uint64_t readPos = tail.load(std::memory_order_acquire);
+        if (writePos + sizeof(size) + size - readPos > RING_CAPACITY) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        copyIn(writePos, reinterpret_cast<const char*>(&size), sizeof(size));
+        copyIn(writePos + sizeof(size), record.data(), size);
+        head.store(writePos + sizeof(size) + size, std::memory_order_release);
+        return true;
+    }
+
+    // Переносит все готовые записи в out
+    void drain(std::string& out) {
+        uint64_t readPos = tail.load(std::memory_order_relaxed);
+        uint64_t writePos = head.load(std::memory_order_acquire);
+        while (readPos < writePos) {
+            uint32_t size;
+            copyOut(readPos, reinterpret_cast<char*>(&size), sizeof(size));
+            size_t start = out.size();
+            out.resize(start + size);
+            copyOut(readPos + sizeof(size), &out[start], size);
+            readPos += sizeof(size) + size;
+        }
+        tail.store(readPos, std::memory_order_release);
+    }
+};
+
+struct LoggerState {
+    std::mutex mutex;                              // список буферов и запуск/остановка
+    std::vector<std::unique_ptr<LogRing>> rings;
+    std::condition_variable wake;
+    std::thread flusher;
+    std::atomic<bool> running{false};
+    bool stopping = false;
+    int fd = STDOUT_FILENO;
+    uint64_t reportedDrops = 0;
+};
+
+LoggerState& state() {
+    static LoggerState* instance = new LoggerState();   // не разрушается до конца процесса
+    return *instance;
+}
+
+LogRing& threadRing() {
+    thread_local LogRing* ring = nullptr;
+    if (ring == nullptr) {
+        LoggerState& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.rings.emplace_back(new LogRing());
+        ring = s.rings.back().get();
+    }
+    return *ring;
+}
+
+void writeAll(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return;
+        }
+        written += n;
+    }
+}
+
+void appendJsonString(std::string& out, std::string_view value) {
+    static const char* hex = "0123456789abcdef";
+    out += '"';
+    for (char c : value) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\r') {
+            out += "\\r";
+        } else if (c == '\t') {
+            out += "\\t";
+        } else if (u < 0x20) {
+            out += "\\u00";
+            out += hex[u >> 4];
+            out += hex[u & 15];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+bool isSensitiveKey(const char* key) {
+    static const char* const patterns[] = {"password", "token", "session", "cookie", "secret", "authorization"};
+    for (const char* pattern : patterns) {
+        if (strstr(key, pattern) != nullptr) return true;
+    }
+    return false;
+}
+
+// Собирает записи всех потоков; возвращает число байтов, отданных на запись
+size_t flushOnce(LoggerState& s, std::string& batch) {
+    batch.clear();
+    uint64_t drops = 0;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (auto& ring : s.rings) {
+            ring->drain(batch);
+            drops += ring->dropped.load(std::memory_order_relaxed);
+        }
+    }
+    if (drops > s.reportedDrops) {
+        batch += "{\"level\":\"warn\",\"msg\":\"Записи журнала отброшены: буфер переполнен\",\"dropped\":" +
+                 std::to_string(drops - s.reportedDrops) + "}\n";
+        s.reportedDrops = drops;
+    }
+    if (!batch.empty()) {
+        writeAll(s.fd, batch);
+    }
+    return batch.size();
+}
+
+void flusherLoop() {
+    LoggerState& s = state();
+    std::string batch;
+    batch.reserve(RING_CAPACITY);
+    std::unique_lock<std::mutex> lock(s.mutex);
+    while (!s.stopping) {
+        s.wake.wait_for(lock, FLUSH_INTERVAL);
+        lock.unlock();
+        flushOnce(s, batch);
+        lock.lock();
+    }
+    lock.unlock();
+    flushOnce(s, batch);
+}
+
+} // namespace
+
+LogLevel parseLogLevel(const std::string& name) {
+    if (name == "debug") return LogLevel::Debug;
+    if (name == "warn") return LogLevel::Warn;
+    if (name == "error") return LogLevel::Error;
+    if (name == "off") return LogLevel::Off;
+    return LogLevel::Info;
+}
+
+bool startLogger(LogLevel level, const std::string& path) {
+    LoggerState& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    if (s.running.load()) return true;
+
+    if (!path.empty()) {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0640);
+        if (fd < 0) {
+            std::cerr << "Ошибка открытия файла журнала: " << path << std::endl;
+            return false;
+        }
+        s.fd = fd;
+    }
+    currentLogLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+    s.stopping = false;
+    s.flusher = std::thread(flusherLoop);
+    s.running.store(true, std::memory_order_release);
+    return true;
+}
+
+void stopLogger() {
+    LoggerState& s = state();
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (!s.running.load()) return;
+        s.stopping = true;
+        s.running.store(false, std::memory_order_release);
+    }
+    s.wake.notify_all();
+    s.flusher.join();
+    if (s.fd != STDOUT_FILENO) {
+        close(s.fd);
+        s.fd = STDOUT_FILENO;
+    }
+}
+
+LogRecord::LogRecord(LogLevel level, const char* message) {
+    line.reserve(256);
+
+    auto now = std::chrono::system_clock::now();
+    time_t seconds = std::chrono::system_clock::to_time_t(now);
+    int millis = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000);
+    tm utc;
+    gmtime_r(&seconds, &utc);
+    char timestamp[64];
+    snprintf(timestamp, sizeof(timestamp), "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ",
+             utc.tm_year + 1900, utc.tm_mon + 1, utc.tm_mday, utc.tm_hour, utc.tm_min, utc.tm_sec, millis);
+
+    line += "{\"ts\":\"";
+    line += timestamp;
+    line += "\",\"level\":\"";
+    line += LEVEL_NAMES[static_cast<int>(level)];
+    line += "\",\"msg\":";
+    appendJsonString(line, message);
+}
+
+LogRecord::~LogRecord() {
+    line += "}\n";
+    // До запуска фонового потока (и после остановки) пишем сразу
+    if (state().running.load(std::memory_order_acquire)) {
+        threadRing().push(line);
+    } else {
+        writeAll(STDERR_FILENO, line);
+    }
+}
+
+void LogRecord::appendKey(const char* key) {
+    line += ',';
+    appendJsonString(line, key);
+    line += ':';
+}
+
+LogRecord& LogRecord::field(const char* key, std::string_view value) {
+    appendKey(key);
+    appendJsonString(line, isSensitiveKey(key) ? std::string_view("***") : value);
+    return *this;
+}
+
+LogRecord& LogRecord::field(const char* key, bool value) {
+    appendKey(key);
+    line += value ? "true" : "false";
+    return *this;
+}
+
+LogRecord& LogRecord::field(const char* key, double value) {
+    appendKey(key);
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.6g", value);
+    line += buffer;
+    return *this;
+}
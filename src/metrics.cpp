@@ -0,0 +1,259 @@
+#include "metrics.h"
+#include <sstream>
+#include <iomanip>
+
+namespace {
+
+std::atomic<size_t> nextShard{0};
+
+// Значение метки в кавычках: экранируются \, " и перевод строки
+std::string labelValue(const std::string& value) {
+    std::string result = "\"";
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            result += '\\';
+            result += c;
+        } else if (c == '\n') {
+            result += "\\n";
+        } else {
+            result += c;
+        }
+    }
+    result += '"';
+    return result;
+}
+
+std::string seconds(uint64_t micros) {
+    std::ostringstream out;
+    out << std::setprecision(9) << micros / 1e6;
+    return out.str();
+}
+
+// Границы le гистограмм: степени двойки микросекунд от 16 мкс до ~67 с.
+// Совпадают с границами корзин, поэтому накопленные значения точные.
+const int PROMETHEUS_MIN_EXPONENT = 4;
+const int PROMETHEUS_MAX_EXPONENT = 26;
+
+void writeHistogram(std::ostringstream& out, const std::string& name, const std::string& labelName,
+                    const std::string& label, const Histogram::Snapshot& snapshot) {
+    std::string labels = labelName + "=" + labelValue(label);
+    uint64_t cumulative = 0;
+    size_t index = 0;
+    for (int exponent = PROMETHEUS_MIN_EXPONENT; exponent <= PROMETHEUS_MAX_EXPONENT; exponent++) {
+        uint64_t bound = 1ULL << exponent;
+        while (index < snapshot.buckets.size() && Histogram::bucketLowerBound(index) < bound) {
+            cumulative += snapshot.buckets[index++];
+        }
+        out << name << "_bucket{" << labels << ",le=\"" << seconds(bound) << "\"} " << cumulative << "\n";
+    }
+    out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << snapshot.count << "\n";
+    out << name << "_sum{" << labels << "} " << seconds(snapshot.sumMicros) << "\n";
+    out << name << "_count{" << labels << "} " << snapshot.count << "\n";
+}
+
+} // namespace
+
+size_t metricShard() {
+    thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % METRIC_SHARDS;
+    return shard;
+}
+
+uint64_t Counter::value() const {
+    uint64_t total = 0;
+    for (const auto& slot : slots) {
+        total += slot.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t Histogram::bucketIndex(uint64_t micros) {
+    if (micros < SUB_BUCKETS) {
+        return static_cast<size_t>(micros);
+    }
+    int exponent = 63 - __builtin_clzll(micros);
+    if (exponent > MAX_EXPONENT) {
+        return BUCKETS - 1;
+    }
+    uint64_t sub = (micros >> (exponent - SUB_BUCKET_BITS)) & (SUB_BUCKETS - 1);
+    return SUB_BUCKETS + (exponent - SUB_BUCKET_BITS) * SUB_BUCKETS + sub;
+}
+
+uint64_t Histogram::bucketLowerBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index;
+    }
+    size_t exponent = (index - SUB_BUCKETS) / SUB_BUCKETS + SUB_BUCKET_BITS;
+    uint64_t sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    return (1ULL << exponent) + (sub << (exponent - SUB_BUCKET_BITS));
+}
+
+void Histogram::record(uint64_t micros) {
+    Shard& shard = shards[metricShard()];
+    shard.buckets[bucketIndex(micros)].fetch_add(1, std::memory_order_relaxed);
+    shard.sumMicros.fetch_add(micros, std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot result;
+    result.buckets.assign(BUCKETS, 0);
+    for (size_t s = 0; s < METRIC_SHARDS; s++) {
+        const Shard& shard = shards[s];
+        for (size_t i = 0; i < BUCKETS; i++) {
+            uint64_t n = shard.buckets[i].load(std::memory_order_relaxed);
+            result.buckets[i] += n;
+            result.count += n;
+        }
+        result.sumMicros += shard.sumMicros.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+uint64_t Histogram::Snapshot::quantileMicros(double q) const {
+    if (count == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * (count - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return i + 1 < buckets.size() ? bucketLowerBound(i + 1) - 1 : bucketLowerBound(i);
+        }
+    }
+    return bucketLowerBound(buckets.size() - 1);
+}
+
+MetricsRegistry& MetricsRegistry::instance() {
+    static MetricsRegistry registry;
+    return registry;
+}
+
+RouteMetrics& MetricsRegistry::route(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = routes[name];
+    if (!entry) entry.reset(new RouteMetrics());
+    return *entry;
+}
+
+QueryMetrics& MetricsRegistry::query(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = queries[key];
+    if (!entry) entry.reset(new QueryMetrics());
+    return *entry;
+}
+
+CacheMetrics& MetricsRegistry::cache(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = caches[name];
+    if (!entry) entry.reset(new CacheMetrics());
+    return *entry;
+}
+
+AdmissionMetrics& MetricsRegistry::admission(const std::string& rateClass) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = admissionClasses[rateClass];
+    if (!entry) entry.reset(new AdmissionMetrics());
+    return *entry;
+}
+
+MaintenanceMetrics& MetricsRegistry::maintenance(const std::string& task) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& entry = maintenanceTasks[task];
+    if (!entry) entry.reset(new MaintenanceMetrics());
+    return *entry;
+}
+
+std::string MetricsRegistry::renderPrometheus() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::ostringstream out;
+
+    out << "# HELP infosec_http_requests_total HTTP requests by route.\n"
+        << "# TYPE infosec_http_requests_total counter\n";
+    for (const auto& entry : routes) {
+        out << "infosec_http_requests_total{route=" << labelValue(entry.first) << "} " << entry.second->requests.value() << "\n";
+    }
+    out << "# HELP infosec_http_request_bytes_total Bytes read from clients by route.\n"
+        << "# TYPE infosec_http_request_bytes_total counter\n";
+    for (const auto& entry : routes) {
+        out << "infosec_http_request_bytes_total{route=" << labelValue(entry.first) << "} " << entry.second->bytesIn.value() << "\n";
+    }
+    out << "# HELP infosec_http_response_bytes_total Bytes sent to clients by route.\n"
+        << "# TYPE infosec_http_response_bytes_total counter\n";
+    for (const auto& entry : routes) {
+        out << "infosec_http_response_bytes_total{route=" << labelValue(entry.first) << "} " << entry.second->bytesOut.value() << "\n";
+    }
+    out << "# HELP infosec_http_request_duration_seconds Request handling time by route.\n"
+        << "# TYPE infosec_http_request_duration_seconds histogram\n";
+    for (const auto& entry : routes) {
+        writeHistogram(out, "infosec_http_request_duration_seconds", "route", entry.first, entry.second->latency.snapshot());
+    }
+    out << "# HELP infosec_http_active_connections Client connections currently being served.\n"
+        << "# TYPE infosec_http_active_connections gauge\n"
+        << "infosec_http_active_connections " << connections.value() << "\n";
+
+    out << "# HELP infosec_db_query_calls_total Executions of named queries from queries.sql.\n"
+        << "# TYPE infosec_db_query_calls_total counter\n";
+    for (const auto& entry : queries) {
+        out << "infosec_db_query_calls_total{query=" << labelValue(entry.first) << "} " << entry.second->calls.value() << "\n";
+    }
+    out << "# HELP infosec_db_query_errors_total Failed executions of named queries.\n"
+        << "# TYPE infosec_db_query_errors_total counter\n";
+    for (const auto& entry : queries) {
+        out << "infosec_db_query_errors_total{query=" << labelValue(entry.first) << "} " << entry.second->errors.value() << "\n";
+    }
+    out << "# HELP infosec_db_query_duration_seconds Named query round-trip time.\n"
+        << "# TYPE infosec_db_query_duration_seconds histogram\n";
+    for (const auto& entry : queries) {
+        writeHistogram(out, "infosec_db_query_duration_seconds", "query", entry.first, entry.second->latency.snapshot());
+    }
+
+    out << "# HELP infosec_cache_hits_total Cache lookups served from memory.\n"
+        << "# TYPE infosec_cache_hits_total counter\n";
+    for (const auto& entry : caches) {
+        out << "infosec_cache_hits_total{cache=" << labelValue(entry.first) << "} " << entry.second->hits.value() << "\n";
+    }
+    out << "# HELP infosec_cache_misses_total Cache lookups that required a reload.\n"
+        << "# TYPE infosec_cache_misses_total counter\n";
+    for (const auto& entry : caches) {
+        out << "infosec_cache_misses_total{cache=" << labelValue(entry.first) << "} " << entry.second->misses.value() << "\n";
+    }
+    out << "# HELP infosec_cache_hit_ratio Share of cache lookups served from memory since start.\n"
+        << "# TYPE infosec_cache_hit_ratio gauge\n";
+    for (const auto& entry : caches) {
+        uint64_t hits = entry.second->hits.value();
+        uint64_t total = hits + entry.second->misses.value();
+        out << "infosec_cache_hit_ratio{cache=" << labelValue(entry.first) << "} "
+            << (total > 0 ? static_cast<double>(hits) / total : 0.0) << "\n";
+    }
+
+    out << "# HELP infosec_rate_limited_total Requests rejected with 429 by per-client rate limits.\n"
+        << "# TYPE infosec_rate_limited_total counter\n";
+    for (const auto& entry : admissionClasses) {
+        out << "infosec_rate_limited_total{class=" << labelValue(entry.first) << "} " << entry.second->rateLimited.value() << "\n";
+    }
+    out << "# HELP infosec_load_shed_total Requests rejected with 503 by the concurrency limit.\n"
+        << "# TYPE infosec_load_shed_total counter\n";
+    for (const auto& entry : admissionClasses) {
+        out << "infosec_load_shed_total{class=" << labelValue(entry.first) << "} " << entry.second->shed.value() << "\n";
+    }
+
+    out << "# HELP infosec_maintenance_runs_total Completed runs of background maintenance tasks.\n"
+        << "# TYPE infosec_maintenance_runs_total counter\n";
+    for (const auto& entry : maintenanceTasks) {
+        out << "infosec_maintenance_runs_total{task=" << labelValue(entry.first) << "} " << entry.second->runs.value() << "\n";
+    }
+    out << "# HELP infosec_maintenance_rows_deleted_total Rows removed by background maintenance tasks.\n"
+        << "# TYPE infosec_maintenance_rows_deleted_total counter\n";
+    for (const auto& entry : maintenanceTasks) {
+        out << "infosec_maintenance_rows_deleted_total{task=" << labelValue(entry.first) << "} " << entry.second->rowsDeleted.value() << "\n";
+    }
+    out << "# HELP infosec_maintenance_errors_total Failed batches of background maintenance tasks.\n"
+        << "# TYPE infosec_maintenance_errors_total counter\n";
+    for (const auto& entry : maintenanceTasks) {
+        out << "infosec_maintenance_errors_total{task=" << labelValue(entry.first) << "} " << entry.second->errors.value() << "\n";
+    }
+    out << "# HELP infosec_maintenance_duration_seconds Duration of one maintenance run, all batches included.\n"
+        << "# TYPE infosec_maintenance_duration_seconds histogram\n";
+    for (const auto& entry : maintenanceTasks) {
+        writeHistogram(out, "infosec_maintenance_duration_seconds", "task", entry.first, entry.second->duration.snapshot());
+    }
+    return out.str();
+}
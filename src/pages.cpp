@@ -0,0 +1,723 @@
+#include "pages.h"
+#include "http_utils.h"
+#include "text_kernels.h"
+#include "response_stream.h"
+#include "listing.h"
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace {
+
+// Поле, экранируемое при выводе в поток: html << htmlText(s). Экранирование
+// идёт в буфер потока, переиспользуемый между полями, а не в новую строку на
+// каждое поле.
+struct EscapedText {
+    const std::string& text;
+    bool js;
+};
+
+EscapedText htmlText(const std::string& text) { return {text, false}; }
+// Для строкового литерала JS внутри атрибута onclick
+EscapedText jsText(const std::string& text) { return {text, true}; }
+
+std::ostream& operator<<(std::ostream& out, const EscapedText& field) {
+    if (field.js && !needsJsEscape(field.text.data(), field.text.size())) {
+        return out.write(field.text.data(), field.text.size());
+    }
+    thread_local std::string scratch;
+    scratch.clear();
+    if (field.js) {
+        appendJsEscaped(scratch, field.text.data(), field.text.size());
+    } else {
+        appendHtmlEscaped(scratch, field.text.data(), field.text.size());
+    }
+    return out.write(scratch.data(), scratch.size());
+}
+
+// Названия продуктов или услуг интегратора по id через ", "
+void writeNames(std::ostream& html, const Dictionary& dictionary, const std::vector<int>& ids) {
+    bool first = true;
+    for (int id : ids) {
+        const std::string* name = dictionary.find(id);
+        if (!name) continue;
+        html << (first ? "" : ", ") << htmlText(*name);
+        first = false;
+    }
+}
+
+} // namespace
+
+std::string generateLoginPage(const std::string& error) {
+    std::ostringstream html;
+    html << "<!DOCTYPE html><html lang='ru'><head>"
+         << "<meta charset='UTF-8'><title>Вход в систему</title><style>"
+         << "body { font-family: Arial, sans-serif; display: flex; justify-content: center; align-items: center; height: 100vh; margin: 0; background: linear-gradient(135deg, #667eea 0%, #764ba2 100%); }"
+         << ".login-box { background: white; padding: 40px; border-radius: 10px; box-shadow: 0 10px 25px rgba(0,0,0,0.2); width: 300px; }"
+         << "h2 { text-align: center; color: #333; margin-bottom: 30px; }"
+         << "input { width: 100%; padding: 12px; margin: 10px 0; border: 1px solid #ddd; border-radius: 5px; box-sizing: border-box; }"
+         << "button { width: 100%; padding: 12px; background: #667eea; color: white; border: none; border-radius: 5px; cursor: pointer; font-size: 16px; margin-top: 10px; }"
+         << "button:hover { background: #5568d3; }"
+         << ".error { color: red; text-align: center; margin-bottom: 10px; font-size: 14px; }"
+         << ".info { color: #666; text-align: center; margin-top: 20px; font-size: 12px; }"
+         << ".register-link { color: #667eea; text-decoration: none; display: block; text-align: center; margin-top: 15px; font-size: 14px; }"
+         << ".register-link:hover { text-decoration: underline; }"
+         << "</style>"
+         << "<script>"
+         << "window.onload = function() {"
+         << "  sessionStorage.removeItem('authenticated');"
+         << "};"
+         << "</script>"
+         << "</head><body><div class='login-box'><h2>🔐 Вход в систему</h2>";
+    
+    if (!error.empty()) {
+        html << "<div class='error'>" << htmlEscape(error) << "</div>";
+    }
+    
+    html << "<form method='POST' action='/login'>"
+         << "<input type='text' name='username' placeholder='Имя пользователя' required>"
+         << "<input type='password' name='password' placeholder='Пароль' required>"
+         << "<button type='submit'>Войти</button></form>"
+         << "<a href='/register' class='register-link'>Нет аккаунта? Зарегистрироваться</a>"
+         << "</div></body></html>";
+    
+    return html.str();
+}
+
+std::string generateRegisterPage(const std::string& error, const std::string& username, const std::string& password) {
+    std::ostringstream html;
+    html << "<!DOCTYPE html><html lang='ru'><head>"
+         << "<meta charset='UTF-8'><title>Регистрация</title><style>"
+         << "body { font-family: Arial, sans-serif; display: flex; justify-content: center; align-items: center; height: 100vh; margin: 0; background: linear-gradient(135deg, #667eea 0%, #764ba2 100%); }"
+         << ".register-box { background: white; padding: 40px; border-radius: 10px; box-shadow: 0 10px 25px rgba(0,0,0,0.2); width: 320px; }"
+         << "h2 { text-align: center; color: #333; margin-bottom: 30px; }"
+         << "input { width: 100%; padding: 12px; margin: 10px 0; border: 1px solid #ddd; border-radius: 5px; box-sizing: border-box; }"
+         << "button { width: 100%; padding: 12px; background: #27ae60; color: white; border: none; border-radius: 5px; cursor: pointer; font-size: 16px; margin-top: 10px; }"
+         << "button:hover { background: #229954; }"
+         << ".error { color: red; text-align: center; margin-bottom: 10px; font-size: 14px; }"
+         << ".info { color: #666; text-align: center; margin-top: 15px; font-size: 12px; }"
+         << ".login-link { color: #667eea; text-decoration: none; display: block; text-align: center; margin-top: 15px; font-size: 14px; }"
+         << ".login-link:hover { text-decoration: underline; }"
+         << ".password-hint { font-size: 11px; color: #999; margin-top: -5px; margin-bottom: 10px; }"
+         << "</style>"
+         << "<script>"
+         << "function validatePassword() {"
+         << "  var pwd = document.getElementById('password').value;"
+         << "  var confirmPwd = document.getElementById('password_confirm').value;"
+         << "  var submitBtn = document.getElementById('submit-btn');"
+         << "  if (pwd.length < 3) {"
+         << "    submitBtn.disabled = true;"
+         << "    return false;"
+         << "  }"
+         << "  if (pwd !== confirmPwd) {"
+         << "    submitBtn.disabled = true;"
+         << "    return false;"
+         << "  }"
+         << "  submitBtn.disabled = false;"
+         << "  return true;"
+         << "}"
+         << "</script>"
+         << "</head><body><div class='register-box'><h2>📝 Регистрация</h2>";
+    
+    if (!error.empty()) {
+        html << "<div class='error'>" << htmlEscape(error) << "</div>";
+    }
+    
+    std::string safeUsername = htmlEscape(username);
+    std::string safePassword = htmlEscape(password);
+    
+    html << "<form method='POST' action='/register'>"
+         << "<input type='text' name='username' id='username' placeholder='Имя пользователя' value='" << safeUsername << "' required minlength='3' maxlength='50'>"
+         << "<input type='password' name='password' id='password' placeholder='Пароль (минимум 3 символа)' value='" << safePassword << "' required minlength='3' oninput='validatePassword()'>"
+         << "<div class='password-hint'>Минимум 3 символа</div>"
+         << "<input type='password' name='password_confirm' id='password_confirm' placeholder='Подтвердите пароль' required oninput='validatePassword()'>"
+         << "<button type='submit' id='submit-btn'>Зарегистрироваться</button></form>"
+         << "<a href='/login' class='login-link'>Уже есть аккаунт? Войти</a>"
+         << "<div class='info'><br>После регистрации вы сможете оценивать интеграторов и оставлять отзывы</div>"
+         << "</div></body></html>";
+    
+    return html.str();
+}
+
+std::string generateSlowQueriesPage(const std::vector<SlowQueryEntry>& entries, uint64_t thresholdMicros) {
+    std::ostringstream html;
+    html << "<!DOCTYPE html><html lang='ru'><head>"
+         << "<meta charset='UTF-8'><title>Медленные запросы</title><style>"
+         << "body { font-family: Arial, sans-serif; margin: 0; padding: 20px; background: #f5f5f5; }"
+         << "h1 { color: #333; }"
+         << "table { width: 100%; border-collapse: collapse; background: white; box-shadow: 0 2px 5px rgba(0,0,0,0.1); }"
+         << "th, td { padding: 10px; border-bottom: 1px solid #eee; text-align: left; vertical-align: top; font-size: 14px; }"
+         << "th { background: #667eea; color: white; }"
+         << "pre { background: #f8f8f8; padding: 10px; font-size: 12px; overflow-x: auto; }"
+         << ".info { color: #666; margin-bottom: 15px; }"
+         << "a { color: #667eea; }"
+         << "</style></head><body>"
+         << "<h1>🐢 Медленные запросы</h1>"
+         << "<div class='info'>Порог: " << thresholdMicros / 1000 << " мс. <a href='/'>На главную</a></div>";
+    
+    if (entries.empty()) {
+        html << "<p>Запросов дольше порога не было.</p>";
+    } else {
+        html << "<table><tr><th>Запрос</th><th>Превышений</th><th>Макс., мс</th><th>Средн., мс</th>"
+             << "<th>Строк</th><th>Параметры</th><th>Когда (UTC)</th></tr>";
+        for (const auto& entry : entries) {
+            html << std::fixed << std::setprecision(1)
+                 << "<tr><td>" << htmlEscape(entry.key) << "</td>"
+                 << "<td>" << entry.count << "</td>"
+                 << "<td>" << entry.maxMicros / 1000.0 << "</td>"
+                 << "<td>" << entry.totalMicros / 1000.0 / entry.count << "</td>"
+                 << "<td>" << entry.maxRows << "</td>"
+                 << "<td>" << htmlEscape(entry.maxParams) << "</td>"
+                 << "<td>" << htmlEscape(entry.maxTime) << "</td></tr>";
+            if (!entry.plan.empty()) {
+                html << "<tr><td colspan='7'><details><summary>" << htmlEscape(entry.planCommand) << "</summary>"
+                     << "<pre>" << htmlEscape(entry.plan) << "</pre></details></td></tr>";
+            }
+        }
+        html << "</table>";
+    }
+    html << "</body></html>";
+    return html.str();
+}
+
+void renderMainPageHeader(
+    std::ostream& html,
+    bool isAdmin,
+    const std::string& username,
+    const std::string& tabToken,
+    const std::vector<std::string>& cities,
+    const Dictionary& products,
+    const Dictionary& services,
+    const ListingQuery& query
+) {
+    html << "<!DOCTYPE html><html lang='ru'><head>"
+         << "<meta charset='UTF-8'><title>Интеграторы InfoSec</title><style>"
+         << "body { font-family: Arial, sans-serif; max-width: 1200px; margin: 0 auto; padding: 20px; background: #f5f5f5; }"
+         << ".header { display: flex; justify-content: space-between; align-items: center; margin-bottom: 30px; background: white; padding: 20px; border-radius: 8px; box-shadow: 0 2px 4px rgba(0,0,0,0.1); }"
+         << "h1 { color: #2c3e50; margin: 0; }"
+         << ".user-info { text-align: right; }"
+         << ".user-name { color: #3498db; font-weight: bold; }"
+         << ".admin-badge { background: #e74c3c; color: white; padding: 3px 8px; border-radius: 3px; font-size: 12px; margin-left: 10px; }"
+         << ".admin-link { color: white; font-size: 12px; margin-left: 10px; }"
+         << ".logout-btn { background: #95a5a6; color: white; border: none; padding: 8px 16px; border-radius: 5px; cursor: pointer; margin-top: 10px; }"
+         << ".integrator { background: white; padding: 20px; margin: 15px 0; border-radius: 8px; box-shadow: 0 2px 4px rgba(0,0,0,0.1); position: relative; }"
+         << ".integrator h2 { color: #3498db; margin: 0 0 10px 0; }"
+         << ".city { color: #7f8c8d; font-size: 14px; margin-bottom: 10px; }"
+         << ".website, .licenses, .certificates, .products, .services { color: #7f8c8d; font-size: 14px; margin-bottom: 12px; }"
+         << ".website a { color: #3498db; text-decoration: none; font-weight: 500; }"
+         << ".website a:hover { text-decoration: underline; color: #2980b9; }"
+         << ".license-list, .certificate-list { margin: 8px 0 0 20px; padding: 0; list-style: none; }"
+         << ".license-list li, .certificate-list li { margin: 6px 0; padding: 8px; background: #f8f9fa; border-left: 3px solid #3498db; border-radius: 3px; }"
+         << ".license-list li strong, .certificate-list li strong { color: #2c3e50; }"
+         << ".license-list li em, .certificate-list li em { color: #7f8c8d; font-style: normal; }"
+         << ".description { color: #34495e; line-height: 1.6; margin-top: 10px; }"
+         << ".badge { display: inline-block; padding: 3px 8px; background: #3498db; color: white; border-radius: 3px; font-size: 12px; margin-right: 10px; }"
+         << ".add-btn { background: #27ae60; color: white; border: none; padding: 12px 24px; border-radius: 5px; cursor: pointer; font-size: 16px; margin-bottom: 20px; }"
+         << ".add-btn:hover { background: #229954; }"
+         << ".action-buttons { position: absolute; top: 20px; right: 20px; }"
+         << ".edit-btn, .delete-btn { padding: 6px 12px; margin-left: 5px; border: none; border-radius: 4px; cursor: pointer; font-size: 14px; }"
+         << ".edit-btn { background: #f39c12; color: white; } .edit-btn:hover { background: #e67e22; }"
+         << ".delete-btn { background: #e74c3c; color: white; } .delete-btn:hover { background: #c0392b; }"
+         << ".modal { display: none; position: fixed; z-index: 1000; left: 0; top: 0; width: 100%; height: 100%; background: rgba(0,0,0,0.5); }"
+         << ".modal-content { background: white; margin: 5% auto; padding: 30px; border-radius: 10px; width: 500px; box-shadow: 0 4px 6px rgba(0,0,0,0.3); }"
+         << ".modal-content h2 { margin-top: 0; color: #2c3e50; }"
+         << ".modal-content input, .modal-content textarea, .modal-content select { width: 100%; padding: 10px; margin: 10px 0; border: 1px solid #ddd; border-radius: 5px; box-sizing: border-box; }"
+         << ".modal-content textarea { height: 100px; resize: vertical; }"
+         << ".modal-content select[multiple] { height: 120px; }"
+         << ".license-item, .certificate-item { display: flex; gap: 10px; margin-bottom: 10px; align-items: center; }"
+         << ".license-item input, .certificate-item input { flex: 1; }"
+         << ".add-item-btn { background: #3498db; color: white; border: none; padding: 8px 15px; border-radius: 5px; cursor: pointer; font-size: 14px; }"
+         << ".add-item-btn:hover { background: #2980b9; }"
+         << ".remove-item-btn { background: #e74c3c; color: white; border: none; padding: 8px 15px; border-radius: 5px; cursor: pointer; font-size: 14px; }"
+         << ".remove-item-btn:hover { background: #c0392b; }"
+         << ".items-container { margin: 10px 0; }"
+         << ".modal-buttons { display: flex; justify-content: flex-end; gap: 10px; margin-top: 20px; }"
+         << ".modal-buttons button { padding: 10px 20px; border: none; border-radius: 5px; cursor: pointer; font-size: 14px; }"
+         << ".save-btn { background: #27ae60; color: white; } .save-btn:hover { background: #229954; }"
+         << ".cancel-btn { background: #95a5a6; color: white; } .cancel-btn:hover { background: #7f8c8d; }"
+         << ".search-box { background: white; padding: 20px; margin-bottom: 20px; border-radius: 8px; box-shadow: 0 2px 4px rgba(0,0,0,0.1); }"
+         << ".search-form { display: flex; gap: 10px; align-items: center; flex-wrap: wrap; }"
+         << ".search-form input, .search-form select { padding: 10px; border: 1px solid #ddd; border-radius: 5px; font-size: 14px; }"
+         << ".search-form input[type='text'] { flex: 1; min-width: 160px; }"
+         << ".search-form select { min-width: 150px; }"
+         << ".search-btn { background: #3498db; color: white; border: none; padding: 10px 20px; border-radius: 5px; cursor: pointer; font-size: 14px; }"
+         << ".search-btn:hover { background: #2980b9; }"
+         << ".clear-btn { background: #95a5a6; color: white; border: none; padding: 10px 20px; border-radius: 5px; cursor: pointer; font-size: 14px; }"
+         << ".clear-btn:hover { background: #7f8c8d; }"
+         << ".results-info { color: #7f8c8d; font-size: 14px; margin-bottom: 15px; }"
+         << ".rating { margin-top: 8px; font-size: 14px; color: #555; }"
+         << ".rating strong { color: #e67e22; }"
+         << ".reviews { margin-top: 10px; background: #fafafa; padding: 10px; border: 1px solid #eee; border-radius: 6px; }"
+         << ".review { margin-bottom: 8px; font-size: 13px; }"
+         << ".pagination { margin-top: 15px; display: flex; gap: 8px; align-items: center; }"
+         << ".pagination a, .pagination span { padding: 8px 12px; border-radius: 5px; border: 1px solid #ddd; text-decoration: none; color: #333; }"
+         << ".pagination a:hover { background: #f0f0f0; }"
+         << ".pagination .active { background: #3498db; color: white; border-color: #3498db; }"
+         << ".rate-form { margin-top: 10px; display: flex; flex-direction: column; gap: 8px; }"
+         << ".rate-form select, .rate-form textarea { width: 100%; padding: 8px; border: 1px solid #ddd; border-radius: 5px; box-sizing: border-box; }"
+         << ".rate-form button { align-self: flex-start; background: #3498db; color: white; border: none; padding: 8px 14px; border-radius: 5px; cursor: pointer; font-size: 14px; }"
+         << ".rate-form button:hover { background: #2980b9; }"
+         << "</style>"
+         << "<script>"
+         << "window.onload = function() {"
+         << "  var storedToken = sessionStorage.getItem('tab_token');"
+         << "  var serverToken = '" << tabToken << "';"
+         << "  if (!storedToken) {"
+         << "    sessionStorage.setItem('tab_token', serverToken);"
+         << "  } else if (storedToken !== serverToken) {"
+         << "    window.location.href = '/login_required';"
+         << "    return;"
+         << "  }"
+         << "};"
+         << "</script>"
+         << "</head><body>"
+         << "<div class='header'><h1>🛡️ Интеграторы InfoSec</h1>"
+         << "<div class='user-info'><div class='user-name'>" << username;
+    
+    if (isAdmin) {
+        html << "<span class='admin-badge'>ADMIN</span>"
+             << "<a href='/admin/slow-queries' class='admin-link'>Медленные запросы</a>";
+    }
+    
+    html << "</div><form method='POST' action='/logout' style='display:inline;'>"
+         << "<button type='submit' class='logout-btn'>Выйти</button></form></div></div>";
+    
+    // Форма поиска и фильтрации
+    std::string escapedCity = htmlEscape(query.city);
+    std::string escapedFilterCity = htmlEscape(query.filterCity);
+    std::string escapedSearch = htmlEscape(query.name);
+    std::string escapedText = htmlEscape(query.text);
+    html << "<div class='search-box'>"
+         << "<form method='GET' action='/' class='search-form'>"
+         << "<input type='text' name='name' placeholder='Поиск по названию...' value='" << escapedSearch << "'>"
+         << "<input type='text' name='city' placeholder='Поиск по городу...' value='" << escapedCity << "'>"
+         << "<input type='text' name='q' placeholder='Описание, продукты, услуги...' value='" << escapedText << "'>"
+         << "<select name='filter_city'>"
+         << "<option value=''>Все города</option>";
+    
+    for (const auto& city : cities) {
+        std::string escapedCityName = htmlEscape(city);
+        html << "<option value='" << escapedCityName << "'";
+        if (city == query.filterCity) {
+            html << " selected";
+        }
+        html << ">" << escapedCityName << "</option>";
+    }
+    
+    html << "</select>"
+         << "<select name='product'>"
+         << "<option value=''>Все продукты</option>";
+    for (const auto& product : products.all()) {
+        std::string productId = std::to_string(product.first);
+        html << "<option value='" << productId << "'" << (productId == query.product ? " selected" : "") << ">"
+             << htmlEscape(product.second) << "</option>";
+    }
+    html << "</select>"
+         << "<select name='service'>"
+         << "<option value=''>Все услуги</option>";
+    for (const auto& service : services.all()) {
+        std::string serviceId = std::to_string(service.first);
+        html << "<option value='" << serviceId << "'" << (serviceId == query.service ? " selected" : "") << ">"
+             << htmlEscape(service.second) << "</option>";
+    }
+    html << "</select>"
+         << "<select name='sort'>";
+    // Без полнотекстового поиска порядка релевантности нет
+    if (query.useTextIndex) {
+        html << "<option value='relevance'" << (query.sort == "relevance" ? " selected" : "") << ">По релевантности</option>";
+    }
+    html << "<option value='name_asc'" << (query.sort == "name_asc" ? " selected" : "") << ">Название ↑</option>"
+         << "<option value='name_desc'" << (query.sort == "name_desc" ? " selected" : "") << ">Название ↓</option>"
+         << "<option value='city_asc'" << (query.sort == "city_asc" ? " selected" : "") << ">Город ↑</option>"
+         << "<option value='city_desc'" << (query.sort == "city_desc" ? " selected" : "") << ">Город ↓</option>"
+         << "<option value='rating_desc'" << (query.sort == "rating_desc" ? " selected" : "") << ">Рейтинг ↓</option>"
+         << "<option value='rating_asc'" << (query.sort == "rating_asc" ? " selected" : "") << ">Рейтинг ↑</option>"
+         << "</select>"
+         << "<button type='submit' class='search-btn'>🔍 Поиск</button>"
+         << "<a href='/' style='text-decoration: none;'><button type='button' class='clear-btn'>Очистить</button></a>";
+    if (query.pageSize != LISTING_PAGE_SIZE) {
+        html << "<input type='hidden' name='per_page' value='" << query.pageSize << "'>";
+    }
+    html << "</form>";
+}
+
+void renderMainPageListing(
+    std::ostream& html,
+    const std::function<bool()>& flush,
+    const std::vector<const Integrator*>& integrators,
+    bool isAdmin,
+    bool isLoggedIn,
+    const Dictionary& countries,
+    const Dictionary& products,
+    const Dictionary& services,
+    const ListingQuery& query,
+    int page,
+    int totalPages,
+    int totalCount,
+    const std::map<int, RatingStats>& ratingStats,
+    const std::map<int, std::vector<Rating>>& integratorRatings
+) {
+    int shownCount = static_cast<int>(integrators.size());
+    int totalShown = totalCount > 0 ? totalCount : shownCount;
+    html << "<div class='results-info'>Найдено интеграторов: " << totalShown << "</div>";
+    
+    html << "</div>";
+    
+    if (isAdmin) {
+        html << "<button class='add-btn' onclick='openAddModal()'>➕ Добавить интегратора</button>";
+    }
+    
+    size_t rendered = 0;
+    for (const Integrator* item : integrators) {
+        const Integrator& integrator = *item;
+        // Клиент отключился - дальше рисовать незачем
+        if (flush && rendered > 0 && rendered % MAIN_PAGE_FLUSH_BATCH == 0 && !flush()) return;
+        rendered++;
+        html << "<div class='integrator'>";
+        
+        if (isAdmin) {
+            // Аргументы openEditModal пишутся прямо в страницу, с экранированием
+            // кавычек и переносов строк; лицензии и сертификаты - JSON
+            html << "<div class='action-buttons'>"
+                 << "<button class='edit-btn' onclick=\"openEditModal(" << integrator.id << ", '"
+                 << jsText(integrator.name) << "', '" << jsText(integrator.city) << "', '"
+                 << jsText(integrator.description) << "', '" << jsText(integrator.website) << "', "
+                 << (countries.find(integrator.countryId) ? integrator.countryId : 0) << ", '";
+            for (size_t i = 0; i < integrator.productIds.size(); i++) {
+                html << (i > 0 ? "," : "") << integrator.productIds[i];
+            }
+            html << "', '";
+            for (size_t i = 0; i < integrator.serviceIds.size(); i++) {
+                html << (i > 0 ? "," : "") << integrator.serviceIds[i];
+            }
+            html << "', '[";
+            for (size_t i = 0; i < integrator.licenses.size(); i++) {
+                const auto& license = integrator.licenses[i];
+                html << (i > 0 ? "," : "") << "{\"number\":\"" << jsText(license.number)
+                     << "\",\"issuedBy\":\"" << jsText(license.issuedBy) << "\"}";
+            }
+            html << "]', '[";
+            for (size_t i = 0; i < integrator.certificates.size(); i++) {
+                const auto& cert = integrator.certificates[i];
+                html << (i > 0 ? "," : "") << "{\"name\":\"" << jsText(cert.name) << "\",\"number\":\""
+                     << jsText(cert.number) << "\",\"issuedBy\":\"" << jsText(cert.issuedBy) << "\"}";
+            }
+            html << "]')\">✏️ Изменить</button>"
+                 << "<form method='POST' action='/delete' style='display:inline;'>"
+                 << "<input type='hidden' name='id' value='" << integrator.id << "'>"
+                 << "<button type='submit' class='delete-btn' onclick='return confirm(\"Удалить этого интегратора?\")'>🗑️ Удалить</button>"
+                 << "</form></div>";
+        }
+        
+        html << "<h2>" << integrator.name << "</h2>"
+             << "<div class='city'><span class='badge'>Город</span>" << integrator.city;
+        const std::string& country = countries.name(integrator.countryId);
+        if (!country.empty()) {
+            html << " <span class='badge'>Страна</span>" << country;
+        }
+        html << "</div>";
+        if (!integrator.website.empty()) {
+            const std::string& website = integrator.website;
+            bool hasScheme = website.compare(0, 7, "http://") == 0 || website.compare(0, 8, "https://") == 0;
+            html << "<div class='website'><span class='badge'>🌐 Сайт</span><a href='" << (hasScheme ? "" : "https://")
+                 << htmlText(website) << "' target='_blank' rel='noopener noreferrer'>" << htmlText(website) << " ↗</a></div>";
+        }
+        if (!integrator.licenses.empty()) {
+            html << "<div class='licenses'><span class='badge'>📜 Лицензии</span><ul class='license-list'>";
+            for (const auto& license : integrator.licenses) {
+                html << "<li><strong>" << htmlText(license.number) << "</strong> — выдана: <em>" << htmlText(license.issuedBy) << "</em></li>";
+            }
+            html << "</ul></div>";
+        }
+        if (!integrator.certificates.empty()) {
+            html << "<div class='certificates'><span class='badge'>🏆 Сертификаты</span><ul class='certificate-list'>";
+            for (const auto& cert : integrator.certificates) {
+                html << "<li><strong>" << htmlText(cert.name) << "</strong>";
+                if (!cert.number.empty()) {
+                    html << " (№ " << htmlText(cert.number) << ")";
+                }
+                html << " — выдано: <em>" << htmlText(cert.issuedBy) << "</em></li>";
+            }
+            html << "</ul></div>";
+        }
+        if (!integrator.productIds.empty()) {
+            html << "<div class='products'><span class='badge'>Продукты</span>";
+            writeNames(html, products, integrator.productIds);
+            html << "</div>";
+        }
+        if (!integrator.serviceIds.empty()) {
+            html << "<div class='services'><span class='badge'>Услуги</span>";
+            writeNames(html, services, integrator.serviceIds);
+            html << "</div>";
+        }
+        html << "<div class='description'>" << integrator.description << "</div>"
+             << "<div class='rating'>";
+
+        auto statIt = ratingStats.find(integrator.id);
+        if (statIt != ratingStats.end() && statIt->second.count > 0) {
+            html << "Рейтинг: <strong>" << std::fixed << std::setprecision(1) << statIt->second.average << "</strong> / 5"
+                 << " (" << statIt->second.count << ")";
+            html << std::defaultfloat;
+        } else {
+            html << "Рейтинг: нет оценок";
+        }
+        html << "</div>";
+
+        auto ratingsIt = integratorRatings.find(integrator.id);
+        if (ratingsIt != integratorRatings.end() && !ratingsIt->second.empty()) {
+            html << "<div class='reviews'>";
+            int shown = 0;
+            for (const auto& r : ratingsIt->second) {
+                if (shown >= 3) break;
+                html << "<div class='review'>"
+                     << "<strong>" << htmlText(r.username) << "</strong> — " << r.value << "/5"
+                     << " <span style='color:#999;font-size:12px;'>" << r.createdAt << "</span><br>"
+                     << htmlText(r.comment)
+                     << "</div>";
+                shown++;
+            }
+            html << "</div>";
+        }
+
+        if (isLoggedIn) {
+            html << "<div class='rate-form'>"
+                 << "<form method='POST' action='/rate'>"
+                 << "<input type='hidden' name='id' value='" << integrator.id << "'>"
+                 << "<label>Оцените интегратора:</label>"
+                 << "<select name='rating'>"
+                 << "<option value='5'>5</option>"
+                 << "<option value='4'>4</option>"
+                 << "<option value='3'>3</option>"
+                 << "<option value='2'>2</option>"
+                 << "<option value='1'>1</option>"
+                 << "</select>"
+                 << "<textarea name='comment' placeholder='Комментарий (необязательно)'></textarea>"
+                 << "<button type='submit'>Сохранить оценку</button>"
+                 << "</form>"
+                 << "</div>";
+        }
+
+        html << "</div>";
+    }
+
+    // Пагинация
+    if (totalPages > 1) {
+        html << "<div class='pagination'>";
+        auto makeLink = [&](int targetPage, const std::string& text, bool active) {
+            std::ostringstream link;
+            link << "/?page=" << targetPage
+                 << "&name=" << urlEncode(query.name)
+                 << "&city=" << urlEncode(query.city)
+                 << "&q=" << urlEncode(query.text)
+                 << "&product=" << urlEncode(query.product)
+                 << "&service=" << urlEncode(query.service)
+                 << "&filter_city=" << urlEncode(query.filterCity)
+                 << "&sort=" << urlEncode(query.sort);
+            if (query.pageSize != LISTING_PAGE_SIZE) {
+                link << "&per_page=" << query.pageSize;
+            }
+            if (active) {
+                html << "<span class='active'>" << text << "</span>";
+            } else {
+                html << "<a href='" << link.str() << "'>" << text << "</a>";
+            }
+        };
+        if (page > 1) {
+            makeLink(page - 1, "« Назад", false);
+        }
+        makeLink(page, "Страница " + std::to_string(page) + " / " + std::to_string(totalPages), true);
+        if (page < totalPages) {
+            makeLink(page + 1, "Вперёд »", false);
+        }
+        html << "</div>";
+    }
+    
+    if (isAdmin) {
+        html << "<div id='modal' class='modal'><div class='modal-content' style='max-width: 700px; max-height: 90vh; overflow-y: auto;'>"
+             << "<h2 id='modal-title'>Добавить интегратора</h2>"
+             << "<form id='modal-form' method='POST' action='/add'>"
+             << "<input type='hidden' name='id' id='edit-id'>"
+             << "<input type='text' name='name' id='name' placeholder='Название' required>"
+             << "<input type='text' name='city' id='city' placeholder='Город' required>"
+             << "<textarea name='description' id='description' placeholder='Описание' required></textarea>"
+             << "<input type='text' name='website' id='website' placeholder='Сайт (например: https://example.com)'>"
+             << "<select name='country_id' id='country_id'>"
+             << "<option value=''>Выберите страну</option>";
+        
+        for (const auto& country : countries.all()) {
+            html << "<option value='" << country.first << "'>" << htmlEscape(country.second) << "</option>";
+        }
+        
+        html << "</select>"
+             << "<label>Продукты (удерживайте Ctrl/Cmd для множественного выбора):</label>"
+             << "<select name='products[]' id='products' multiple>";
+        
+        for (const auto& product : products.all()) {
+            html << "<option value='" << product.first << "'>" << htmlEscape(product.second) << "</option>";
+        }
+        
+        html << "</select>"
+             << "<label>Услуги (удерживайте Ctrl/Cmd для множественного выбора):</label>"
+             << "<select name='services[]' id='services' multiple>";
+        
+        for (const auto& service : services.all()) {
+            html << "<option value='" << service.first << "'>" << htmlEscape(service.second) << "</option>";
+        }
+        
+        html << "</select>"
+             << "<label>Лицензии:</label>"
+             << "<div id='licenses-container' class='items-container'></div>"
+             << "<button type='button' class='add-item-btn' onclick='addLicenseField()'>+ Добавить лицензию</button>"
+             << "<label>Сертификаты:</label>"
+             << "<div id='certificates-container' class='items-container'></div>"
+             << "<button type='button' class='add-item-btn' onclick='addCertificateField()'>+ Добавить сертификат</button>"
+             << "<div class='modal-buttons'>"
+             << "<button type='button' class='cancel-btn' onclick='closeModal()'>Отмена</button>"
+             << "<button type='submit' class='save-btn'>Сохранить</button>"
+             << "</div></form></div></div>"
+             << "<script>"
+             << "let licenseCount = 0;"
+             << "let certificateCount = 0;"
+             << "function addLicenseField() {"
+             << "  const container = document.getElementById('licenses-container');"
+             << "  const div = document.createElement('div');"
+             << "  div.className = 'license-item';"
+             << "  div.innerHTML = '<input type=\"text\" name=\"license_number[]\" placeholder=\"Номер лицензии\" required>"
+             << "    <input type=\"text\" name=\"license_issued_by[]\" placeholder=\"Кем выдана\" required>"
+             << "    <button type=\"button\" class=\"remove-item-btn\" onclick=\"this.parentElement.remove()\">Удалить</button>';"
+             << "  container.appendChild(div);"
+             << "  licenseCount++;"
+             << "}"
+             << "function addCertificateField() {"
+             << "  const container = document.getElementById('certificates-container');"
+             << "  const div = document.createElement('div');"
+             << "  div.className = 'certificate-item';"
+             << "  div.innerHTML = '<input type=\"text\" name=\"certificate_name[]\" placeholder=\"Название сертификата\" required>"
+             << "    <input type=\"text\" name=\"certificate_number[]\" placeholder=\"Номер (необязательно)\">"
+             << "    <input type=\"text\" name=\"certificate_issued_by[]\" placeholder=\"Кем выдан\" required>"
+             << "    <button type=\"button\" class=\"remove-item-btn\" onclick=\"this.parentElement.remove()\">Удалить</button>';"
+             << "  container.appendChild(div);"
+             << "  certificateCount++;"
+             << "}"
+             << "function openAddModal() {"
+             << "  document.getElementById('modal-title').innerText = 'Добавить интегратора';"
+             << "  document.getElementById('modal-form').action = '/add';"
+             << "  document.getElementById('edit-id').value = '';"
+             << "  document.getElementById('name').value = '';"
+             << "  document.getElementById('city').value = '';"
+             << "  document.getElementById('description').value = '';"
+             << "  document.getElementById('website').value = '';"
+             << "  document.getElementById('country_id').value = '';"
+             << "  Array.from(document.getElementById('products').options).forEach(opt => opt.selected = false);"
+             << "  Array.from(document.getElementById('services').options).forEach(opt => opt.selected = false);"
+             << "  document.getElementById('licenses-container').innerHTML = '';"
+             << "  document.getElementById('certificates-container').innerHTML = '';"
+             << "  licenseCount = 0;"
+             << "  certificateCount = 0;"
+             << "  document.getElementById('modal').style.display = 'block';"
+             << "}"
+             << "function openEditModal(id, name, city, desc, website, countryId, productIds, serviceIds, licenses, certificates) {"
+             << "  document.getElementById('modal-title').innerText = 'Изменить интегратора';"
+             << "  document.getElementById('modal-form').action = '/update';"
+             << "  document.getElementById('edit-id').value = id;"
+             << "  document.getElementById('name').value = name || '';"
+             << "  document.getElementById('city').value = city || '';"
+             << "  document.getElementById('description').value = desc || '';"
+             << "  document.getElementById('website').value = website || '';"
+             << "  document.getElementById('country_id').value = countryId || '';"
+             << "  if (productIds) {"
+             << "    const ids = productIds.split(',');"
+             << "    Array.from(document.getElementById('products').options).forEach(opt => {"
+             << "      opt.selected = ids.includes(opt.value);"
+             << "    });"
+             << "  }"
+             << "  if (serviceIds) {"
+             << "    const ids = serviceIds.split(',');"
+             << "    Array.from(document.getElementById('services').options).forEach(opt => {"
+             << "      opt.selected = ids.includes(opt.value);"
+             << "    });"
+             << "  }"
+             << "  const licensesContainer = document.getElementById('licenses-container');"
+             << "  licensesContainer.innerHTML = '';"
+             << "  if (licenses) {"
+             << "    const licenseList = JSON.parse(licenses);"
+             << "    licenseList.forEach(function(lic) {"
+             << "      const div = document.createElement('div');"
+             << "      div.className = 'license-item';"
+             << "      div.innerHTML = '<input type=\"text\" name=\"license_number[]\" value=\"' + (lic.number || '') + '\" placeholder=\"Номер лицензии\" required>"
+             << "        <input type=\"text\" name=\"license_issued_by[]\" value=\"' + (lic.issuedBy || '') + '\" placeholder=\"Кем выдана\" required>"
+             << "        <button type=\"button\" class=\"remove-item-btn\" onclick=\"this.parentElement.remove()\">Удалить</button>';"
+             << "      licensesContainer.appendChild(div);"
+             << "    });"
+             << "  }"
+             << "  const certificatesContainer = document.getElementById('certificates-container');"
+             << "  certificatesContainer.innerHTML = '';"
+             << "  if (certificates) {"
+             << "    const certList = JSON.parse(certificates);"
+             << "    certList.forEach(function(cert) {"
+             << "      const div = document.createElement('div');"
+             << "      div.className = 'certificate-item';"
+             << "      div.innerHTML = '<input type=\"text\" name=\"certificate_name[]\" value=\"' + (cert.name || '') + '\" placeholder=\"Название сертификата\" required>"
+             << "        <input type=\"text\" name=\"certificate_number[]\" value=\"' + (cert.number || '') + '\" placeholder=\"Номер (необязательно)\">"
+             << "        <input type=\"text\" name=\"certificate_issued_by[]\" value=\"' + (cert.issuedBy || '') + '\" placeholder=\"Кем выдан\" required>"
+             << "        <button type=\"button\" class=\"remove-item-btn\" onclick=\"this.parentElement.remove()\">Удалить</button>';"
+             << "      certificatesContainer.appendChild(div);"
+             << "    });"
+             << "  }"
+             << "  document.getElementById('modal').style.display = 'block';"
+             << "}"
+             << "function closeModal() { document.getElementById('modal').style.display = 'none'; }"
+             << "window.onclick = function(event) { if (event.target == document.getElementById('modal')) { closeModal(); } }"
+             << "</script>";
+    }
+    
+    html << "</body></html>";
+}
+
+std::string generateMainPage(
+    const std::vector<Integrator>& integrators,
+    bool isAdmin,
+    bool isLoggedIn,
+    const std::string& username,
+    const std::string& tabToken,
+    const std::vector<std::string>& cities,
+    const Dictionary& countries,
+    const Dictionary& products,
+    const Dictionary& services,
+    const std::string& cityQuery,
+    const std::string& filterCityParam,
+    const std::string& searchName,
+    const std::string& textQuery,
+    const std::string& productFilterParam,
+    const std::string& serviceFilterParam,
+    const std::string& sortOption,
+    int page,
+    int totalPages,
+    int totalCount,
+    const std::map<int, RatingStats>& ratingStats,
+    const std::map<int, std::vector<Rating>>& integratorRatings,
+    int pageSize,
+    bool relevanceSort
+) {
+    std::vector<const Integrator*> items;
+    items.reserve(integrators.size());
+    for (const auto& integrator : integrators) items.push_back(&integrator);
+
+    std::string result;
+    StringAppendBuffer buffer(result);
+    std::ostream html(&buffer);
+    ListingQuery query;
+    query.city = cityQuery;
+    query.filterCity = filterCityParam;
+    query.name = searchName;
+    query.text = textQuery;
+    query.product = productFilterParam;
+    query.service = serviceFilterParam;
+    query.sort = sortOption;
+    query.pageSize = pageSize;
+    query.useTextIndex = relevanceSort;
+    renderMainPageHeader(html, isAdmin, username, tabToken, cities, products, services, query);
+    renderMainPageListing(html, nullptr, items, isAdmin, isLoggedIn, countries, products, services, query, page,
+                          totalPages, totalCount, ratingStats, integratorRatings);
+    return result;
+}
@@ -0,0 +1,179 @@
+#include "password_hasher.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+namespace {
+
+const char* const PREFIX = "$scrypt$";
+const size_t SALT_BYTES = 16;
+const size_t KEY_BYTES = 32;
+
+std::string base64Encode(const unsigned char* data, size_t size) {
+    std::string result(4 * ((size + 2) / 3), '\0');
+    int length = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&result[0]), data, static_cast<int>(size));
+    result.resize(length);
+    return result;
+}
+
+bool base64Decode(const std::string& text, std::vector<unsigned char>& out) {
+    if (text.empty() || text.size() % 4 != 0) return false;
+    out.assign(3 * text.size() / 4, 0);
+    int length = EVP_DecodeBlock(out.data(), reinterpret_cast<const unsigned char*>(text.data()),
+                                 static_cast<int>(text.size()));
+    if (length < 0) return false;
+    // EVP_DecodeBlock не учитывает дополнение '='
+    size_t padding = 0;
+    if (text[text.size() - 1] == '=') padding++;
+    if (text[text.size() - 2] == '=') padding++;
+    out.resize(length - padding);
+    return true;
+}
+
+bool deriveKey(const std::string& password, const unsigned char* salt, size_t saltSize,
+               const ScryptParams& params, unsigned char* key, size_t keySize) {
+    uint64_t n = 1ULL << params.logN;
+    uint64_t maxMemory = 128ULL * params.r * n * params.p + 128ULL * params.r * n + (1u << 20);
+    return EVP_PBE_scrypt(password.data(), password.size(), salt, saltSize, n, params.r, params.p,
+                          maxMemory, key, keySize) == 1;
+}
+
+} // namespace
+
+std::string hashPassword(const std::string& password, const ScryptParams& params) {
+    unsigned char salt[SALT_BYTES];
+    unsigned char key[KEY_BYTES];
+    if (RAND_bytes(salt, sizeof(salt)) != 1 || !deriveKey(password, salt, sizeof(salt), params, key, sizeof(key))) {
+        return "";
+    }
+    char header[64];
+    snprintf(header, sizeof(header), "%sln=%d,r=%d,p=%d$", PREFIX, params.logN, params.r, params.p);
+    return header + base64Encode(salt, sizeof(salt)) + "$" + base64Encode(key, sizeof(key));
+}
+
+bool verifyPassword(const std::string& password, const std::string& stored, const ScryptParams& params,
+                    bool& needsRehash) {
+    needsRehash = false;
+    if (stored.compare(0, strlen(PREFIX), PREFIX) != 0) {
+        // Открытый текст из старых строк users
+        bool equal = stored.size() == password.size() &&
+                     CRYPTO_memcmp(stored.data(), password.data(), password.size()) == 0;
+        needsRehash = equal;
+        return equal;
+    }
+
+    ScryptParams storedParams;
+    char saltText[64];
+    char keyText[128];
+    if (sscanf(stored.c_str() + strlen(PREFIX), "ln=%d,r=%d,p=%d$%63[^$]$%127s", &storedParams.logN,
+               &storedParams.r, &storedParams.p, saltText, keyText) != 5 ||
+        storedParams.logN < 1 || storedParams.logN > 30 || storedParams.r < 1 || storedParams.p < 1) {
+        return false;
+    }
+    std::vector<unsigned char> salt;
+    std::vector<unsigned char> expected;
+    if (!base64Decode(saltText, salt) || !base64Decode(keyText, expected) || expected.empty()) {
+        return false;
+    }
+    std::vector<unsigned char> key(expected.size());
+    if (!deriveKey(password, salt.data(), salt.size(), storedParams, key.data(), key.size())) {
+        return false;
+    }
+    bool equal = CRYPTO_memcmp(key.data(), expected.data(), key.size()) == 0;
+    needsRehash = equal && (storedParams.logN != params.logN || storedParams.r != params.r ||
+                            storedParams.p != params.p);
+    return equal;
+}
+
+PasswordHasher::PasswordHasher(size_t threads, size_t queueLimit, const ScryptParams& params, size_t owners)
+    : params(params), queueLimit(queueLimit), completions(std::max<size_t>(owners, 1)) {
+    for (auto& completion : completions) {
+        int* pipeFds = completion.pipeFds;
+        if (pipe(pipeFds) == 0) {
+            fcntl(pipeFds[0], F_SETFL, O_NONBLOCK);
+            fcntl(pipeFds[1], F_SETFL, O_NONBLOCK);
+            fcntl(pipeFds[0], F_SETFD, FD_CLOEXEC);
+            fcntl(pipeFds[1], F_SETFD, FD_CLOEXEC);
+        }
+    }
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(&PasswordHasher::workerLoop, this);
+    }
+}
+
+PasswordHasher::~PasswordHasher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const auto& completion : completions) {
+        for (int fd : completion.pipeFds) {
+            if (fd >= 0) close(fd);
+        }
+    }
+}
+
+bool PasswordHasher::submit(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (stopping || inFlight >= queueLimit || job.owner >= completions.size()) {
+            return false;
+        }
+        inFlight++;
+        queue.push_back(std::move(job));
+    }
+    wake.notify_one();
+    return true;
+}
+
+std::vector<PasswordHasher::Job> PasswordHasher::takeCompleted(size_t owner) {
+    Completion& completion = completions[owner];
+    // Сбрасываем сигнал до выборки: результат, пришедший после, снова разбудит poll
+    char drain[64];
+    while (read(completion.pipeFds[0], drain, sizeof(drain)) > 0) {}
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<Job> result;
+    result.swap(completion.jobs);
+    return result;
+}
+
+void PasswordHasher::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (stopping) return;
+        Job job = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        if (job.kind == Kind::Hash) {
+            job.newHash = hashPassword(job.password, params);
+        } else {
+            bool needsRehash = false;
+            job.verified = verifyPassword(job.password, job.stored, params, needsRehash);
+            if (needsRehash) {
+                job.newHash = hashPassword(job.password, params);
+            }
+        }
+        // Пароль больше не нужен
+        std::fill(job.password.begin(), job.password.end(), '\0');
+
+        lock.lock();
+        Completion& completion = completions[job.owner];
+        completion.jobs.push_back(std::move(job));
+        inFlight--;
+        char signal = 1;
+        if (write(completion.pipeFds[1], &signal, 1) < 0) {
+            // pipe полон - poll и так проснётся
+        }
+    }
+}
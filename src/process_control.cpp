@@ -0,0 +1,260 @@
+#include "process_control.h"
+#include "logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+extern char** environ;
+
+namespace {
+
+int signalPipe[2] = {-1, -1};
+
+void onSignal(int signo) {
+    int savedErrno = errno;
+    char code = signo == SIGUSR2 ? 'R' : 'T';
+    if (write(signalPipe[1], &code, 1) < 0) {
+        // pipe полон - сигнал уже ждёт обработки
+    }
+    errno = savedErrno;
+}
+
+bool setCloseOnExec(int fd, bool enabled) {
+    int flags = fcntl(fd, F_GETFD);
+    if (flags < 0) return false;
+    flags = enabled ? (flags | FD_CLOEXEC) : (flags & ~FD_CLOEXEC);
+    return fcntl(fd, F_SETFD, flags) == 0;
+}
+
+bool isListeningSocket(int fd) {
+    int listening = 0;
+    socklen_t length = sizeof(listening);
+    return getsockopt(fd, SOL_SOCKET, SO_ACCEPTCONN, &listening, &length) == 0 && listening;
+}
+
+bool startsWith(const char* text, const char* prefix) {
+    return strncmp(text, prefix, strlen(prefix)) == 0;
+}
+
+} // namespace
+
+int installProcessSignals() {
+    if (pipe(signalPipe) < 0) {
+        return -1;
+    }
+    for (int fd : signalPipe) {
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        setCloseOnExec(fd, true);
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = onSignal;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGTERM, &action, nullptr);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGUSR2, &action, nullptr);
+    // Клиент, закрывший соединение, не должен завершать сервер через send()
+    signal(SIGPIPE, SIG_IGN);
+    return signalPipe[0];
+}
+
+ProcessSignal takeProcessSignal(int fd) {
+    ProcessSignal result = ProcessSignal::None;
+    char codes[16];
+    ssize_t count;
+    while ((count = read(fd, codes, sizeof(codes))) > 0) {
+        for (ssize_t i = 0; i < count; i++) {
+            if (codes[i] == 'T') {
+                result = ProcessSignal::Shutdown;
+            } else if (result == ProcessSignal::None) {
+                result = ProcessSignal::Restart;
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<int> inheritedListenSockets() {
+    std::vector<int> sockets;
+    int first = -1;
+    int count = 0;
+    const char* listenFd = getenv("LISTEN_FD");
+    const char* listenFdCount = getenv("LISTEN_FD_COUNT");
+    const char* systemdFds = getenv("LISTEN_FDS");
+    const char* systemdPid = getenv("LISTEN_PID");
+    if (listenFd) {
+        first = atoi(listenFd);
+        count = listenFdCount ? atoi(listenFdCount) : 1;
+    } else if (systemdFds && systemdPid && atoi(systemdPid) == getpid()) {
+        first = 3;   // SD_LISTEN_FDS_START
+        count = atoi(systemdFds);
+    }
+    for (int i = 0; first >= 0 && i < count; i++) {
+        int fd = first + i;
+        if (!isListeningSocket(fd)) {
+            LOG_WARN("Унаследованный дескриптор не является слушающим сокетом").field("fd", fd);
+            continue;
+        }
+        setCloseOnExec(fd, true);
+        sockets.push_back(fd);
+    }
+    return sockets;
+}
+
+pid_t spawnReplacement(const std::vector<int>& listenSockets, char** argv, int& readyFd) {
+    // Окружение и аргументы готовятся до fork: между fork и exec в многопоточном
+    // процессе допустимы только async-signal-safe вызовы
+    std::vector<std::string> environment;
+    for (char** entry = environ; *entry; entry++) {
+        if (!startsWith(*entry, "LISTEN_FD=") && !startsWith(*entry, "LISTEN_FD_COUNT=") &&
+            !startsWith(*entry, "LISTEN_FDS=") && !startsWith(*entry, "LISTEN_PID=") &&
+            !startsWith(*entry, "LISTEN_READY_FD=")) {
+            environment.push_back(*entry);
+        }
+    }
+    environment.push_back("LISTEN_FD=3");
+    environment.push_back("LISTEN_FD_COUNT=" + std::to_string(listenSockets.size()));
+    int readyTarget = 3 + static_cast<int>(listenSockets.size());
+    environment.push_back("LISTEN_READY_FD=" + std::to_string(readyTarget));
+    std::vector<char*> envp;
+    for (auto& entry : environment) envp.push_back(&entry[0]);
+    envp.push_back(nullptr);
+    std::vector<int> sockets(listenSockets);
+#ifdef __linux__
+    const char* executable = "/proc/self/exe";
+#else
+    const char* executable = argv[0];
+#endif
+
+    // Ошибка exec передаётся родителю через pipe; при успешном exec он закрывается (FD_CLOEXEC)
+    int errorPipe[2];
+    if (pipe(errorPipe) < 0) {
+        return -1;
+    }
+    setCloseOnExec(errorPipe[0], true);
+    setCloseOnExec(errorPipe[1], true);
+    // Готовность нового процесса: он пишет байт, когда его циклы запущены
+    int readyPipe[2];
+    if (pipe(readyPipe) < 0) {
+        close(errorPipe[0]);
+        close(errorPipe[1]);
+        return -1;
+    }
+    setCloseOnExec(readyPipe[0], true);
+    setCloseOnExec(readyPipe[1], true);
+    // Копии сокетов в ребёнке размещаются выше всех занятых номеров, чтобы
+    // перестановка в 3, 4, ... не затёрла ещё не перенесённый сокет
+    int parking = std::max(errorPipe[1], readyPipe[1]) + 1;
+    for (int fd : sockets) parking = fd >= parking ? fd + 1 : parking;
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(errorPipe[0]);
+        close(errorPipe[1]);
+        close(readyPipe[0]);
+        close(readyPipe[1]);
+        return -1;
+    }
+    if (pid == 0) {
+        close(errorPipe[0]);
+        close(readyPipe[0]);
+        int readyWriter = fcntl(readyPipe[1], F_DUPFD_CLOEXEC, parking);
+        bool ready = readyWriter >= 0;
+        for (size_t i = 0; ready && i < sockets.size(); i++) {
+            sockets[i] = fcntl(sockets[i], F_DUPFD_CLOEXEC, parking);
+            ready = sockets[i] >= 0;
+        }
+        for (size_t i = 0; ready && i < sockets.size(); i++) {
+            int target = 3 + static_cast<int>(i);
+            // dup2 снимает FD_CLOEXEC с нового дескриптора
+            ready = dup2(sockets[i], target) == target;
+        }
+        ready = ready && dup2(readyWriter, readyTarget) == readyTarget;
+        if (ready) {
+            execve(executable, argv, envp.data());
+        }
+        int error = errno;
+        if (write(errorPipe[1], &error, sizeof(error)) < 0) {
+            // родитель узнает о неудаче по коду завершения
+        }
+        _exit(127);
+    }
+
+    close(errorPipe[1]);
+    close(readyPipe[1]);
+    int childError = 0;
+    ssize_t count;
+    do {
+        count = read(errorPipe[0], &childError, sizeof(childError));
+    } while (count < 0 && errno == EINTR);
+    close(errorPipe[0]);
+    if (count > 0) {
+        close(readyPipe[0]);
+        waitpid(pid, nullptr, 0);
+        LOG_ERROR("Новый процесс не запущен").field("error", strerror(childError));
+        return -1;
+    }
+    readyFd = readyPipe[0];
+    return pid;
+}
+
+bool waitReplacementReady(pid_t pid, int readyFd, int timeoutSeconds) {
+    // Байт - циклы нового процесса запущены; конец файла - процесс завершился
+    // при старте (нет БД, ошибка настроек), не сообщив о готовности
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(timeoutSeconds);
+    char signal = 0;
+    ssize_t count = -1;
+    while (true) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (left.count() <= 0) break;
+        pollfd readyPoll = {readyFd, POLLIN, 0};
+        int polled = poll(&readyPoll, 1, static_cast<int>(left.count()));
+        if (polled < 0 && errno == EINTR) continue;
+        if (polled <= 0) break;
+        do {
+            count = read(readyFd, &signal, 1);
+        } while (count < 0 && errno == EINTR);
+        break;
+    }
+    close(readyFd);
+    if (count == 1) {
+        return true;
+    }
+
+    int status = 0;
+    if (count < 0) {
+        // Не успел: слушающие сокеты он ещё не разбирает, останавливаем сразу
+        LOG_ERROR("Новый процесс не сообщил о готовности").field("pid", pid).field("timeout_s", timeoutSeconds);
+        kill(pid, SIGKILL);
+    }
+    waitpid(pid, &status, 0);
+    LOG_ERROR("Новый процесс завершился до готовности")
+        .field("pid", pid)
+        .field("exit_code", WIFEXITED(status) ? WEXITSTATUS(status) : -1)
+        .field("signal", WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+    return false;
+}
+
+void notifyReplacementReady() {
+    const char* readyFd = getenv("LISTEN_READY_FD");
+    if (!readyFd) return;
+    int fd = atoi(readyFd);
+    unsetenv("LISTEN_READY_FD");
+    char signal = 1;
+    if (write(fd, &signal, 1) != 1) {
+        LOG_WARN("Не удалось сообщить о готовности предыдущему процессу").field("error", strerror(errno));
+    }
+    close(fd);
+}
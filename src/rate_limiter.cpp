@@ -0,0 +1,88 @@
+#include "rate_limiter.h"
+#include <algorithm>
+#include <cmath>
+
+const char* rateClassName(RateClass rateClass) {
+    switch (rateClass) {
+        case RateClass::Auth: return "auth";
+        case RateClass::Read: return "read";
+        case RateClass::Write: return "write";
+        default: return "other";
+    }
+}
+
+uint64_t rateKey(std::string_view prefix, std::string_view value) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : prefix) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    hash = (hash ^ ':') * 1099511628211ULL;
+    for (unsigned char c : value) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    // Финальное перемешивание (splitmix64): младшие и старшие биты выбирают шард и ячейку
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebULL;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+RateLimiter::RateLimiter(size_t slots, const Budget (&budgets)[static_cast<int>(RateClass::Count)])
+    : shards(new Shard[SHARDS]),
+      slotsPerShard(std::max(slots / SHARDS, PROBE_WINDOW)),
+      epoch(std::chrono::steady_clock::now()) {
+    for (size_t i = 0; i < SHARDS; i++) {
+        shards[i].slots.reset(new Slot[slotsPerShard]);
+    }
+    for (int i = 0; i < static_cast<int>(RateClass::Count); i++) {
+        this->budgets[i] = budgets[i];
+    }
+}
+
+bool RateLimiter::allow(uint64_t key, RateClass rateClass, int& retryAfterSeconds) {
+    const Budget& budget = budgets[static_cast<int>(rateClass)];
+    // Класс входит в ключ: у клиента отдельный бюджет на каждый класс
+    key ^= (static_cast<uint64_t>(rateClass) + 1) * 0x9e3779b97f4a7c15ULL;
+    if (key == 0) key = 1;
+    // Миллисекунды с запуска; переполнение через 49 дней безвредно - разности беззнаковые
+    uint32_t now = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - epoch).count());
+
+    Shard& shard = shards[key % SHARDS];
+    size_t start = (key >> 32) % slotsPerShard;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+
+    Slot* slot = nullptr;
+    Slot* victim = nullptr;
+    for (size_t i = 0; i < PROBE_WINDOW; i++) {
+        Slot& candidate = shard.slots[(start + i) % slotsPerShard];
+        if (candidate.key == key) {
+            slot = &candidate;
+            break;
+        }
+        if (victim == nullptr || (victim->key != 0 && (candidate.key == 0 ||
+            static_cast<uint32_t>(now - candidate.lastMillis) > static_cast<uint32_t>(now - victim->lastMillis)))) {
+            victim = &candidate;
+        }
+    }
+    if (slot == nullptr) {
+        slot = victim;
+        slot->key = key;
+        slot->tokens = static_cast<float>(budget.burst);
+    } else {
+        double refill = static_cast<uint32_t>(now - slot->lastMillis) * budget.ratePerSecond / 1000.0;
+        slot->tokens = static_cast<float>(std::min(budget.burst, slot->tokens + refill));
+    }
+    slot->lastMillis = now;
+
+    if (slot->tokens >= 1.0f) {
+        slot->tokens -= 1.0f;
+        return true;
+    }
+    retryAfterSeconds = budget.ratePerSecond > 0
+        ? std::max(1, static_cast<int>(std::ceil((1.0 - slot->tokens) / budget.ratePerSecond)))
+        : 60;
+    return false;
+}
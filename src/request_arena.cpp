@@ -0,0 +1,5 @@
+#include "request_arena.h"
+
+RequestArena::RequestArena(size_t blockSize)
+    : block(new char[blockSize]),
+      resource(block.get(), blockSize, std::pmr::new_delete_resource()) {}
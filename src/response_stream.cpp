@@ -0,0 +1,59 @@
+#include "response_stream.h"
+#include "http_utils.h"
+#include <cerrno>
+#include <cstdio>
+#include <sys/socket.h>
+
+ResponseStream::ResponseStream(int socket, int statusCode, const char* contentType, size_t chunkThreshold)
+    : socket(socket), chunkThreshold(chunkThreshold) {
+    head = std::string("HTTP/1.1 ") + httpStatusLine(statusCode) + "\r\nContent-Type: " + contentType + "\r\n";
+    buffer.reserve(chunkThreshold + chunkThreshold / 4);
+}
+
+bool ResponseStream::sendAll(const char* data, size_t size) {
+    while (size > 0 && !failed) {
+        ssize_t sent = send(socket, data, size, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            failed = true;
+            break;
+        }
+        data += sent;
+        size -= sent;
+        bytesSent += sent;
+    }
+    return !failed;
+}
+
+void ResponseStream::sendChunk() {
+    if (buffer.empty()) return;
+    char size[24];
+    int length = snprintf(size, sizeof(size), "%zx\r\n", buffer.size());
+    buffer += "\r\n";
+    sendAll(size, length);
+    sendAll(buffer.data(), buffer.size());
+    buffer.clear();
+}
+
+void ResponseStream::flush(bool force) {
+    if (buffer.empty() || (!force && buffer.size() < chunkThreshold)) return;
+    if (!chunked) {
+        chunked = true;
+        head += "Transfer-Encoding: chunked\r\nConnection: close\r\n\r\n";
+        sendAll(head.data(), head.size());
+    }
+    sendChunk();
+}
+
+size_t ResponseStream::finish() {
+    if (chunked) {
+        sendChunk();
+        sendAll("0\r\n\r\n", 5);
+    } else {
+        head += "Content-Length: " + std::to_string(buffer.size()) + "\r\nConnection: close\r\n\r\n";
+        head += buffer;
+        sendAll(head.data(), head.size());
+        buffer.clear();
+    }
+    return bytesSent;
+}
@@ -0,0 +1,234 @@
+#include "search_index.h"
+#include "utf8.h"
+#include <algorithm>
+
+namespace {
+
+// Ключ n-граммы: до трёх кодовых точек по 21 бит (0 - символа нет)
+uint64_t gramKey(const uint32_t* codePoints, size_t length) {
+    uint64_t key = 0;
+    for (size_t i = 0; i < length; i++) {
+        key |= static_cast<uint64_t>(codePoints[i] + 1) << (21 * i);
+    }
+    return key;
+}
+
+std::vector<uint32_t> toCodePoints(const std::string& str) {
+    std::vector<uint32_t> codePoints;
+    codePoints.reserve(str.size());
+    const char* p = str.data();
+    const char* end = p + str.size();
+    while (p < end) {
+        codePoints.push_back(utf8Decode(p, end));
+    }
+    return codePoints;
+}
+
+// Пересечение отсортированного вектора со сжатым списком без его распаковки
+void intersectInto(std::vector<uint32_t>& rows, const PostingList& list) {
+    std::vector<uint32_t> result;
+    result.reserve(std::min<size_t>(rows.size(), list.size()));
+    PostingList::Iterator it = list.begin();
+    for (uint32_t row : rows) {
+        it.advanceTo(row);
+        if (!it.isValid()) break;
+        if (it.value() == row) {
+            result.push_back(row);
+        }
+    }
+    rows.swap(result);
+}
+
+} // namespace
+
+PostingList::Iterator::Iterator(const PostingList* list)
+    : list(list), p(list->bytes.data()), end(list->bytes.data() + list->bytes.size()) {
+    next();
+}
+
+void PostingList::Iterator::next() {
+    if (p >= end) {
+        valid = false;
+        return;
+    }
+    uint32_t delta = 0;
+    int shift = 0;
+    while (p < end) {
+        uint8_t byte = *p++;
+        delta |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) break;
+        shift += 7;
+    }
+    current += delta;
+    valid = true;
+}
+
+void PostingList::Iterator::advanceTo(uint32_t target) {
+    if (!valid || current >= target) return;
+
+    // Последняя точка пропуска, предшествующая target, и только если она впереди
+    const auto& skips = list->skips;
+    auto it = std::lower_bound(skips.begin(), skips.end(), target,
+        [](const std::pair<uint32_t, uint32_t>& skip, uint32_t value) { return skip.first < value; });
+    if (it != skips.begin()) {
+        --it;
+        const uint8_t* jump = list->bytes.data() + it->second;
+        if (jump > p) {
+            current = it->first;
+            p = jump;
+            next();
+        }
+    }
+    while (valid && current < target) {
+        next();
+    }
+}
+
+void PostingList::append(uint32_t value) {
+    if (count > 0 && count % SKIP_INTERVAL == 0) {
+        skips.push_back({last, static_cast<uint32_t>(bytes.size())});
+    }
+    uint32_t delta = count == 0 ? value : value - last;
+    while (delta >= 0x80) {
+        bytes.push_back(static_cast<uint8_t>(delta | 0x80));
+        delta >>= 7;
+    }
+    bytes.push_back(static_cast<uint8_t>(delta));
+    last = value;
+    count++;
+}
+
+std::vector<uint32_t> PostingList::decode() const {
+    std::vector<uint32_t> values;
+    values.reserve(count);
+    for (Iterator it = begin(); it.isValid(); it.next()) {
+        values.push_back(it.value());
+    }
+    return values;
+}
+
+void SearchIndex::indexGrams(std::unordered_map<uint64_t, PostingList>& grams, const std::string& folded, uint32_t row) {
+    std::vector<uint32_t> codePoints = toCodePoints(folded);
+    std::vector<uint64_t> keys;
+    keys.reserve(codePoints.size() * 3);
+    for (size_t i = 0; i < codePoints.size(); i++) {
+        for (size_t length = 1; length <= 3 && i + length <= codePoints.size(); length++) {
+            keys.push_back(gramKey(&codePoints[i], length));
+        }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    for (uint64_t key : keys) {
+        grams[key].append(row);
+    }
+}
+
+void SearchIndex::build(const std::vector<Integrator>& integrators) {
+    nameGrams.clear();
+    cityGrams.clear();
+    productRows.clear();
+    serviceRows.clear();
+    foldedNames.clear();
+    foldedCities.clear();
+    rowCount = static_cast<uint32_t>(integrators.size());
+    foldedNames.reserve(rowCount);
+    foldedCities.reserve(rowCount);
+
+    for (uint32_t row = 0; row < rowCount; row++) {
+        const Integrator& integrator = integrators[row];
+        foldedNames.push_back(utf8FoldForSearch(integrator.name));
+        foldedCities.push_back(utf8FoldForSearch(integrator.city));
+        indexGrams(nameGrams, foldedNames.back(), row);
+        indexGrams(cityGrams, foldedCities.back(), row);
+        for (int productId : integrator.productIds) {
+            productRows[productId].append(row);
+        }
+        for (int serviceId : integrator.serviceIds) {
+            serviceRows[serviceId].append(row);
+        }
+    }
+}
+
+bool SearchIndex::collectGrams(const std::unordered_map<uint64_t, PostingList>& grams, const std::string& foldedPattern,
+                               std::vector<const PostingList*>& lists) {
+    std::vector<uint32_t> codePoints = toCodePoints(foldedPattern);
+    if (codePoints.empty()) return true;
+
+    // Для образцов до 3 символов список n-граммы и есть точный ответ,
+    // для длинных - пересечение триграмм с последующей проверкой подстроки
+    std::vector<uint64_t> keys;
+    if (codePoints.size() <= 3) {
+        keys.push_back(gramKey(codePoints.data(), codePoints.size()));
+    } else {
+        for (size_t i = 0; i + 3 <= codePoints.size(); i++) {
+            keys.push_back(gramKey(&codePoints[i], 3));
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    }
+    for (uint64_t key : keys) {
+        auto it = grams.find(key);
+        if (it == grams.end()) return false;
+        lists.push_back(&it->second);
+    }
+    return true;
+}
+
+std::vector<uint32_t> SearchIndex::search(const SearchQuery& query) const {
+    std::vector<uint32_t> rows;
+    std::vector<const PostingList*> lists;
+
+    std::string foldedName = utf8FoldForSearch(query.name);
+    std::string foldedCity = utf8FoldForSearch(query.city);
+    if (!collectGrams(nameGrams, foldedName, lists)) return rows;
+    if (!collectGrams(cityGrams, foldedCity, lists)) return rows;
+    if (query.productId != 0) {
+        auto it = productRows.find(query.productId);
+        if (it == productRows.end()) return rows;
+        lists.push_back(&it->second);
+    }
+    if (query.serviceId != 0) {
+        auto it = serviceRows.find(query.serviceId);
+        if (it == serviceRows.end()) return rows;
+        lists.push_back(&it->second);
+    }
+
+    if (lists.empty()) {
+        rows.resize(rowCount);
+        for (uint32_t row = 0; row < rowCount; row++) {
+            rows[row] = row;
+        }
+        return rows;
+    }
+
+    // Пересекаем все списки всех полей, начиная с самого короткого
+    std::sort(lists.begin(), lists.end(), [](const PostingList* a, const PostingList* b) {
+        return a->size() < b->size();
+    });
+    rows = lists[0]->decode();
+    for (size_t i = 1; i < lists.size() && !rows.empty(); i++) {
+        intersectInto(rows, *lists[i]);
+    }
+
+    // Триграммы не гарантируют непрерывность - проверяем подстроку у оставшихся кандидатов
+    bool verifyName = foldedName.size() > 3 && toCodePoints(foldedName).size() > 3;
+    bool verifyCity = foldedCity.size() > 3 && toCodePoints(foldedCity).size() > 3;
+    if (verifyName || verifyCity) {
+        rows.erase(std::remove_if(rows.begin(), rows.end(), [&](uint32_t row) {
+            return (verifyName && foldedNames[row].find(foldedName) == std::string::npos) ||
+                   (verifyCity && foldedCities[row].find(foldedCity) == std::string::npos);
+        }), rows.end());
+    }
+    return rows;
+}
+
+size_t SearchIndex::memoryUsage() const {
+    size_t total = 0;
+    for (const auto& entry : nameGrams) total += sizeof(entry) + entry.second.byteSize();
+    for (const auto& entry : cityGrams) total += sizeof(entry) + entry.second.byteSize();
+    for (const auto& entry : productRows) total += sizeof(entry) + entry.second.byteSize();
+    for (const auto& entry : serviceRows) total += sizeof(entry) + entry.second.byteSize();
+    for (const auto& value : foldedNames) total += value.size();
+    for (const auto& value : foldedCities) total += value.size();
+    return total;
+}
@@ -1,950 +1,572 @@
 #include "database.h"
+#include "catalog.h"
+#include "http_utils.h"
+#include "pages.h"
+#include "form_parser.h"
+#include "metrics.h"
+#include "logger.h"
+#include "tracing.h"
+#include "slow_query_log.h"
+#include "password_hasher.h"
+#include "session_tokens.h"
+#include "session_sweeper.h"
+#include "rate_limiter.h"
+#include "process_control.h"
+#include "listeners.h"
+#include "listing.h"
+#include "api.h"
+#include "response_stream.h"
+#include "data_versions.h"
+#include "request_arena.h"
 #include <iostream>
 #include <sstream>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <cstdlib>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <poll.h>
+#include <fcntl.h>
 #include <map>
-#include <random>
 #include <algorithm>
 #include <cctype>
 #include <iomanip>
+#include <chrono>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 std::string generateSessionId() {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
-    static std::uniform_int_distribution<> dis(0, 15);
-    
-    const char* hex = "0123456789abcdef";
-    std::string sessionId;
-    for (int i = 0; i < 32; i++) {
-        sessionId += hex[dis(gen)];
-    }
-    return sessionId;
+    // 128 бит из CSPRNG: идентификатор нельзя предсказать по соседним
+    return randomHex(16);
 }
 
-std::string urlDecode(const std::string& str) {
-    std::string result;
-    for (size_t i = 0; i < str.length(); i++) {
-        if (str[i] == '%' && i + 2 < str.length()) {
-            int value;
-            std::istringstream(str.substr(i + 1, 2)) >> std::hex >> value;
-            result += static_cast<char>(value);
-            i += 2;
-        } else if (str[i] == '+') {
-            result += ' ';
-        } else {
-            result += str[i];
-        }
-    }
-    return result;
-}
+// Поля формы добавления/редактирования интегратора
+struct IntegratorForm {
+    std::string name;
+    std::string city;
+    std::string description;
+    std::string website;
+    int countryId = 0;
+    std::vector<License> licenses;
+    std::vector<Certificate> certificates;
+    std::vector<int> productIds;
+    std::vector<int> serviceIds;
+};
 
-std::string urlEncode(const std::string& value) {
-    std::ostringstream escaped;
-    escaped << std::hex << std::uppercase;
-    for (unsigned char c : value) {
-        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
-            escaped << c;
-        } else if (c == ' ') {
-            escaped << '+';
-        } else {
-            escaped << '%' << std::setw(2) << int(c) << std::setw(0);
+// Массивы license_*[] и certificate_*[] сопоставляются по номеру элемента;
+// неполные лицензии и сертификаты без названия или выдавшего органа пропускаются
+IntegratorForm readIntegratorForm(const FormData& form) {
+    IntegratorForm result;
+    result.name = std::string(form.get("name"));
+    result.city = std::string(form.get("city"));
+    result.description = std::string(form.get("description"));
+    result.website = std::string(form.get("website"));
+    parseFormInt(form.get("country_id"), result.countryId);
+    
+    FormValues licenseNumbers = form.getAll("license_number[]");
+    FormValues licenseIssuers = form.getAll("license_issued_by[]");
+    for (size_t i = 0; i < licenseNumbers.size(); i++) {
+        if (!licenseNumbers[i].empty() && !licenseIssuers[i].empty()) {
+            result.licenses.push_back({std::string(licenseNumbers[i]), std::string(licenseIssuers[i])});
         }
     }
-    return escaped.str();
-}
-
-std::string htmlEscape(const std::string& str) {
-    std::string result;
-    for (char c : str) {
-        if (c == '&') {
-            result += "&amp;";
-        } else if (c == '<') {
-            result += "&lt;";
-        } else if (c == '>') {
-            result += "&gt;";
-        } else if (c == '"') {
-            result += "&quot;";
-        } else if (c == '\'') {
-            result += "&#39;";
-        } else {
-            result += c;
+    
+    FormValues certificateNames = form.getAll("certificate_name[]");
+    FormValues certificateNumbers = form.getAll("certificate_number[]");
+    FormValues certificateIssuers = form.getAll("certificate_issued_by[]");
+    for (size_t i = 0; i < certificateNames.size(); i++) {
+        if (!certificateNames[i].empty() && !certificateIssuers[i].empty()) {
+            result.certificates.push_back({std::string(certificateNames[i]), std::string(certificateIssuers[i]),
+                                           std::string(certificateNumbers[i])});
         }
     }
+    
+    for (std::string_view value : form.getAll("products[]")) {
+        int id;
+        if (parseFormInt(value, id)) result.productIds.push_back(id);
+    }
+    for (std::string_view value : form.getAll("services[]")) {
+        int id;
+        if (parseFormInt(value, id)) result.serviceIds.push_back(id);
+    }
     return result;
 }
 
-std::string toLowerStr(const std::string& str) {
-    std::string res = str;
-    std::transform(res.begin(), res.end(), res.begin(), [](unsigned char c){ return std::tolower(c); });
-    return res;
-}
+// Маршруты для метрик; порядок совпадает с ROUTE_NAMES
+enum class Route {
+    Login,
+    RegisterForm,
+    Register,
+    Logout,
+    Add,
+    Update,
+    Delete,
+    Rate,
+    Main,
+    LoginRequired,
+    Metrics,
+    SlowQueries,
+    ApiIntegrators,
+    ApiIntegrator,
+    ApiRatings,
+    ApiLookup,
+    Other,
+    Count
+};
 
-bool containsCaseInsensitive(const std::string& text, const std::string& pattern) {
-    if (pattern.empty()) return true;
-    std::string lowerText = toLowerStr(text);
-    std::string lowerPattern = toLowerStr(pattern);
-    return lowerText.find(lowerPattern) != std::string::npos;
-}
+const char* const ROUTE_NAMES[] = {
+    "POST /login", "GET /register", "POST /register", "POST /logout", "POST /add", "POST /update",
+    "POST /delete", "POST /rate", "GET /", "GET /login_required", "GET /metrics",
+    "GET /admin/slow-queries", "GET /api/integrators", "GET /api/integrators/{id}",
+    "GET /api/integrators/{id}/ratings", "GET /api/lookups", "other"
+};
 
-std::map<std::string, std::string> parsePostData(const std::string& data) {
-    std::map<std::string, std::string> params;
-    std::istringstream stream(data);
-    std::string pair;
-    
-    while (std::getline(stream, pair, '&')) {
-        size_t pos = pair.find('=');
-        if (pos != std::string::npos) {
-            std::string key = urlDecode(pair.substr(0, pos));
-            std::string value = urlDecode(pair.substr(pos + 1));
-            params[key] = value;
-        }
+Route classifyRoute(std::string_view request) {
+    if (request.find("POST /login") == 0) return Route::Login;
+    if (request.find("GET /register") == 0) return Route::RegisterForm;
+    if (request.find("POST /register") == 0) return Route::Register;
+    if (request.find("POST /logout") == 0) return Route::Logout;
+    if (request.find("POST /add") == 0) return Route::Add;
+    if (request.find("POST /update") == 0) return Route::Update;
+    if (request.find("POST /delete") == 0) return Route::Delete;
+    if (request.find("POST /rate") == 0) return Route::Rate;
+    if (request.find("GET / ") == 0 || request.find("GET /?") == 0) return Route::Main;
+    if (request.find("GET /login_required") == 0) return Route::LoginRequired;
+    if (request.find("GET /metrics") == 0) return Route::Metrics;
+    if (request.find("GET /admin/slow-queries") == 0) return Route::SlowQueries;
+    int apiId;
+    switch (parseApiEndpoint(request, apiId)) {
+        case ApiEndpoint::Integrators: return Route::ApiIntegrators;
+        case ApiEndpoint::Integrator: return Route::ApiIntegrator;
+        case ApiEndpoint::Ratings: return Route::ApiRatings;
+        case ApiEndpoint::Countries:
+        case ApiEndpoint::Products:
+        case ApiEndpoint::Services: return Route::ApiLookup;
+        default: break;
     }
-    return params;
+    return Route::Other;
 }
 
-std::string getCookie(const std::string& headers, const std::string& name) {
-    size_t pos = headers.find("Cookie:");
-    if (pos == std::string::npos) return "";
-    
-    size_t start = headers.find(name + "=", pos);
-    if (start == std::string::npos) return "";
-    
-    start += name.length() + 1;
-    size_t end = headers.find_first_of(";\r\n", start);
-    if (end == std::string::npos) end = headers.length();
-    
-    return headers.substr(start, end - start);
+void recordRequest(Route route, RouteMetrics& stats, size_t bytesIn, size_t bytesOut, std::chrono::steady_clock::time_point start,
+                   uint64_t traceId) {
+    uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    stats.requests.add();
+    stats.bytesIn.add(bytesIn);
+    stats.bytesOut.add(bytesOut);
+    stats.latency.record(micros);
+    LOG_INFO("Запрос обработан")
+        .field("trace_id", formatTraceId(traceId))
+        .field("route", ROUTE_NAMES[static_cast<int>(route)])
+        .field("bytes_in", bytesIn)
+        .field("bytes_out", bytesOut)
+        .field("duration_us", micros);
 }
 
-std::string getQueryParam(const std::string& request, const std::string& paramName) {
-    size_t queryStart = request.find("?");
-    if (queryStart == std::string::npos) return "";
-    
-    size_t queryEnd = request.find(" ", queryStart);
-    if (queryEnd == std::string::npos) queryEnd = request.find("\r\n", queryStart);
-    if (queryEnd == std::string::npos) return "";
-    
-    std::string queryString = request.substr(queryStart + 1, queryEnd - queryStart - 1);
-    
-    size_t paramPos = queryString.find(paramName + "=");
-    if (paramPos == std::string::npos) return "";
-    
-    size_t valueStart = paramPos + paramName.length() + 1;
-    size_t valueEnd = queryString.find("&", valueStart);
-    if (valueEnd == std::string::npos) valueEnd = queryString.length();
-    
-    std::string value = queryString.substr(valueStart, valueEnd - valueStart);
-    return urlDecode(value);
+std::string getEnv(const std::string& key, const std::string& defaultValue) {
+    const char* val = std::getenv(key.c_str());
+    return val ? std::string(val) : defaultValue;
 }
 
-std::string generateLoginPage(const std::string& error = "") {
-    std::ostringstream html;
-    html << "<!DOCTYPE html><html lang='ru'><head>"
-         << "<meta charset='UTF-8'><title>Вход в систему</title><style>"
-         << "body { font-family: Arial, sans-serif; display: flex; justify-content: center; align-items: center; height: 100vh; margin: 0; background: linear-gradient(135deg, #667eea 0%, #764ba2 100%); }"
-         << ".login-box { background: white; padding: 40px; border-radius: 10px; box-shadow: 0 10px 25px rgba(0,0,0,0.2); width: 300px; }"
-         << "h2 { text-align: center; color: #333; margin-bottom: 30px; }"
-         << "input { width: 100%; padding: 12px; margin: 10px 0; border: 1px solid #ddd; border-radius: 5px; box-sizing: border-box; }"
-         << "button { width: 100%; padding: 12px; background: #667eea; color: white; border: none; border-radius: 5px; cursor: pointer; font-size: 16px; margin-top: 10px; }"
-         << "button:hover { background: #5568d3; }"
-         << ".error { color: red; text-align: center; margin-bottom: 10px; font-size: 14px; }"
-         << ".info { color: #666; text-align: center; margin-top: 20px; font-size: 12px; }"
-         << ".register-link { color: #667eea; text-decoration: none; display: block; text-align: center; margin-top: 15px; font-size: 14px; }"
-         << ".register-link:hover { text-decoration: underline; }"
-         << "</style>"
-         << "<script>"
-         << "window.onload = function() {"
-         << "  sessionStorage.removeItem('authenticated');"
-         << "};"
-         << "</script>"
-         << "</head><body><div class='login-box'><h2>🔐 Вход в систему</h2>";
-    
-    if (!error.empty()) {
-        html << "<div class='error'>" << htmlEscape(error) << "</div>";
-    }
-    
-    html << "<form method='POST' action='/login'>"
-         << "<input type='text' name='username' placeholder='Имя пользователя' required>"
-         << "<input type='password' name='password' placeholder='Пароль' required>"
-         << "<button type='submit'>Войти</button></form>"
-         << "<a href='/register' class='register-link'>Нет аккаунта? Зарегистрироваться</a>"
-         << "</div></body></html>";
-    
-    return html.str();
+// Ответ после входа или регистрации: cookie сессии и токен вкладки в sessionStorage
+std::string createLoginResponse(const std::string& sessionId, const std::string& message) {
+    // Генерируем уникальный токен для этой вкладки
+    std::string tabToken = generateSessionId();
+    std::string redirectPage = "<!DOCTYPE html><html><head><meta charset='UTF-8'><script>"
+        "sessionStorage.setItem('authenticated', 'true');"
+        "sessionStorage.setItem('tab_token', '" + tabToken + "');"
+        "window.location.href = '/?tab_token=" + tabToken + "';"
+        "</script></head><body>" + message + "</body></html>";
+    
+    std::ostringstream resp;
+    resp << "HTTP/1.1 200 OK\r\n"
+         << "Content-Type: text/html; charset=utf-8\r\n"
+         << "Set-Cookie: session_id=" << sessionId << "; Path=/; HttpOnly\r\n"
+         << "Set-Cookie: tab_token=" << tabToken << "; Path=/\r\n"
+         << "Content-Length: " << redirectPage.length() << "\r\n"
+         << "Connection: close\r\n\r\n"
+         << redirectPage;
+    return resp.str();
 }
 
-std::string generateRegisterPage(const std::string& error = "", const std::string& username = "", const std::string& password = "") {
-    std::ostringstream html;
-    html << "<!DOCTYPE html><html lang='ru'><head>"
-         << "<meta charset='UTF-8'><title>Регистрация</title><style>"
-         << "body { font-family: Arial, sans-serif; display: flex; justify-content: center; align-items: center; height: 100vh; margin: 0; background: linear-gradient(135deg, #667eea 0%, #764ba2 100%); }"
-         << ".register-box { background: white; padding: 40px; border-radius: 10px; box-shadow: 0 10px 25px rgba(0,0,0,0.2); width: 320px; }"
-         << "h2 { text-align: center; color: #333; margin-bottom: 30px; }"
-         << "input { width: 100%; padding: 12px; margin: 10px 0; border: 1px solid #ddd; border-radius: 5px; box-sizing: border-box; }"
-         << "button { width: 100%; padding: 12px; background: #27ae60; color: white; border: none; border-radius: 5px; cursor: pointer; font-size: 16px; margin-top: 10px; }"
-         << "button:hover { background: #229954; }"
-         << ".error { color: red; text-align: center; margin-bottom: 10px; font-size: 14px; }"
-         << ".info { color: #666; text-align: center; margin-top: 15px; font-size: 12px; }"
-         << ".login-link { color: #667eea; text-decoration: none; display: block; text-align: center; margin-top: 15px; font-size: 14px; }"
-         << ".login-link:hover { text-decoration: underline; }"
-         << ".password-hint { font-size: 11px; color: #999; margin-top: -5px; margin-bottom: 10px; }"
-         << "</style>"
-         << "<script>"
-         << "function validatePassword() {"
-         << "  var pwd = document.getElementById('password').value;"
-         << "  var confirmPwd = document.getElementById('password_confirm').value;"
-         << "  var submitBtn = document.getElementById('submit-btn');"
-         << "  if (pwd.length < 3) {"
-         << "    submitBtn.disabled = true;"
-         << "    return false;"
-         << "  }"
-         << "  if (pwd !== confirmPwd) {"
-         << "    submitBtn.disabled = true;"
-         << "    return false;"
-         << "  }"
-         << "  submitBtn.disabled = false;"
-         << "  return true;"
-         << "}"
-         << "</script>"
-         << "</head><body><div class='register-box'><h2>📝 Регистрация</h2>";
-    
-    if (!error.empty()) {
-        html << "<div class='error'>" << htmlEscape(error) << "</div>";
+// Вход или регистрация, ждущие пула хеширования; сокет клиента открыт до ответа
+struct PendingAuth {
+    int clientSocket;
+    Route route;
+    std::string username;
+    int userId;                  // только для входа
+    bool isAdmin;
+    size_t bytesIn;
+    std::chrono::steady_clock::time_point start;
+    uint64_t traceId;
+};
+
+// Новая сессия: подписанный токен (tokens != nullptr) или строка в sessions; пусто - ошибка
+std::string openSession(Database& db, SessionTokens* tokens, int userId, const std::string& username, bool isAdmin) {
+    if (tokens) {
+        return tokens->issue(userId, username, isAdmin);
     }
-    
-    std::string safeUsername = htmlEscape(username);
-    std::string safePassword = htmlEscape(password);
-    
-    html << "<form method='POST' action='/register'>"
-         << "<input type='text' name='username' id='username' placeholder='Имя пользователя' value='" << safeUsername << "' required minlength='3' maxlength='50'>"
-         << "<input type='password' name='password' id='password' placeholder='Пароль (минимум 3 символа)' value='" << safePassword << "' required minlength='3' oninput='validatePassword()'>"
-         << "<div class='password-hint'>Минимум 3 символа</div>"
-         << "<input type='password' name='password_confirm' id='password_confirm' placeholder='Подтвердите пароль' required oninput='validatePassword()'>"
-         << "<button type='submit' id='submit-btn'>Зарегистрироваться</button></form>"
-         << "<a href='/login' class='login-link'>Уже есть аккаунт? Войти</a>"
-         << "<div class='info'><br>После регистрации вы сможете оценивать интеграторов и оставлять отзывы</div>"
-         << "</div></body></html>";
-    
-    return html.str();
+    std::string sessionId = generateSessionId();
+    return db.createSession(sessionId, userId) ? sessionId : "";
 }
 
-std::string generateMainPage(
-    const std::vector<Integrator>& integrators,
-    bool isAdmin,
-    bool isLoggedIn,
-    const std::string& username,
-    const std::string& tabToken,
-    const std::vector<std::string>& cities,
-    const std::vector<std::pair<int, std::string>>& countries = {},
-    const std::vector<std::pair<int, std::string>>& products = {},
-    const std::vector<std::pair<int, std::string>>& services = {},
-    const std::string& cityQuery = "",
-    const std::string& filterCityParam = "",
-    const std::string& searchName = "",
-    const std::string& sortOption = "name_asc",
-    int page = 1,
-    int totalPages = 1,
-    int totalCount = 0,
-    const std::map<int, RatingStats>& ratingStats = {},
-    const std::map<int, std::vector<Rating>>& integratorRatings = {}
-) {
-    std::ostringstream html;
-    html << "<!DOCTYPE html><html lang='ru'><head>"
-         << "<meta charset='UTF-8'><title>Интеграторы InfoSec</title><style>"
-         << "body { font-family: Arial, sans-serif; max-width: 1200px; margin: 0 auto; padding: 20px; background: #f5f5f5; }"
-         << ".header { display: flex; justify-content: space-between; align-items: center; margin-bottom: 30px; background: white; padding: 20px; border-radius: 8px; box-shadow: 0 2px 4px rgba(0,0,0,0.1); }"
-         << "h1 { color: #2c3e50; margin: 0; }"
-         << ".user-info { text-align: right; }"
-         << ".user-name { color: #3498db; font-weight: bold; }"
-         << ".admin-badge { background: #e74c3c; color: white; padding: 3px 8px; border-radius: 3px; font-size: 12px; margin-left: 10px; }"
-         << ".logout-btn { background: #95a5a6; color: white; border: none; padding: 8px 16px; border-radius: 5px; cursor: pointer; margin-top: 10px; }"
-         << ".integrator { background: white; padding: 20px; margin: 15px 0; border-radius: 8px; box-shadow: 0 2px 4px rgba(0,0,0,0.1); position: relative; }"
-         << ".integrator h2 { color: #3498db; margin: 0 0 10px 0; }"
-         << ".city { color: #7f8c8d; font-size: 14px; margin-bottom: 10px; }"
-         << ".website, .licenses, .certificates, .products, .services { color: #7f8c8d; font-size: 14px; margin-bottom: 12px; }"
-         << ".website a { color: #3498db; text-decoration: none; font-weight: 500; }"
-         << ".website a:hover { text-decoration: underline; color: #2980b9; }"
-         << ".license-list, .certificate-list { margin: 8px 0 0 20px; padding: 0; list-style: none; }"
-         << ".license-list li, .certificate-list li { margin: 6px 0; padding: 8px; background: #f8f9fa; border-left: 3px solid #3498db; border-radius: 3px; }"
-         << ".license-list li strong, .certificate-list li strong { color: #2c3e50; }"
-         << ".license-list li em, .certificate-list li em { color: #7f8c8d; font-style: normal; }"
-         << ".description { color: #34495e; line-height: 1.6; margin-top: 10px; }"
-         << ".badge { display: inline-block; padding: 3px 8px; background: #3498db; color: white; border-radius: 3px; font-size: 12px; margin-right: 10px; }"
-         << ".add-btn { background: #27ae60; color: white; border: none; padding: 12px 24px; border-radius: 5px; cursor: pointer; font-size: 16px; margin-bottom: 20px; }"
-         << ".add-btn:hover { background: #229954; }"
-         << ".action-buttons { position: absolute; top: 20px; right: 20px; }"
-         << ".edit-btn, .delete-btn { padding: 6px 12px; margin-left: 5px; border: none; border-radius: 4px; cursor: pointer; font-size: 14px; }"
-         << ".edit-btn { background: #f39c12; color: white; } .edit-btn:hover { background: #e67e22; }"
-         << ".delete-btn { background: #e74c3c; color: white; } .delete-btn:hover { background: #c0392b; }"
-         << ".modal { display: none; position: fixed; z-index: 1000; left: 0; top: 0; width: 100%; height: 100%; background: rgba(0,0,0,0.5); }"
-         << ".modal-content { background: white; margin: 5% auto; padding: 30px; border-radius: 10px; width: 500px; box-shadow: 0 4px 6px rgba(0,0,0,0.3); }"
-         << ".modal-content h2 { margin-top: 0; color: #2c3e50; }"
-         << ".modal-content input, .modal-content textarea, .modal-content select { width: 100%; padding: 10px; margin: 10px 0; border: 1px solid #ddd; border-radius: 5px; box-sizing: border-box; }"
-         << ".modal-content textarea { height: 100px; resize: vertical; }"
-         << ".modal-content select[multiple] { height: 120px; }"
-         << ".license-item, .certificate-item { display: flex; gap: 10px; margin-bottom: 10px; align-items: center; }"
-         << ".license-item input, .certificate-item input { flex: 1; }"
-         << ".add-item-btn { background: #3498db; color: white; border: none; padding: 8px 15px; border-radius: 5px; cursor: pointer; font-size: 14px; }"
-         << ".add-item-btn:hover { background: #2980b9; }"
-         << ".remove-item-btn { background: #e74c3c; color: white; border: none; padding: 8px 15px; border-radius: 5px; cursor: pointer; font-size: 14px; }"
-         << ".remove-item-btn:hover { background: #c0392b; }"
-         << ".items-container { margin: 10px 0; }"
-         << ".modal-buttons { display: flex; justify-content: flex-end; gap: 10px; margin-top: 20px; }"
-         << ".modal-buttons button { padding: 10px 20px; border: none; border-radius: 5px; cursor: pointer; font-size: 14px; }"
-         << ".save-btn { background: #27ae60; color: white; } .save-btn:hover { background: #229954; }"
-         << ".cancel-btn { background: #95a5a6; color: white; } .cancel-btn:hover { background: #7f8c8d; }"
-         << ".search-box { background: white; padding: 20px; margin-bottom: 20px; border-radius: 8px; box-shadow: 0 2px 4px rgba(0,0,0,0.1); }"
-         << ".search-form { display: flex; gap: 10px; align-items: center; flex-wrap: wrap; }"
-         << ".search-form input, .search-form select { padding: 10px; border: 1px solid #ddd; border-radius: 5px; font-size: 14px; }"
-         << ".search-form input[type='text'] { flex: 1; min-width: 160px; }"
-         << ".search-form select { min-width: 150px; }"
-         << ".search-btn { background: #3498db; color: white; border: none; padding: 10px 20px; border-radius: 5px; cursor: pointer; font-size: 14px; }"
-         << ".search-btn:hover { background: #2980b9; }"
-         << ".clear-btn { background: #95a5a6; color: white; border: none; padding: 10px 20px; border-radius: 5px; cursor: pointer; font-size: 14px; }"
-         << ".clear-btn:hover { background: #7f8c8d; }"
-         << ".results-info { color: #7f8c8d; font-size: 14px; margin-bottom: 15px; }"
-         << ".rating { margin-top: 8px; font-size: 14px; color: #555; }"
-         << ".rating strong { color: #e67e22; }"
-         << ".reviews { margin-top: 10px; background: #fafafa; padding: 10px; border: 1px solid #eee; border-radius: 6px; }"
-         << ".review { margin-bottom: 8px; font-size: 13px; }"
-         << ".pagination { margin-top: 15px; display: flex; gap: 8px; align-items: center; }"
-         << ".pagination a, .pagination span { padding: 8px 12px; border-radius: 5px; border: 1px solid #ddd; text-decoration: none; color: #333; }"
-         << ".pagination a:hover { background: #f0f0f0; }"
-         << ".pagination .active { background: #3498db; color: white; border-color: #3498db; }"
-         << ".rate-form { margin-top: 10px; display: flex; flex-direction: column; gap: 8px; }"
-         << ".rate-form select, .rate-form textarea { width: 100%; padding: 8px; border: 1px solid #ddd; border-radius: 5px; box-sizing: border-box; }"
-         << ".rate-form button { align-self: flex-start; background: #3498db; color: white; border: none; padding: 8px 14px; border-radius: 5px; cursor: pointer; font-size: 14px; }"
-         << ".rate-form button:hover { background: #2980b9; }"
-         << "</style>"
-         << "<script>"
-         << "window.onload = function() {"
-         << "  var storedToken = sessionStorage.getItem('tab_token');"
-         << "  var serverToken = '" << tabToken << "';"
-         << "  if (!storedToken) {"
-         << "    sessionStorage.setItem('tab_token', serverToken);"
-         << "  } else if (storedToken !== serverToken) {"
-         << "    window.location.href = '/login_required';"
-         << "    return;"
-         << "  }"
-         << "};"
-         << "</script>"
-         << "</head><body>"
-         << "<div class='header'><h1>🛡️ Интеграторы InfoSec</h1>"
-         << "<div class='user-info'><div class='user-name'>" << username;
-    
-    if (isAdmin) {
-        html << "<span class='admin-badge'>ADMIN</span>";
-    }
-    
-    html << "</div><form method='POST' action='/logout' style='display:inline;'>"
-         << "<button type='submit' class='logout-btn'>Выйти</button></form></div></div>";
-    
-    // Форма поиска и фильтрации
-    std::string escapedCity = htmlEscape(cityQuery);
-    std::string escapedFilterCity = htmlEscape(filterCityParam);
-    std::string escapedSearch = htmlEscape(searchName);
-    html << "<div class='search-box'>"
-         << "<form method='GET' action='/' class='search-form'>"
-         << "<input type='text' name='name' placeholder='Поиск по названию...' value='" << escapedSearch << "'>"
-         << "<input type='text' name='city' placeholder='Поиск по городу...' value='" << escapedCity << "'>"
-         << "<select name='filter_city'>"
-         << "<option value=''>Все города</option>";
-    
-    for (const auto& city : cities) {
-        std::string escapedCityName = htmlEscape(city);
-        html << "<option value='" << escapedCityName << "'";
-        if (city == filterCityParam) {
-            html << " selected";
+// Завершение входа/регистрации по результату хеширования
+std::string finishAuth(Database& db, SessionTokens* tokens, const PendingAuth& pending, const PasswordHasher::Job& job) {
+    if (pending.route == Route::Login) {
+        if (!job.verified) {
+            LOG_INFO("Вход отклонён").field("user", pending.username).field("reason", "bad_password");
+            return createHTTPResponse(generateLoginPage("Неверный пароль"));
         }
-        html << ">" << escapedCityName << "</option>";
-    }
-    
-    html << "</select>"
-         << "<select name='sort'>"
-         << "<option value='name_asc'" << (sortOption == "name_asc" ? " selected" : "") << ">Название ↑</option>"
-         << "<option value='name_desc'" << (sortOption == "name_desc" ? " selected" : "") << ">Название ↓</option>"
-         << "<option value='city_asc'" << (sortOption == "city_asc" ? " selected" : "") << ">Город ↑</option>"
-         << "<option value='city_desc'" << (sortOption == "city_desc" ? " selected" : "") << ">Город ↓</option>"
-         << "<option value='rating_desc'" << (sortOption == "rating_desc" ? " selected" : "") << ">Рейтинг ↓</option>"
-         << "<option value='rating_asc'" << (sortOption == "rating_asc" ? " selected" : "") << ">Рейтинг ↑</option>"
-         << "</select>"
-         << "<button type='submit' class='search-btn'>🔍 Поиск</button>"
-         << "<a href='/' style='text-decoration: none;'><button type='button' class='clear-btn'>Очистить</button></a>"
-         << "</form>";
-    
-    int shownCount = static_cast<int>(integrators.size());
-    int totalShown = totalCount > 0 ? totalCount : shownCount;
-    html << "<div class='results-info'>Найдено интеграторов: " << totalShown << "</div>";
-    
-    html << "</div>";
-    
-    if (isAdmin) {
-        html << "<button class='add-btn' onclick='openAddModal()'>➕ Добавить интегратора</button>";
-    }
-    
-    for (const auto& integrator : integrators) {
-        html << "<div class='integrator'>";
-        
-        if (isAdmin) {
-            // Подготовка данных для модального окна
-            std::string escapedName = integrator.name;
-            std::string escapedCity = integrator.city;
-            std::string escapedDesc = integrator.description;
-            std::string escapedWebsite = integrator.website;
-            
-            // Экранирование кавычек и переносов строк
-            auto escapeForJS = [](std::string& str) {
-                size_t pos = 0;
-                while ((pos = str.find("\\", pos)) != std::string::npos) {
-                    str.replace(pos, 1, "\\\\");
-                    pos += 2;
-                }
-                pos = 0;
-                while ((pos = str.find("\"", pos)) != std::string::npos) {
-                    str.replace(pos, 1, "\\\"");
-                    pos += 2;
-                }
-                pos = 0;
-                while ((pos = str.find("\n", pos)) != std::string::npos) {
-                    str.replace(pos, 1, "\\n");
-                    pos += 2;
-                }
-                pos = 0;
-                while ((pos = str.find("\r", pos)) != std::string::npos) {
-                    str.replace(pos, 1, "");
-                }
-            };
-            
-            escapeForJS(escapedName);
-            escapeForJS(escapedCity);
-            escapeForJS(escapedDesc);
-            escapeForJS(escapedWebsite);
-            
-            // Получаем ID страны
-            int countryId = 0;
-            for (const auto& country : countries) {
-                if (country.second == integrator.country) {
-                    countryId = country.first;
-                    break;
-                }
-            }
-            
-            // Получаем ID продуктов и услуг
-            std::vector<int> productIds;
-            std::vector<int> serviceIds;
-            if (!integrator.products.empty()) {
-                for (const auto& product : products) {
-                    if (integrator.products.find(product.second) != std::string::npos) {
-                        productIds.push_back(product.first);
-                    }
-                }
-            }
-            if (!integrator.services.empty()) {
-                for (const auto& service : services) {
-                    if (integrator.services.find(service.second) != std::string::npos) {
-                        serviceIds.push_back(service.first);
-                    }
-                }
-            }
-            
-            std::string productIdsStr;
-            for (size_t i = 0; i < productIds.size(); i++) {
-                if (i > 0) productIdsStr += ",";
-                productIdsStr += std::to_string(productIds[i]);
-            }
-            
-            std::string serviceIdsStr;
-            for (size_t i = 0; i < serviceIds.size(); i++) {
-                if (i > 0) serviceIdsStr += ",";
-                serviceIdsStr += std::to_string(serviceIds[i]);
-            }
-            
-            // Подготовка JSON для лицензий и сертификатов
-            std::ostringstream licensesJson;
-            licensesJson << "[";
-            for (size_t i = 0; i < integrator.licenses.size(); i++) {
-                if (i > 0) licensesJson << ",";
-                std::string num = integrator.licenses[i].number;
-                std::string issued = integrator.licenses[i].issuedBy;
-                escapeForJS(num);
-                escapeForJS(issued);
-                licensesJson << "{\"number\":\"" << num << "\",\"issuedBy\":\"" << issued << "\"}";
-            }
-            licensesJson << "]";
-            
-            std::ostringstream certificatesJson;
-            certificatesJson << "[";
-            for (size_t i = 0; i < integrator.certificates.size(); i++) {
-                if (i > 0) certificatesJson << ",";
-                std::string name = integrator.certificates[i].name;
-                std::string number = integrator.certificates[i].number;
-                std::string issued = integrator.certificates[i].issuedBy;
-                escapeForJS(name);
-                escapeForJS(number);
-                escapeForJS(issued);
-                certificatesJson << "{\"name\":\"" << name << "\",\"number\":\"" << number << "\",\"issuedBy\":\"" << issued << "\"}";
-            }
-            certificatesJson << "]";
-            
-            html << "<div class='action-buttons'>"
-                 << "<button class='edit-btn' onclick=\"openEditModal(" << integrator.id << ", '"
-                 << escapedName << "', '" << escapedCity << "', '" << escapedDesc << "', '"
-                 << escapedWebsite << "', " << countryId << ", '" << productIdsStr << "', '"
-                 << serviceIdsStr << "', '" << licensesJson.str() << "', '" << certificatesJson.str() << "')\">✏️ Изменить</button>"
-                 << "<form method='POST' action='/delete' style='display:inline;'>"
-                 << "<input type='hidden' name='id' value='" << integrator.id << "'>"
-                 << "<button type='submit' class='delete-btn' onclick='return confirm(\"Удалить этого интегратора?\")'>🗑️ Удалить</button>"
-                 << "</form></div>";
-        }
-        
-        html << "<h2>" << integrator.name << "</h2>"
-             << "<div class='city'><span class='badge'>Город</span>" << integrator.city;
-        if (!integrator.country.empty()) {
-            html << " <span class='badge'>Страна</span>" << integrator.country;
+        // Открытый текст или устаревшие параметры scrypt заменяются при входе
+        if (!job.newHash.empty() && db.updatePasswordHash(pending.userId, job.newHash)) {
+            LOG_INFO("Пароль перехеширован").field("user", pending.username);
         }
-        html << "</div>";
-        if (!integrator.website.empty()) {
-            std::string websiteUrl = integrator.website;
-            if (websiteUrl.find("http://") != 0 && websiteUrl.find("https://") != 0) {
-                websiteUrl = "https://" + websiteUrl;
-            }
-            html << "<div class='website'><span class='badge'>🌐 Сайт</span><a href='" << htmlEscape(websiteUrl) << "' target='_blank' rel='noopener noreferrer'>" << htmlEscape(integrator.website) << " ↗</a></div>";
-        }
-        if (!integrator.licenses.empty()) {
-            html << "<div class='licenses'><span class='badge'>📜 Лицензии</span><ul class='license-list'>";
-            for (const auto& license : integrator.licenses) {
-                html << "<li><strong>" << htmlEscape(license.number) << "</strong> — выдана: <em>" << htmlEscape(license.issuedBy) << "</em></li>";
-            }
-            html << "</ul></div>";
-        }
-        if (!integrator.certificates.empty()) {
-            html << "<div class='certificates'><span class='badge'>🏆 Сертификаты</span><ul class='certificate-list'>";
-            for (const auto& cert : integrator.certificates) {
-                html << "<li><strong>" << htmlEscape(cert.name) << "</strong>";
-                if (!cert.number.empty()) {
-                    html << " (№ " << htmlEscape(cert.number) << ")";
-                }
-                html << " — выдано: <em>" << htmlEscape(cert.issuedBy) << "</em></li>";
-            }
-            html << "</ul></div>";
-        }
-        if (!integrator.products.empty()) {
-            html << "<div class='products'><span class='badge'>Продукты</span>" << htmlEscape(integrator.products) << "</div>";
-        }
-        if (!integrator.services.empty()) {
-            html << "<div class='services'><span class='badge'>Услуги</span>" << htmlEscape(integrator.services) << "</div>";
-        }
-        html << "<div class='description'>" << integrator.description << "</div>"
-             << "<div class='rating'>";
-
-        auto statIt = ratingStats.find(integrator.id);
-        if (statIt != ratingStats.end() && statIt->second.count > 0) {
-            html << "Рейтинг: <strong>" << std::fixed << std::setprecision(1) << statIt->second.average << "</strong> / 5"
-                 << " (" << statIt->second.count << ")";
-            html << std::defaultfloat;
+        std::string newSessionId = openSession(db, tokens, pending.userId, pending.username, pending.isAdmin);
+        if (!newSessionId.empty()) {
+            LOG_INFO("Вход выполнен").field("user", pending.username).field("admin", pending.isAdmin);
         } else {
-            html << "Рейтинг: нет оценок";
+            LOG_ERROR("Сессия не создана").field("user", pending.username);
         }
-        html << "</div>";
-
-        auto ratingsIt = integratorRatings.find(integrator.id);
-        if (ratingsIt != integratorRatings.end() && !ratingsIt->second.empty()) {
-            html << "<div class='reviews'>";
-            int shown = 0;
-            for (const auto& r : ratingsIt->second) {
-                if (shown >= 3) break;
-                html << "<div class='review'>"
-                     << "<strong>" << htmlEscape(r.username) << "</strong> — " << r.value << "/5"
-                     << " <span style='color:#999;font-size:12px;'>" << r.createdAt << "</span><br>"
-                     << htmlEscape(r.comment)
-                     << "</div>";
-                shown++;
-            }
-            html << "</div>";
-        }
-
-        if (isLoggedIn) {
-            html << "<div class='rate-form'>"
-                 << "<form method='POST' action='/rate'>"
-                 << "<input type='hidden' name='id' value='" << integrator.id << "'>"
-                 << "<label>Оцените интегратора:</label>"
-                 << "<select name='rating'>"
-                 << "<option value='5'>5</option>"
-                 << "<option value='4'>4</option>"
-                 << "<option value='3'>3</option>"
-                 << "<option value='2'>2</option>"
-                 << "<option value='1'>1</option>"
-                 << "</select>"
-                 << "<textarea name='comment' placeholder='Комментарий (необязательно)'></textarea>"
-                 << "<button type='submit'>Сохранить оценку</button>"
-                 << "</form>"
-                 << "</div>";
-        }
-
-        html << "</div>";
-    }
-
-    // Пагинация
-    if (totalPages > 1) {
-        html << "<div class='pagination'>";
-        auto makeLink = [&](int targetPage, const std::string& text, bool active) {
-            std::ostringstream link;
-            link << "/?page=" << targetPage
-                 << "&name=" << urlEncode(searchName)
-                 << "&city=" << urlEncode(cityQuery)
-                 << "&filter_city=" << urlEncode(filterCityParam)
-                 << "&sort=" << urlEncode(sortOption);
-            if (active) {
-                html << "<span class='active'>" << text << "</span>";
-            } else {
-                html << "<a href='" << link.str() << "'>" << text << "</a>";
-            }
-        };
-        if (page > 1) {
-            makeLink(page - 1, "« Назад", false);
-        }
-        makeLink(page, "Страница " + std::to_string(page) + " / " + std::to_string(totalPages), true);
-        if (page < totalPages) {
-            makeLink(page + 1, "Вперёд »", false);
-        }
-        html << "</div>";
+        return createLoginResponse(newSessionId, "Перенаправление...");
     }
     
-    if (isAdmin) {
-        html << "<div id='modal' class='modal'><div class='modal-content' style='max-width: 700px; max-height: 90vh; overflow-y: auto;'>"
-             << "<h2 id='modal-title'>Добавить интегратора</h2>"
-             << "<form id='modal-form' method='POST' action='/add'>"
-             << "<input type='hidden' name='id' id='edit-id'>"
-             << "<input type='text' name='name' id='name' placeholder='Название' required>"
-             << "<input type='text' name='city' id='city' placeholder='Город' required>"
-             << "<textarea name='description' id='description' placeholder='Описание' required></textarea>"
-             << "<input type='text' name='website' id='website' placeholder='Сайт (например: https://example.com)'>"
-             << "<select name='country_id' id='country_id'>"
-             << "<option value=''>Выберите страну</option>";
-        
-        for (const auto& country : countries) {
-            html << "<option value='" << country.first << "'>" << htmlEscape(country.second) << "</option>";
-        }
-        
-        html << "</select>"
-             << "<label>Продукты (удерживайте Ctrl/Cmd для множественного выбора):</label>"
-             << "<select name='products[]' id='products' multiple>";
-        
-        for (const auto& product : products) {
-            html << "<option value='" << product.first << "'>" << htmlEscape(product.second) << "</option>";
-        }
-        
-        html << "</select>"
-             << "<label>Услуги (удерживайте Ctrl/Cmd для множественного выбора):</label>"
-             << "<select name='services[]' id='services' multiple>";
-        
-        for (const auto& service : services) {
-            html << "<option value='" << service.first << "'>" << htmlEscape(service.second) << "</option>";
-        }
-        
-        html << "</select>"
-             << "<label>Лицензии:</label>"
-             << "<div id='licenses-container' class='items-container'></div>"
-             << "<button type='button' class='add-item-btn' onclick='addLicenseField()'>+ Добавить лицензию</button>"
-             << "<label>Сертификаты:</label>"
-             << "<div id='certificates-container' class='items-container'></div>"
-             << "<button type='button' class='add-item-btn' onclick='addCertificateField()'>+ Добавить сертификат</button>"
-             << "<div class='modal-buttons'>"
-             << "<button type='button' class='cancel-btn' onclick='closeModal()'>Отмена</button>"
-             << "<button type='submit' class='save-btn'>Сохранить</button>"
-             << "</div></form></div></div>"
-             << "<script>"
-             << "let licenseCount = 0;"
-             << "let certificateCount = 0;"
-             << "function addLicenseField() {"
-             << "  const container = document.getElementById('licenses-container');"
-             << "  const div = document.createElement('div');"
-             << "  div.className = 'license-item';"
-             << "  div.innerHTML = '<input type=\"text\" name=\"license_number[]\" placeholder=\"Номер лицензии\" required>"
-             << "    <input type=\"text\" name=\"license_issued_by[]\" placeholder=\"Кем выдана\" required>"
-             << "    <button type=\"button\" class=\"remove-item-btn\" onclick=\"this.parentElement.remove()\">Удалить</button>';"
-             << "  container.appendChild(div);"
-             << "  licenseCount++;"
-             << "}"
-             << "function addCertificateField() {"
-             << "  const container = document.getElementById('certificates-container');"
-             << "  const div = document.createElement('div');"
-             << "  div.className = 'certificate-item';"
-             << "  div.innerHTML = '<input type=\"text\" name=\"certificate_name[]\" placeholder=\"Название сертификата\" required>"
-             << "    <input type=\"text\" name=\"certificate_number[]\" placeholder=\"Номер (необязательно)\">"
-             << "    <input type=\"text\" name=\"certificate_issued_by[]\" placeholder=\"Кем выдан\" required>"
-             << "    <button type=\"button\" class=\"remove-item-btn\" onclick=\"this.parentElement.remove()\">Удалить</button>';"
-             << "  container.appendChild(div);"
-             << "  certificateCount++;"
-             << "}"
-             << "function openAddModal() {"
-             << "  document.getElementById('modal-title').innerText = 'Добавить интегратора';"
-             << "  document.getElementById('modal-form').action = '/add';"
-             << "  document.getElementById('edit-id').value = '';"
-             << "  document.getElementById('name').value = '';"
-             << "  document.getElementById('city').value = '';"
-             << "  document.getElementById('description').value = '';"
-             << "  document.getElementById('website').value = '';"
-             << "  document.getElementById('country_id').value = '';"
-             << "  Array.from(document.getElementById('products').options).forEach(opt => opt.selected = false);"
-             << "  Array.from(document.getElementById('services').options).forEach(opt => opt.selected = false);"
-             << "  document.getElementById('licenses-container').innerHTML = '';"
-             << "  document.getElementById('certificates-container').innerHTML = '';"
-             << "  licenseCount = 0;"
-             << "  certificateCount = 0;"
-             << "  document.getElementById('modal').style.display = 'block';"
-             << "}"
-             << "function openEditModal(id, name, city, desc, website, countryId, productIds, serviceIds, licenses, certificates) {"
-             << "  document.getElementById('modal-title').innerText = 'Изменить интегратора';"
-             << "  document.getElementById('modal-form').action = '/update';"
-             << "  document.getElementById('edit-id').value = id;"
-             << "  document.getElementById('name').value = name || '';"
-             << "  document.getElementById('city').value = city || '';"
-             << "  document.getElementById('description').value = desc || '';"
-             << "  document.getElementById('website').value = website || '';"
-             << "  document.getElementById('country_id').value = countryId || '';"
-             << "  if (productIds) {"
-             << "    const ids = productIds.split(',');"
-             << "    Array.from(document.getElementById('products').options).forEach(opt => {"
-             << "      opt.selected = ids.includes(opt.value);"
-             << "    });"
-             << "  }"
-             << "  if (serviceIds) {"
-             << "    const ids = serviceIds.split(',');"
-             << "    Array.from(document.getElementById('services').options).forEach(opt => {"
-             << "      opt.selected = ids.includes(opt.value);"
-             << "    });"
-             << "  }"
-             << "  const licensesContainer = document.getElementById('licenses-container');"
-             << "  licensesContainer.innerHTML = '';"
-             << "  if (licenses) {"
-             << "    const licenseList = JSON.parse(licenses);"
-             << "    licenseList.forEach(function(lic) {"
-             << "      const div = document.createElement('div');"
-             << "      div.className = 'license-item';"
-             << "      div.innerHTML = '<input type=\"text\" name=\"license_number[]\" value=\"' + (lic.number || '') + '\" placeholder=\"Номер лицензии\" required>"
-             << "        <input type=\"text\" name=\"license_issued_by[]\" value=\"' + (lic.issuedBy || '') + '\" placeholder=\"Кем выдана\" required>"
-             << "        <button type=\"button\" class=\"remove-item-btn\" onclick=\"this.parentElement.remove()\">Удалить</button>';"
-             << "      licensesContainer.appendChild(div);"
-             << "    });"
-             << "  }"
-             << "  const certificatesContainer = document.getElementById('certificates-container');"
-             << "  certificatesContainer.innerHTML = '';"
-             << "  if (certificates) {"
-             << "    const certList = JSON.parse(certificates);"
-             << "    certList.forEach(function(cert) {"
-             << "      const div = document.createElement('div');"
-             << "      div.className = 'certificate-item';"
-             << "      div.innerHTML = '<input type=\"text\" name=\"certificate_name[]\" value=\"' + (cert.name || '') + '\" placeholder=\"Название сертификата\" required>"
-             << "        <input type=\"text\" name=\"certificate_number[]\" value=\"' + (cert.number || '') + '\" placeholder=\"Номер (необязательно)\">"
-             << "        <input type=\"text\" name=\"certificate_issued_by[]\" value=\"' + (cert.issuedBy || '') + '\" placeholder=\"Кем выдан\" required>"
-             << "        <button type=\"button\" class=\"remove-item-btn\" onclick=\"this.parentElement.remove()\">Удалить</button>';"
-             << "      certificatesContainer.appendChild(div);"
-             << "    });"
-             << "  }"
-             << "  document.getElementById('modal').style.display = 'block';"
-             << "}"
-             << "function closeModal() { document.getElementById('modal').style.display = 'none'; }"
-             << "window.onclick = function(event) { if (event.target == document.getElementById('modal')) { closeModal(); } }"
-             << "</script>";
+    if (job.newHash.empty()) {
+        LOG_ERROR("Ошибка хеширования пароля").field("user", pending.username);
+        return createHTTPResponse(generateRegisterPage("Ошибка при создании пользователя", pending.username, ""));
     }
-    
-    html << "</body></html>";
-    return html.str();
-}
-
-std::string createHTTPResponse(const std::string& body, const std::string& setCookie = "") {
-    std::ostringstream response;
-    response << "HTTP/1.1 200 OK\r\n"
-             << "Content-Type: text/html; charset=utf-8\r\n"
-             << "Content-Length: " << body.length() << "\r\n";
-    
-    if (!setCookie.empty()) {
-        response << "Set-Cookie: session_id=" << setCookie << "; Path=/; HttpOnly\r\n";
+    if (!db.createUser(pending.username, job.newHash, pending.isAdmin)) {
+        return createHTTPResponse(generateRegisterPage("Ошибка при создании пользователя", pending.username, ""));
     }
-    
-    response << "Connection: close\r\n\r\n" << body;
-    return response.str();
+    // Автоматический вход после регистрации
+    std::optional<User> newUser = db.getUserByUsername(pending.username);
+    if (!newUser) {
+        return createHTTPResponse(generateRegisterPage("Ошибка при создании пользователя", pending.username, ""));
+    }
+    std::string newSessionId = openSession(db, tokens, newUser->id, newUser->username, newUser->isAdmin);
+    return createLoginResponse(newSessionId, "Регистрация успешна! Перенаправление...");
 }
 
-std::string createRedirectResponse(const std::string& location) {
-    std::ostringstream response;
-    response << "HTTP/1.1 302 Found\r\n"
-             << "Location: " << location << "\r\n"
-             << "Connection: close\r\n\r\n";
-    return response.str();
+// Ответы, которые зависят только от версий данных и запроса: для них ETag и 304
+bool isVersionedRoute(Route route) {
+    return route == Route::Main || route == Route::ApiIntegrators || route == Route::ApiIntegrator ||
+           route == Route::ApiRatings || route == Route::ApiLookup;
 }
 
-std::string getEnv(const std::string& key, const std::string& defaultValue) {
-    const char* val = std::getenv(key.c_str());
-    return val ? std::string(val) : defaultValue;
+RateClass rateClassOf(Route route) {
+    switch (route) {
+        case Route::Login:
+        case Route::Register:
+            return RateClass::Auth;
+        case Route::Logout:
+        case Route::Add:
+        case Route::Update:
+        case Route::Delete:
+        case Route::Rate:
+            return RateClass::Write;
+        default:
+            return RateClass::Read;
+    }
 }
 
-int main() {
-    // Получение параметров подключения из переменных окружения или использование значений по умолчанию
-    std::string dbHost = getEnv("DB_HOST", "localhost");
-    std::string dbPort = getEnv("DB_PORT", "5432");
-    std::string dbName = getEnv("DB_NAME", "infosec_db");
-    std::string dbUser = getEnv("DB_USER", "postgres");
-    std::string dbPassword = getEnv("DB_PASSWORD", "password");
-    
-    Database db(dbHost, dbPort, dbName, dbUser, dbPassword);
-    
-    if (!db.connect()) {
-        return 1;
-    }
-    
-    int serverSocket = socket(AF_INET, SOCK_STREAM, 0);
-    if (serverSocket < 0) {
-        std::cerr << "Ошибка создания сокета" << std::endl;
-        return 1;
-    }
-    
-    int opt = 1;
-    setsockopt(serverSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-    
-    sockaddr_in serverAddr;
-    serverAddr.sin_family = AF_INET;
-    serverAddr.sin_addr.s_addr = INADDR_ANY;
-    serverAddr.sin_port = htons(8080);
-    
-    if (bind(serverSocket, (sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
-        std::cerr << "Ошибка привязки сокета" << std::endl;
-        close(serverSocket);
-        return 1;
+// Бюджет класса из строки "запросов_в_секунду:запас", например "1:5"
+RateLimiter::Budget parseBudget(const std::string& value) {
+    RateLimiter::Budget budget{1.0, 1.0};
+    if (sscanf(value.c_str(), "%lf:%lf", &budget.ratePerSecond, &budget.burst) != 2 || budget.burst < 1.0) {
+        LOG_WARN("Некорректный бюджет запросов").field("value", value);
+        budget.burst = std::max(budget.burst, 1.0);
     }
-    
-    if (listen(serverSocket, 10) < 0) {
-        std::cerr << "Ошибка прослушивания" << std::endl;
-        close(serverSocket);
-        return 1;
+    return budget;
+}
+
+const char* const TOO_MANY_REQUESTS_PAGE =
+    "<!DOCTYPE html><html><head><meta charset='UTF-8'><title>Слишком много запросов</title></head>"
+    "<body><h1>Слишком много запросов</h1><p>Повторите попытку немного позже.</p></body></html>";
+const char* const OVERLOADED_PAGE =
+    "<!DOCTYPE html><html><head><meta charset='UTF-8'><title>Сервер перегружен</title></head>"
+    "<body><h1>Сервер перегружен</h1><p>Повторите попытку через несколько секунд.</p></body></html>";
+
+// Общее для всех циклов обработки: настройки, кэш каталога, токены сессий,
+// пул хеширования паролей, допуск запросов и метрики. Соединение с БД у цикла своё.
+struct ServerShared {
+    size_t slowQueryTop = 20;
+    bool tokenSessions = false;
+    // Полнотекстовый индекс проверяется один раз, при подготовке схемы: у всех
+    // циклов одинаковый выбор между поиском по индексу и по подстроке
+    bool searchIndexAvailable = false;
+    std::chrono::seconds revocationRefresh{5};
+    std::chrono::seconds drainTimeout{8};
+    bool pinLoops = false;
+    
+    Catalog catalog;
+    SessionTokens sessionTokens{24 * 3600};   // как INTERVAL '24 hours' в CREATE_SESSION
+    std::unique_ptr<PasswordHasher> passwordHasher;
+    std::unique_ptr<RateLimiter> rateLimiter;
+    std::unique_ptr<ConcurrencyLimiter> inFlight;
+    RouteMetrics* routeMetrics[static_cast<int>(Route::Count)];
+    AdmissionMetrics* admissionMetrics[static_cast<int>(RateClass::Count)];
+    Gauge* activeConnections = nullptr;
+    
+    // Читаемый конец pipe остановки: главный поток закрывает записывающий, poll() циклов просыпается
+    int stopFd = -1;
+    // Слушающие сокеты переданы новому процессу - очереди соединений не разбираются
+    std::atomic<bool> handoff{false};
+};
+
+// Цикл обработки на своём слушающем сокете (SO_REUSEPORT: ядро распределяет
+// соединения между сокетами порта) и своём соединении с БД
+void runEventLoop(size_t loopIndex, int serverSocket, Database& db, ServerShared& shared) {
+    if (shared.pinLoops) {
+        size_t cpu = loopIndex % cpuCount();
+        if (!pinCurrentThread(cpu)) {
+            LOG_WARN("Цикл обработки не закреплён за процессором").field("loop", loopIndex).field("cpu", cpu);
+        }
     }
     
-    std::cout << "Сервер запущен на http://localhost:8080" << std::endl;
+    Catalog& catalog = shared.catalog;
+    SessionTokens& sessionTokens = shared.sessionTokens;
+    RateLimiter* rateLimiter = shared.rateLimiter.get();
+    ConcurrencyLimiter& inFlight = *shared.inFlight;
+    RouteMetrics* const* routeMetrics = shared.routeMetrics;
+    AdmissionMetrics* const* admissionMetrics = shared.admissionMetrics;
+    Gauge& activeConnections = *shared.activeConnections;
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    bool tokenSessions = shared.tokenSessions;
+    size_t slowQueryTop = shared.slowQueryTop;
+    
+    // Пул хеширования общий; готовый результат будит poll() того цикла
+    // (владелец loopIndex), который держит сокет клиента
+    PasswordHasher& passwordHasher = *shared.passwordHasher;
+    std::map<uint64_t, PendingAuth> pendingAuth;
+    uint64_t nextTicket = 0;
+    // Массивы и буфер декодирования FormData; остальное из кучи
+    RequestArena arena;
+    
+    // Остановка: приём прекращается после разбора очереди соединений ядра,
+    // ожидающие хеширования дообслуживаются до истечения SHUTDOWN_DRAIN_SECONDS
+    bool shuttingDown = false;
+    std::chrono::steady_clock::time_point drainDeadline;
     
     while (true) {
+        if (shuttingDown && ((serverSocket < 0 && pendingAuth.empty()) ||
+                             std::chrono::steady_clock::now() >= drainDeadline)) {
+            break;
+        }
+        // poll пропускает отрицательные дескрипторы - закрытый слушающий сокет не мешает
+        pollfd fds[3] = {{serverSocket, POLLIN, 0}, {passwordHasher.completionFd(loopIndex), POLLIN, 0},
+                         {shuttingDown ? -1 : shared.stopFd, POLLIN, 0}};
+        int timeout = !shuttingDown ? -1 : (serverSocket >= 0 ? 0 : 100);
+        if (poll(fds, 3, timeout) < 0) continue;
+        
+        // Главный поток закрыл pipe остановки
+        if (fds[2].revents & (POLLIN | POLLHUP)) {
+            shuttingDown = true;
+            drainDeadline = std::chrono::steady_clock::now() + shared.drainTimeout;
+            if (shared.handoff) {
+                // Очередь соединений общая с новым процессом - он её и разберёт
+                close(serverSocket);
+                serverSocket = -1;
+            } else {
+                // Соединения, уже принятые ядром, разбираются без ожидания, затем сокет закрывается
+                fcntl(serverSocket, F_SETFL, fcntl(serverSocket, F_GETFL) | O_NONBLOCK);
+            }
+            LOG_DEBUG("Остановка цикла обработки").field("loop", loopIndex).field("pending_auth", pendingAuth.size());
+        }
+        
+        // Готовые результаты хеширования: отвечаем ожидающим клиентам
+        if (fds[1].revents & POLLIN) {
+            for (const auto& job : passwordHasher.takeCompleted(loopIndex)) {
+                auto it = pendingAuth.find(job.ticket);
+                if (it == pendingAuth.end()) continue;
+                PendingAuth pending = std::move(it->second);
+                pendingAuth.erase(it);
+                
+                std::string response = finishAuth(db, tokenSessions ? &sessionTokens : nullptr, pending, job);
+                send(pending.clientSocket, response.c_str(), response.length(), 0);
+                close(pending.clientSocket);
+                activeConnections.add(-1);
+                inFlight.release();
+                recordRequest(pending.route, *routeMetrics[static_cast<int>(pending.route)], pending.bytesIn,
+                              response.length(), pending.start, pending.traceId);
+            }
+        }
+        if (serverSocket < 0 || !((fds[0].revents & POLLIN) || shuttingDown)) continue;
+        
         sockaddr_in clientAddr;
         socklen_t clientLen = sizeof(clientAddr);
         int clientSocket = accept(serverSocket, (sockaddr*)&clientAddr, &clientLen);
         
-        if (clientSocket < 0) continue;
+        if (clientSocket < 0) {
+            if (shuttingDown && errno != EINTR) {
+                close(serverSocket);
+                serverSocket = -1;
+                LOG_INFO("Приём соединений остановлен").field("loop", loopIndex).field("pending_auth", pendingAuth.size());
+            }
+            continue;
+        }
+        // Не наследуется новым процессом при перезапуске
+        fcntl(clientSocket, F_SETFD, FD_CLOEXEC);
+        if (shuttingDown) {
+            // Ответ принятому слушающим сокетом в неблокирующем режиме читается как обычно
+            fcntl(clientSocket, F_SETFL, fcntl(clientSocket, F_GETFL) & ~O_NONBLOCK);
+        }
+        activeConnections.add(1);
+        // Память предыдущего запроса освобождается целиком
+        arena.reset();
         
         char buffer[8192] = {0};
         ssize_t bytesRead = read(clientSocket, buffer, sizeof(buffer) - 1);
         if (bytesRead <= 0) {
             close(clientSocket);
+            activeConnections.add(-1);
+            continue;
+        }
+        
+        auto requestStart = std::chrono::steady_clock::now();
+        uint64_t traceId = beginTrace();
+        TraceSpan parseSpan("http.parse");
+        // Запрос разбирается прямо в буфере чтения, без копии
+        std::string_view request(buffer, bytesRead);
+        Route route = classifyRoute(request);
+        parseSpan.end();
+        
+        // Выгрузка метрик не требует сессии и не обращается к БД
+        if (route == Route::Metrics) {
+            std::string body = metrics.renderPrometheus();
+            std::ostringstream resp;
+            resp << "HTTP/1.1 200 OK\r\n"
+                 << "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                 << "Content-Length: " << body.length() << "\r\n"
+                 << "Connection: close\r\n\r\n"
+                 << body;
+            std::string response = resp.str();
+            send(clientSocket, response.c_str(), response.length(), 0);
+            close(clientSocket);
+            activeConnections.add(-1);
+            
+            endTrace(ROUTE_NAMES[static_cast<int>(route)]);
+            recordRequest(route, *routeMetrics[static_cast<int>(route)], bytesRead, response.length(), requestStart, traceId);
             continue;
         }
         
-        std::string request(buffer);
         std::string sessionId = getCookie(request, "session_id");
-        std::cout << "Session ID из cookie: '" << sessionId << "'" << std::endl;
-        Session* session = sessionId.empty() ? nullptr : db.getSession(sessionId);
+        
+        // Допуск до любой работы с БД: сначала бюджеты клиента, затем общий лимит
+        RateClass rateClass = rateClassOf(route);
+        std::string response;
+        int retryAfter = 0;
+        std::string_view clientIp(reinterpret_cast<const char*>(&clientAddr.sin_addr.s_addr), sizeof(clientAddr.sin_addr.s_addr));
+        if (rateLimiter && (!rateLimiter->allow(rateKey("ip", clientIp), rateClass, retryAfter) ||
+                            (!sessionId.empty() && !rateLimiter->allow(rateKey("session", sessionId), rateClass, retryAfter)))) {
+            admissionMetrics[static_cast<int>(rateClass)]->rateLimited.add();
+            LOG_DEBUG("Запрос отклонён").field("reason", "rate_limited").field("class", rateClassName(rateClass));
+            response = createRetryLaterResponse(429, TOO_MANY_REQUESTS_PAGE, retryAfter);
+        } else if (!inFlight.tryAcquire()) {
+            admissionMetrics[static_cast<int>(rateClass)]->shed.add();
+            LOG_WARN("Запрос отклонён").field("reason", "overloaded").field("in_flight", inFlight.current());
+            response = createRetryLaterResponse(503, OVERLOADED_PAGE, 1);
+        }
+        if (!response.empty()) {
+            send(clientSocket, response.c_str(), response.length(), 0);
+            close(clientSocket);
+            activeConnections.add(-1);
+            
+            endTrace(ROUTE_NAMES[static_cast<int>(route)]);
+            recordRequest(route, *routeMetrics[static_cast<int>(route)], bytesRead, response.length(), requestStart, traceId);
+            continue;
+        }
+        
+        // Отзывы токенов из других процессов подтягиваются не чаще раза в SESSION_REVOCATION_REFRESH секунд
+        if (tokenSessions) {
+            sessionTokens.refreshRevocationsIfDue(db, shared.revocationRefresh);
+        }
+        std::optional<Session> session;
+        if (!sessionId.empty()) {
+            session = tokenSessions ? sessionTokens.verify(sessionId) : db.getSession(sessionId);
+        }
         
         if (session) {
-            std::cout << "Сессия найдена! User: " << session->username << ", Admin: " << session->isAdmin << std::endl;
-        } else {
-            std::cout << "Сессия не найдена" << std::endl;
+            LOG_DEBUG("Сессия найдена").field("user", session->username).field("admin", session->isAdmin);
+        } else if (!sessionId.empty()) {
+            LOG_DEBUG("Сессия не найдена");
         }
         
-        std::string response;
+        // Условный GET: ETag из версий данных, параметров запроса и пользователя.
+        // При совпадении с If-None-Match - 304 без каталога, рейтингов и рендеринга.
+        // Пользователя даёт сессия: при SESSION_MODE=db она уже прочитана из БД
+        // (GET_SESSION), без запросов к БД 304 обходится только в режиме token.
+        std::string validatorHeaders;
+        bool notModified = false;
+        if (session && isVersionedRoute(route)) {
+            std::string variant = getRequestTarget(request) + (session->isAdmin ? "|admin" : "|user");
+            if (route == Route::Main) {
+                // Страница содержит имя пользователя и токен вкладки
+                variant += "|" + session->username + "|" + getCookie(request, "tab_token");
+            }
+            DataVersions& versions = DataVersions::instance();
+            std::string etag = versions.weakETag(variant);
+            validatorHeaders = cacheValidatorHeaders(etag, versions.lastModified());
+            std::string ifNoneMatch = getHeader(request, "If-None-Match");
+            notModified = !ifNoneMatch.empty() && etagMatches(ifNoneMatch, etag);
+        }
+        
+        // Ответ будет отправлен после хеширования пароля
+        bool deferred = false;
+        // Ответ уже отправлен обработчиком (streamedBytes байт)
+        bool streamed = false;
+        size_t streamedBytes = 0;
         
-        if (request.find("POST /login") == 0) {
+        if (notModified) {
+            response = createNotModifiedResponse(validatorHeaders);
+        } else if (request.find("POST /login") == 0) {
             size_t bodyStart = request.find("\r\n\r\n");
-            if (bodyStart != std::string::npos) {
-                std::string body = request.substr(bodyStart + 4);
-                std::cout << "POST body: '" << body << "'" << std::endl;
+            if (bodyStart != std::string_view::npos) {
+                FormData form(request.substr(bodyStart + 4), arena.memory());
                 
-                auto params = parsePostData(body);
+                std::string username(form.get("username"));
+                std::string password(form.get("password"));
                 
-                std::cout << "Параметры: ";
-                for (const auto& p : params) {
-                    std::cout << p.first << "='" << p.second << "' ";
+                std::optional<User> user;
+                if (!username.empty()) {
+                    user = db.getUserByUsername(username);
                 }
-                std::cout << std::endl;
-                
-                std::string username = params["username"];
-                std::string password = params["password"];
-                
-                std::cout << "Username: '" << username << "', Password: '" << password << "'" << std::endl;
                 
                 if (username.empty()) {
-                    std::cout << "ОШИБКА: Имя пользователя пустое!" << std::endl;
+                    LOG_INFO("Вход отклонён").field("reason", "empty_username");
                     response = createHTTPResponse(generateLoginPage("Ошибка: введите имя пользователя"));
-                    send(clientSocket, response.c_str(), response.length(), 0);
-                    close(clientSocket);
-                    continue;
-                }
-                
-                std::cout << "Попытка входа: " << username << std::endl;
-                
-                User* user = db.getUserByUsername(username);
-                
-                if (!user) {
-                    std::cout << "Пользователь не найден" << std::endl;
+                } else if (!user) {
+                    LOG_INFO("Вход отклонён").field("user", username).field("reason", "unknown_user");
                     response = createHTTPResponse(generateLoginPage("Пользователь не найден. Зарегистрируйтесь, пожалуйста."));
-                    send(clientSocket, response.c_str(), response.length(), 0);
-                    close(clientSocket);
-                    continue;
-                }
-                
-                std::cout << "Пользователь найден, isAdmin: " << user->isAdmin << std::endl;
-                
-                if (user->passwordHash == password) {
-                    // Генерируем уникальный токен для этой вкладки
-                    std::string tabToken = generateSessionId();
-                    
-                    std::string newSessionId = generateSessionId();
-                    std::cout << "Пароль верный, создаём новую сессию: " << newSessionId << std::endl;
-                    db.createSession(newSessionId, user->id);
-                    
-                    // Проверяем, что сессия создана
-                    Session* checkSession = db.getSession(newSessionId);
-                    if (checkSession) {
-                        std::cout << "Сессия создана успешно! User: " << checkSession->username << ", Admin: " << checkSession->isAdmin << std::endl;
-                        delete checkSession;
+                } else {
+                    PasswordHasher::Job job;
+                    job.ticket = ++nextTicket;
+                    job.owner = loopIndex;
+                    job.kind = PasswordHasher::Kind::Verify;
+                    job.password = password;
+                    job.stored = user->passwordHash;
+                    if (passwordHasher.submit(std::move(job))) {
+                        pendingAuth[nextTicket] = {clientSocket, route, username, user->id, user->isAdmin,
+                                                   static_cast<size_t>(bytesRead), requestStart, traceId};
+                        deferred = true;
                     } else {
-                        std::cout << "ОШИБКА: Сессия не создана!" << std::endl;
+                        LOG_WARN("Вход отклонён").field("user", username).field("reason", "hasher_overloaded");
+                        response = createRetryLaterResponse(503, generateLoginPage("Сервер перегружен, повторите вход через несколько секунд"), 1);
                     }
-                    
-                    // Создаём HTML страницу с редиректом и установкой sessionStorage + tab_token
-                    std::string redirectPage = "<!DOCTYPE html><html><head><meta charset='UTF-8'><script>"
-                        "sessionStorage.setItem('authenticated', 'true');"
-                        "sessionStorage.setItem('tab_token', '" + tabToken + "');"
-                        "window.location.href = '/?tab_token=" + tabToken + "';"
-                        "</script></head><body>Перенаправление...</body></html>";
-                    
-                    std::ostringstream resp;
-                    resp << "HTTP/1.1 200 OK\r\n"
-                         << "Content-Type: text/html; charset=utf-8\r\n"
-                         << "Set-Cookie: session_id=" << newSessionId << "; Path=/; HttpOnly\r\n"
-                         << "Set-Cookie: tab_token=" << tabToken << "; Path=/\r\n"
-                         << "Content-Length: " << redirectPage.length() << "\r\n"
-                         << "Connection: close\r\n\r\n"
-                         << redirectPage;
-                    response = resp.str();
-                } else {
-                    std::cout << "Неверный пароль" << std::endl;
-                    response = createHTTPResponse(generateLoginPage("Неверный пароль"));
                 }
-                
-                delete user;
             }
         } else if (request.find("GET /register") == 0) {
             response = createHTTPResponse(generateRegisterPage());
         } else if (request.find("POST /register") == 0) {
             size_t bodyStart = request.find("\r\n\r\n");
-            if (bodyStart != std::string::npos) {
-                std::string body = request.substr(bodyStart + 4);
-                auto params = parsePostData(body);
+            if (bodyStart != std::string_view::npos) {
+                FormData form(request.substr(bodyStart + 4), arena.memory());
                 
-                std::string username = params["username"];
-                std::string password = params["password"];
-                std::string passwordConfirm = params["password_confirm"];
+                std::string username(form.get("username"));
+                std::string password(form.get("password"));
+                std::string_view passwordConfirm = form.get("password_confirm");
                 
                 // Валидация
                 if (username.empty() || username.length() < 3) {
@@ -955,43 +577,22 @@ int main() {
                     response = createHTTPResponse(generateRegisterPage("Пароли не совпадают", username, ""));
                 } else {
                     // Проверка, существует ли пользователь
-                    User* existingUser = db.getUserByUsername(username);
-                    if (existingUser) {
-                        delete existingUser;
+                    if (db.getUserByUsername(username)) {
                         response = createHTTPResponse(generateRegisterPage("Пользователь с таким именем уже существует", username, ""));
                     } else {
-                        // Создание пользователя (admin только если имя "admin")
-                        bool isAdmin = (username == "admin");
-                        if (db.createUser(username, password, isAdmin)) {
-                            // Автоматический вход после регистрации
-                            User* newUser = db.getUserByUsername(username);
-                            if (newUser) {
-                                std::string tabToken = generateSessionId();
-                                std::string newSessionId = generateSessionId();
-                                db.createSession(newSessionId, newUser->id);
-                                
-                                std::string redirectPage = "<!DOCTYPE html><html><head><meta charset='UTF-8'><script>"
-                                    "sessionStorage.setItem('authenticated', 'true');"
-                                    "sessionStorage.setItem('tab_token', '" + tabToken + "');"
-                                    "window.location.href = '/?tab_token=" + tabToken + "';"
-                                    "</script></head><body>Регистрация успешна! Перенаправление...</body></html>";
-                                
-                                std::ostringstream resp;
-                                resp << "HTTP/1.1 200 OK\r\n"
-                                     << "Content-Type: text/html; charset=utf-8\r\n"
-                                     << "Set-Cookie: session_id=" << newSessionId << "; Path=/; HttpOnly\r\n"
-                                     << "Set-Cookie: tab_token=" << tabToken << "; Path=/\r\n"
-                                     << "Content-Length: " << redirectPage.length() << "\r\n"
-                                     << "Connection: close\r\n\r\n"
-                                     << redirectPage;
-                                response = resp.str();
-                                
-                                delete newUser;
-                            } else {
-                                response = createHTTPResponse(generateRegisterPage("Ошибка при создании пользователя", username, ""));
-                            }
+                        // Создание пользователя (admin только если имя "admin") - после хеширования пароля
+                        PasswordHasher::Job job;
+                        job.ticket = ++nextTicket;
+                        job.owner = loopIndex;
+                        job.kind = PasswordHasher::Kind::Hash;
+                        job.password = password;
+                        if (passwordHasher.submit(std::move(job))) {
+                            pendingAuth[nextTicket] = {clientSocket, route, username, 0, username == "admin",
+                                                       static_cast<size_t>(bytesRead), requestStart, traceId};
+                            deferred = true;
                         } else {
-                            response = createHTTPResponse(generateRegisterPage("Ошибка при создании пользователя", username, ""));
+                            LOG_WARN("Регистрация отклонена").field("user", username).field("reason", "hasher_overloaded");
+                            response = createRetryLaterResponse(503, generateRegisterPage("Сервер перегружен, повторите попытку через несколько секунд", username, ""), 1);
                         }
                     }
                 }
@@ -1000,313 +601,376 @@ int main() {
             }
         } else if (request.find("POST /logout") == 0) {
             if (!sessionId.empty()) {
-                db.deleteSession(sessionId);
+                if (tokenSessions) {
+                    sessionTokens.revoke(db, sessionId);
+                } else {
+                    db.deleteSession(sessionId);
+                }
             }
             response = "HTTP/1.1 302 Found\r\nLocation: /\r\nSet-Cookie: session_id=; Path=/; HttpOnly; Max-Age=0\r\nSet-Cookie: tab_token=; Path=/; Max-Age=0\r\nConnection: close\r\n\r\n";
         } else if (request.find("POST /add") == 0 && session && session->isAdmin) {
             size_t bodyStart = request.find("\r\n\r\n");
-            if (bodyStart != std::string::npos) {
-                std::string body = request.substr(bodyStart + 4);
-                auto params = parsePostData(body);
-                
-                std::string website = params["website"];
-                int countryId = 0;
-                if (!params["country_id"].empty()) {
-                    try { countryId = std::stoi(params["country_id"]); } catch (...) {}
-                }
+            if (bodyStart != std::string_view::npos) {
+                FormData form(request.substr(bodyStart + 4), arena.memory());
+                IntegratorForm integrator = readIntegratorForm(form);
                 
                 // Добавляем интегратора и получаем ID
-                int newId = db.addIntegratorAndGetId(params["name"], params["city"], params["description"], website, countryId);
+                int newId = db.addIntegratorAndGetId(integrator.name, integrator.city, integrator.description,
+                                                     integrator.website, integrator.countryId);
                 
                 if (newId > 0) {
-                    // Добавляем лицензии
-                    size_t pos = 0;
-                    while ((pos = body.find("license_number[]=", pos)) != std::string::npos) {
-                        pos += 17;
-                        size_t end = body.find("&", pos);
-                        if (end == std::string::npos) end = body.length();
-                        std::string num = urlDecode(body.substr(pos, end - pos));
-                        pos = body.find("license_issued_by[]=", end);
-                        if (pos != std::string::npos) {
-                            pos += 20;
-                            end = body.find("&", pos);
-                            if (end == std::string::npos) end = body.length();
-                            std::string issued = urlDecode(body.substr(pos, end - pos));
-                            if (!num.empty() && !issued.empty()) {
-                                db.addLicense(newId, num, issued);
-                            }
-                        }
+                    for (const auto& license : integrator.licenses) {
+                        db.addLicense(newId, license.number, license.issuedBy);
                     }
-                    
-                    // Добавляем сертификаты
-                    pos = 0;
-                    while ((pos = body.find("certificate_name[]=", pos)) != std::string::npos) {
-                        pos += 19;
-                        size_t end = body.find("&", pos);
-                        if (end == std::string::npos) end = body.length();
-                        std::string name = urlDecode(body.substr(pos, end - pos));
-                        
-                        pos = body.find("certificate_number[]=", end);
-                        std::string number = "";
-                        if (pos != std::string::npos) {
-                            pos += 21;
-                            end = body.find("&", pos);
-                            if (end == std::string::npos) end = body.length();
-                            number = urlDecode(body.substr(pos, end - pos));
-                        }
-                        
-                        pos = body.find("certificate_issued_by[]=", end);
-                        if (pos != std::string::npos) {
-                            pos += 24;
-                            end = body.find("&", pos);
-                            if (end == std::string::npos) end = body.length();
-                            std::string issued = urlDecode(body.substr(pos, end - pos));
-                            if (!name.empty() && !issued.empty()) {
-                                db.addCertificate(newId, name, number, issued);
-                            }
-                        }
+                    for (const auto& cert : integrator.certificates) {
+                        db.addCertificate(newId, cert.name, cert.number, cert.issuedBy);
                     }
-                    
-                    // Добавляем продукты
-                    std::vector<int> productIds;
-                    pos = 0;
-                    while ((pos = body.find("products[]=", pos)) != std::string::npos) {
-                        pos += 11;
-                        size_t end = body.find("&", pos);
-                        if (end == std::string::npos) end = body.length();
-                        try {
-                            productIds.push_back(std::stoi(urlDecode(body.substr(pos, end - pos))));
-                        } catch (...) {}
+                    if (!integrator.productIds.empty()) {
+                        db.setIntegratorProducts(newId, integrator.productIds);
                     }
-                    if (!productIds.empty()) {
-                        db.setIntegratorProducts(newId, productIds);
-                    }
-                    
-                    // Добавляем услуги
-                    std::vector<int> serviceIds;
-                    pos = 0;
-                    while ((pos = body.find("services[]=", pos)) != std::string::npos) {
-                        pos += 11;
-                        size_t end = body.find("&", pos);
-                        if (end == std::string::npos) end = body.length();
-                        try {
-                            serviceIds.push_back(std::stoi(urlDecode(body.substr(pos, end - pos))));
-                        } catch (...) {}
-                    }
-                    if (!serviceIds.empty()) {
-                        db.setIntegratorServices(newId, serviceIds);
+                    if (!integrator.serviceIds.empty()) {
+                        db.setIntegratorServices(newId, integrator.serviceIds);
                     }
                 }
             }
+            catalog.invalidate();
             response = createRedirectResponse("/");
         } else if (request.find("POST /update") == 0 && session && session->isAdmin) {
             size_t bodyStart = request.find("\r\n\r\n");
-            if (bodyStart != std::string::npos) {
-                std::string body = request.substr(bodyStart + 4);
-                auto params = parsePostData(body);
-                
-                int id = std::stoi(params["id"]);
-                std::string website = params["website"];
-                int countryId = 0;
-                if (!params["country_id"].empty()) {
-                    try { countryId = std::stoi(params["country_id"]); } catch (...) {}
-                }
-                
-                // Обновляем интегратора
-                db.updateIntegrator(id, params["name"], params["city"], params["description"], website, countryId);
-                
-                // Обновляем лицензии
-                db.deleteLicenses(id);
-                size_t pos = 0;
-                while ((pos = body.find("license_number[]=", pos)) != std::string::npos) {
-                    pos += 17;
-                    size_t end = body.find("&", pos);
-                    if (end == std::string::npos) end = body.length();
-                    std::string num = urlDecode(body.substr(pos, end - pos));
-                    pos = body.find("license_issued_by[]=", end);
-                    if (pos != std::string::npos) {
-                        pos += 20;
-                        end = body.find("&", pos);
-                        if (end == std::string::npos) end = body.length();
-                        std::string issued = urlDecode(body.substr(pos, end - pos));
-                        if (!num.empty() && !issued.empty()) {
-                            db.addLicense(id, num, issued);
-                        }
-                    }
-                }
-                
-                // Обновляем сертификаты
-                db.deleteCertificates(id);
-                pos = 0;
-                while ((pos = body.find("certificate_name[]=", pos)) != std::string::npos) {
-                    pos += 19;
-                    size_t end = body.find("&", pos);
-                    if (end == std::string::npos) end = body.length();
-                    std::string name = urlDecode(body.substr(pos, end - pos));
+            if (bodyStart != std::string_view::npos) {
+                FormData form(request.substr(bodyStart + 4), arena.memory());
+                int id;
+                if (parseFormInt(form.get("id"), id)) {
+                    IntegratorForm integrator = readIntegratorForm(form);
                     
-                    pos = body.find("certificate_number[]=", end);
-                    std::string number = "";
-                    if (pos != std::string::npos) {
-                        pos += 21;
-                        end = body.find("&", pos);
-                        if (end == std::string::npos) end = body.length();
-                        number = urlDecode(body.substr(pos, end - pos));
-                    }
+                    // Обновляем интегратора
+                    db.updateIntegrator(id, integrator.name, integrator.city, integrator.description,
+                                        integrator.website, integrator.countryId);
                     
-                    pos = body.find("certificate_issued_by[]=", end);
-                    if (pos != std::string::npos) {
-                        pos += 24;
-                        end = body.find("&", pos);
-                        if (end == std::string::npos) end = body.length();
-                        std::string issued = urlDecode(body.substr(pos, end - pos));
-                        if (!name.empty() && !issued.empty()) {
-                            db.addCertificate(id, name, number, issued);
-                        }
+                    // Лицензии и сертификаты заменяются целиком
+                    db.deleteLicenses(id);
+                    for (const auto& license : integrator.licenses) {
+                        db.addLicense(id, license.number, license.issuedBy);
                     }
+                    db.deleteCertificates(id);
+                    for (const auto& cert : integrator.certificates) {
+                        db.addCertificate(id, cert.name, cert.number, cert.issuedBy);
+                    }
+                    db.setIntegratorProducts(id, integrator.productIds);
+                    db.setIntegratorServices(id, integrator.serviceIds);
                 }
-                
-                // Обновляем продукты
-                std::vector<int> productIds;
-                pos = 0;
-                while ((pos = body.find("products[]=", pos)) != std::string::npos) {
-                    pos += 11;
-                    size_t end = body.find("&", pos);
-                    if (end == std::string::npos) end = body.length();
-                    try {
-                        productIds.push_back(std::stoi(urlDecode(body.substr(pos, end - pos))));
-                    } catch (...) {}
-                }
-                db.setIntegratorProducts(id, productIds);
-                
-                // Обновляем услуги
-                std::vector<int> serviceIds;
-                pos = 0;
-                while ((pos = body.find("services[]=", pos)) != std::string::npos) {
-                    pos += 11;
-                    size_t end = body.find("&", pos);
-                    if (end == std::string::npos) end = body.length();
-                    try {
-                        serviceIds.push_back(std::stoi(urlDecode(body.substr(pos, end - pos))));
-                    } catch (...) {}
-                }
-                db.setIntegratorServices(id, serviceIds);
             }
+            catalog.invalidate();
             response = createRedirectResponse("/");
         } else if (request.find("POST /delete") == 0 && session && session->isAdmin) {
             size_t bodyStart = request.find("\r\n\r\n");
-            if (bodyStart != std::string::npos) {
-                std::string body = request.substr(bodyStart + 4);
-                auto params = parsePostData(body);
-                db.deleteIntegrator(std::stoi(params["id"]));
+            if (bodyStart != std::string_view::npos) {
+                FormData form(request.substr(bodyStart + 4), arena.memory());
+                int id;
+                if (parseFormInt(form.get("id"), id)) {
+                    db.deleteIntegrator(id);
+                }
             }
+            catalog.invalidate();
             response = createRedirectResponse("/");
         } else if (request.find("POST /rate") == 0 && session) {
             size_t bodyStart = request.find("\r\n\r\n");
-            if (bodyStart != std::string::npos) {
-                std::string body = request.substr(bodyStart + 4);
-                auto params = parsePostData(body);
-                int integratorId = std::stoi(params["id"]);
-                int ratingVal = std::stoi(params["rating"]);
-                ratingVal = std::max(1, std::min(5, ratingVal));
-                std::string comment = params["comment"];
-                db.addOrUpdateRating(integratorId, session->userId, ratingVal, comment);
+            if (bodyStart != std::string_view::npos) {
+                FormData form(request.substr(bodyStart + 4), arena.memory());
+                int integratorId;
+                int ratingVal;
+                if (parseFormInt(form.get("id"), integratorId) && parseFormInt(form.get("rating"), ratingVal)) {
+                    ratingVal = std::max(1, std::min(5, ratingVal));
+                    db.addOrUpdateRating(integratorId, session->userId, ratingVal, std::string(form.get("comment")));
+                }
             }
             response = createRedirectResponse("/");
         } else if (request.find("GET / ") == 0 || request.find("GET /?") == 0) {
             if (session) {
                 std::string tabToken = getCookie(request, "tab_token");
-                std::cout << "Пользователь: " << session->username << ", Admin: " << (session->isAdmin ? "Да" : "Нет") << ", Tab token: " << tabToken << std::endl;
+                LOG_DEBUG("Главная страница").field("user", session->username).field("admin", session->isAdmin);
                 
-                // Получаем параметры фильтрации и сортировки
-                std::string cityParam = getQueryParam(request, "city");
-                std::string filterCity = getQueryParam(request, "filter_city");
-                std::string searchName = getQueryParam(request, "name");
-                std::string sortOption = getQueryParam(request, "sort");
-                if (sortOption.empty()) sortOption = "name_asc";
-                if (sortOption != "name_asc" && sortOption != "name_desc" &&
-                    sortOption != "city_asc" && sortOption != "city_desc" &&
-                    sortOption != "rating_desc" && sortOption != "rating_asc") {
-                    sortOption = "name_asc";
-                }
+                // Параметры фильтрации, сортировки и страницы - как у /api/integrators
+                ListingQuery query = parseListingQuery(request, shared.searchIndexAvailable);
+                std::shared_ptr<const CatalogSnapshot> catalogSnapshot = catalog.get(db);
 
-                int page = 1;
-                std::string pageParam = getQueryParam(request, "page");
-                if (!pageParam.empty()) {
-                    try { page = std::max(1, std::stoi(pageParam)); } catch (...) { page = 1; }
-                }
-                const int pageSize = 5;
+                // Шапка и форма поиска (города и справочники снимка) уходят клиенту
+                // до запросов выдачи и отзывов, интеграторы - пачками
+                TraceSpan renderSpan("render.mainPage");
+                ResponseStream stream(clientSocket, 200, "text/html; charset=utf-8");
+                stream.addHeaders(validatorHeaders);
+                renderMainPageHeader(stream.bodyStream(), session->isAdmin, session->username, tabToken,
+                                     catalogSnapshot->cities, catalogSnapshot->products, catalogSnapshot->services, query);
+                stream.flush(true);
 
-                // Получаем данные
-                std::vector<Integrator> integrators = db.getAllIntegrators();
+                // Клиент, отключившийся после шапки, не стоит запросов к БД
+                if (stream.ok()) {
+                    ListingPage listing = buildListingPage(db, *catalogSnapshot, catalog.ratings(db, catalogSnapshot), query);
 
-                // Фильтрация по городу и названию
-                std::vector<Integrator> filtered;
-                for (const auto& itg : integrators) {
-                    if (!filterCity.empty() && itg.city != filterCity) continue;
-                    if (!cityParam.empty() && !containsCaseInsensitive(itg.city, cityParam)) continue;
-                    if (!searchName.empty() && !containsCaseInsensitive(itg.name, searchName)) continue;
-                    filtered.push_back(itg);
-                }
-
-                // Статистика рейтингов для сортировки и отображения
-                std::map<int, RatingStats> ratingStats = db.getRatingStats();
-
-                // Сортировка
-                std::sort(filtered.begin(), filtered.end(), [&](const Integrator& a, const Integrator& b) {
-                    if (sortOption == "name_desc") return a.name > b.name;
-                    if (sortOption == "city_asc") return a.city < b.city;
-                    if (sortOption == "city_desc") return a.city > b.city;
-                    if (sortOption == "rating_desc") {
-                        double ra = ratingStats.count(a.id) ? ratingStats[a.id].average : 0.0;
-                        double rb = ratingStats.count(b.id) ? ratingStats[b.id].average : 0.0;
-                        if (ra == rb) return a.name < b.name;
-                        return ra > rb;
-                    }
-                    if (sortOption == "rating_asc") {
-                        double ra = ratingStats.count(a.id) ? ratingStats[a.id].average : 0.0;
-                        double rb = ratingStats.count(b.id) ? ratingStats[b.id].average : 0.0;
-                        if (ra == rb) return a.name < b.name;
-                        return ra < rb;
+                    // Отзывы для текущей страницы - одним запросом на всю страницу
+                    std::vector<int> pageIds;
+                    pageIds.reserve(listing.items.size());
+                    for (const Integrator* itg : listing.items) {
+                        pageIds.push_back(itg->id);
                     }
-                    // default name_asc
-                    return a.name < b.name;
-                });
+                    std::map<int, std::vector<Rating>> integratorRatings = db.getRatingsByIntegrators(pageIds);
 
-                // Пагинация
-                int total = static_cast<int>(filtered.size());
-                int totalPages = std::max(1, (total + pageSize - 1) / pageSize);
-                if (page > totalPages) page = totalPages;
-                int start = (page - 1) * pageSize;
-                int end = std::min(start + pageSize, total);
-                std::vector<Integrator> pageItems;
-                for (int i = start; i < end; i++) pageItems.push_back(filtered[i]);
-
-                // Рейтинги для текущей страницы
-                std::map<int, std::vector<Rating>> integratorRatings;
-                for (const auto& itg : pageItems) {
-                    integratorRatings[itg.id] = db.getRatingsByIntegrator(itg.id);
+                    renderMainPageListing(stream.bodyStream(), [&stream]() { stream.flush(true); return stream.ok(); },
+                                          listing.items, session->isAdmin, true, catalogSnapshot->countries,
+                                          catalogSnapshot->products, catalogSnapshot->services, query, listing.page,
+                                          listing.totalPages, listing.total, listing.ratingStats(), integratorRatings);
                 }
-
-                std::vector<std::string> cities = db.getAllCities();
-                std::vector<std::pair<int, std::string>> countries = db.getAllCountries();
-                std::vector<std::pair<int, std::string>> products = db.getAllProducts();
-                std::vector<std::pair<int, std::string>> services = db.getAllServices();
-                response = createHTTPResponse(generateMainPage(pageItems, session->isAdmin, true, session->username, tabToken, cities, countries, products, services, cityParam, filterCity, searchName, sortOption, page, totalPages, total, ratingStats, integratorRatings));
+                streamedBytes = stream.finish();
+                streamed = true;
             } else {
                 response = createHTTPResponse(generateLoginPage());
             }
+        } else if (route == Route::SlowQueries && session && session->isAdmin) {
+            SlowQueryLog& slowQueries = SlowQueryLog::instance();
+            response = createHTTPResponse(generateSlowQueriesPage(slowQueries.top(slowQueryTop), slowQueries.thresholdMicros()));
+        } else if (route == Route::ApiIntegrators || route == Route::ApiIntegrator ||
+                   route == Route::ApiRatings || route == Route::ApiLookup) {
+            if (session) {
+                // JSON пишется прямо в сокет по мере сериализации
+                int apiId = 0;
+                ApiEndpoint endpoint = parseApiEndpoint(request, apiId);
+                streamedBytes = serveApiRequest(clientSocket, request, endpoint, apiId, db, catalog,
+                                                shared.searchIndexAvailable, validatorHeaders);
+                streamed = true;
+            } else {
+                response = createJsonResponse(401, "{\"error\":\"unauthorized\"}");
+            }
         } else if (request.find("GET /login_required") == 0) {
             response = createHTTPResponse(generateLoginPage("Требуется авторизация"));
         } else {
             response = createHTTPResponse(generateLoginPage());
         }
         
-        send(clientSocket, response.c_str(), response.length(), 0);
+        if (deferred) {
+            // Трасса закрывается здесь; запрос учитывается в метриках при ответе
+            endTrace(ROUTE_NAMES[static_cast<int>(route)]);
+            continue;
+        }
+        
+        TraceSpan sendSpan("http.send");
+        if (!streamed) {
+            send(clientSocket, response.c_str(), response.length(), 0);
+        }
         close(clientSocket);
+        sendSpan.end();
+        activeConnections.add(-1);
+        inFlight.release();
         
-        delete session;
+        endTrace(ROUTE_NAMES[static_cast<int>(route)]);
+        recordRequest(route, *routeMetrics[static_cast<int>(route)], bytesRead,
+                      streamed ? streamedBytes : response.length(), requestStart, traceId);
+    }
+    
+    // Не дождавшиеся хеширования до срока получают 503
+    for (const auto& entry : pendingAuth) {
+        const PendingAuth& pending = entry.second;
+        std::string response = createRetryLaterResponse(503, OVERLOADED_PAGE, 1);
+        send(pending.clientSocket, response.c_str(), response.length(), 0);
+        close(pending.clientSocket);
+        activeConnections.add(-1);
+        inFlight.release();
+        recordRequest(pending.route, *routeMetrics[static_cast<int>(pending.route)], pending.bytesIn,
+                      response.length(), pending.start, pending.traceId);
+    }
+    if (serverSocket >= 0) {
+        close(serverSocket);
+    }
+    LOG_INFO("Цикл обработки остановлен").field("loop", loopIndex).field("dropped_auth", pendingAuth.size());
+}
+
+int main(int, char** argv) {
+    startLogger(parseLogLevel(getEnv("LOG_LEVEL", "info")), getEnv("LOG_FILE", ""));
+    startTracing(std::atof(getEnv("TRACE_SAMPLE_RATE", "0.01").c_str()), getEnv("TRACE_FILE", ""));
+    int signalFd = installProcessSignals();
+    
+    // При перезапуске без простоя слушающие сокеты передаются от предыдущего процесса
+    std::vector<int> listeners = inheritedListenSockets();
+    if (!listeners.empty()) {
+        LOG_INFO("Слушающие сокеты унаследованы").field("count", listeners.size());
     }
     
-    close(serverSocket);
+    // Циклы обработки: по слушающему сокету и соединению с БД на каждый (0 - по числу процессоров)
+    size_t eventLoops = std::strtoul(getEnv("EVENT_LOOPS", "1").c_str(), nullptr, 10);
+    if (eventLoops == 0) eventLoops = cpuCount();
+    eventLoops = std::max(eventLoops, listeners.size());
+    
+    // Получение параметров подключения из переменных окружения или использование значений по умолчанию
+    std::string dbHost = getEnv("DB_HOST", "localhost");
+    std::string dbPort = getEnv("DB_PORT", "5432");
+    std::string dbName = getEnv("DB_NAME", "infosec_db");
+    std::string dbUser = getEnv("DB_USER", "postgres");
+    std::string dbPassword = getEnv("DB_PASSWORD", "password");
+    
+    // Схему и начальные данные готовит первое соединение
+    std::vector<std::unique_ptr<Database>> databases;
+    for (size_t i = 0; i < eventLoops; i++) {
+        databases.emplace_back(new Database(dbHost, dbPort, dbName, dbUser, dbPassword));
+        if (!databases.back()->connect(i == 0)) {
+            return 1;
+        }
+    }
+    Database& db = *databases[0];
+    
+    ServerShared shared;
+    shared.searchIndexAvailable = db.isSearchIndexAvailable();
+    
+    // Журнал медленных запросов: порог в мс (0 - выключен), EXPLAIN на отдельном соединении
+    uint64_t slowQueryMs = std::strtoull(getEnv("SLOW_QUERY_MS", "200").c_str(), nullptr, 10);
+    shared.slowQueryTop = std::strtoul(getEnv("SLOW_QUERY_TOP", "20").c_str(), nullptr, 10);
+    bool slowQueryExplain = getEnv("SLOW_QUERY_EXPLAIN", "0") == "1";
+    SlowQueryLog::instance().configure(slowQueryMs * 1000, slowQueryExplain ? db.getConnectionString() : "");
+    
+    // Очистка просроченных сессий в фоне на отдельном соединении; интервал в секундах, 0 - выключена
+    int sweepInterval = std::atoi(getEnv("SESSION_SWEEP_INTERVAL", "300").c_str());
+    int sweepBatch = std::atoi(getEnv("SESSION_SWEEP_BATCH", "500").c_str());
+    std::unique_ptr<SessionSweeper> sessionSweeper;
+    if (sweepInterval > 0) {
+        sessionSweeper.reset(new SessionSweeper(
+            std::unique_ptr<Database>(new Database(dbHost, dbPort, dbName, dbUser, dbPassword)),
+            std::chrono::seconds(sweepInterval), std::max(sweepBatch, 1)));
+        sessionSweeper->start();
+    }
+    
+    // Хеширование паролей (scrypt) в отдельном пуле: десятки миллисекунд на вход
+    // не должны останавливать цикл обработки запросов. Очередь ограничена -
+    // при переполнении вход и регистрация получают 503. Пул один на все циклы,
+    // поэтому потоки, память scrypt и очередь не умножаются на EVENT_LOOPS.
+    // Неверная сложность ломает каждую регистрацию и перехеширование - сервер не стартует
+    std::string scryptLogN = getEnv("PASSWORD_SCRYPT_LOG_N", "15");
+    char* scryptLogNEnd = nullptr;
+    long logN = std::strtol(scryptLogN.c_str(), &scryptLogNEnd, 10);
+    if (scryptLogN.empty() || *scryptLogNEnd != '\0' || logN < SCRYPT_MIN_LOG_N || logN > SCRYPT_MAX_LOG_N) {
+        LOG_ERROR("Некорректный PASSWORD_SCRYPT_LOG_N")
+            .field("value", scryptLogN).field("min", SCRYPT_MIN_LOG_N).field("max", SCRYPT_MAX_LOG_N);
+        return 1;
+    }
+    ScryptParams scryptParams;
+    scryptParams.logN = static_cast<int>(logN);
+    size_t passwordWorkers = std::max<size_t>(std::strtoul(getEnv("PASSWORD_WORKERS", "2").c_str(), nullptr, 10), 1);
+    size_t passwordQueue = std::strtoul(getEnv("PASSWORD_QUEUE", "16").c_str(), nullptr, 10);
+    shared.passwordHasher.reset(new PasswordHasher(passwordWorkers, passwordQueue, scryptParams, eventLoops));
+    
+    // Режим сессий: db - строка в sessions и запрос к БД на каждый запрос,
+    // token - подписанный токен, проверяемый без БД (см. session_tokens.h)
+    shared.tokenSessions = getEnv("SESSION_MODE", "db") == "token";
+    shared.revocationRefresh = std::chrono::seconds(std::atoi(getEnv("SESSION_REVOCATION_REFRESH", "5").c_str()));
+    if (shared.tokenSessions) {
+        std::string sessionKeys = getEnv("SESSION_KEYS", "");
+        if (sessionKeys.empty()) {
+            LOG_WARN("SESSION_KEYS не задан: ключ подписи сгенерирован, сессии не переживут перезапуск");
+            shared.sessionTokens.generateKey();
+        } else if (!shared.sessionTokens.configureKeys(sessionKeys)) {
+            return 1;
+        }
+        shared.sessionTokens.refreshRevocations(db);
+    }
+    
+    // Недостающие слушающие сокеты. SO_REUSEPORT нужен нескольким циклам, а также
+    // новому экземпляру, который занимает порт, пока старый дообслуживает запросы.
+    bool reusePort = getEnv("REUSE_PORT", "1") == "1" || eventLoops > 1;
+    int listenBacklog = std::max(1, std::atoi(getEnv("LISTEN_BACKLOG", "128").c_str()));
+    while (listeners.size() < eventLoops) {
+        int listener = openListener(8080, reusePort, listenBacklog);
+        if (listener < 0) {
+            return 1;
+        }
+        listeners.push_back(listener);
+    }
+    
+    // Метрики маршрутов разрешаются один раз, в цикле обработки только атомарные счётчики
+    MetricsRegistry& metrics = MetricsRegistry::instance();
+    for (int i = 0; i < static_cast<int>(Route::Count); i++) {
+        shared.routeMetrics[i] = &metrics.route(ROUTE_NAMES[i]);
+    }
+    shared.activeConnections = &metrics.activeConnections();
+    for (int i = 0; i < static_cast<int>(RateClass::Count); i++) {
+        shared.admissionMetrics[i] = &metrics.admission(rateClassName(static_cast<RateClass>(i)));
+    }
+    
+    // Допуск запросов: token bucket на IP и на сессию (0 ячеек - выключено)
+    // и общий лимит одновременных запросов. Отказ формируется без обращения к БД.
+    size_t rateLimitSlots = std::strtoul(getEnv("RATE_LIMIT_SLOTS", "65536").c_str(), nullptr, 10);
+    if (rateLimitSlots > 0) {
+        RateLimiter::Budget budgets[static_cast<int>(RateClass::Count)] = {
+            parseBudget(getEnv("RATE_LIMIT_AUTH", "1:5")),
+            parseBudget(getEnv("RATE_LIMIT_READ", "10:40")),
+            parseBudget(getEnv("RATE_LIMIT_WRITE", "2:10")),
+        };
+        shared.rateLimiter.reset(new RateLimiter(rateLimitSlots, budgets));
+    }
+    shared.inFlight.reset(new ConcurrencyLimiter(std::max(1, std::atoi(getEnv("MAX_IN_FLIGHT", "64").c_str()))));
+    
+    shared.drainTimeout = std::chrono::seconds(std::atoi(getEnv("SHUTDOWN_DRAIN_SECONDS", "8").c_str()));
+    shared.pinLoops = getEnv("PIN_EVENT_LOOPS", "0") == "1";
+    int stopPipe[2];
+    if (pipe(stopPipe) < 0) {
+        LOG_ERROR("Ошибка создания pipe остановки").field("error", strerror(errno));
+        return 1;
+    }
+    fcntl(stopPipe[0], F_SETFD, FD_CLOEXEC);
+    fcntl(stopPipe[1], F_SETFD, FD_CLOEXEC);
+    shared.stopFd = stopPipe[0];
+    
+    std::vector<std::thread> loops;
+    for (size_t i = 0; i < eventLoops; i++) {
+        loops.emplace_back(runEventLoop, i, listeners[i], std::ref(*databases[i]), std::ref(shared));
+    }
+    LOG_INFO("Сервер запущен").field("address", "http://localhost:8080").field("event_loops", eventLoops);
+    // При перезапуске предыдущий процесс принимает соединения до этого сообщения
+    notifyReplacementReady();
+    
+    // Сколько секунд ждать готовности нового процесса при перезапуске (БД, схема, циклы)
+    int restartReadyTimeout = std::max(1, std::atoi(getEnv("RESTART_READY_TIMEOUT", "60").c_str()));
+    
+    // Главный поток только ждёт сигналов управления
+    while (true) {
+        pollfd signalPoll = {signalFd, POLLIN, 0};
+        if (poll(&signalPoll, 1, -1) < 0) continue;
+        ProcessSignal signal = takeProcessSignal(signalFd);
+        if (signal == ProcessSignal::Restart) {
+            // Пока новый процесс подключается к БД и готовит схему, циклы этого
+            // продолжают принимать соединения с общих слушающих сокетов
+            int readyFd = -1;
+            pid_t replacement = spawnReplacement(listeners, argv, readyFd);
+            if (replacement <= 0) {
+                LOG_ERROR("Перезапуск отменён, сервер продолжает работу");
+                continue;
+            }
+            LOG_INFO("Перезапуск: новый процесс получил слушающие сокеты").field("pid", replacement);
+            if (!waitReplacementReady(replacement, readyFd, restartReadyTimeout)) {
+                LOG_ERROR("Перезапуск отменён, сервер продолжает работу");
+                continue;
+            }
+            LOG_INFO("Перезапуск: новый процесс готов").field("pid", replacement);
+            shared.handoff = true;
+            break;
+        }
+        if (signal == ProcessSignal::Shutdown) {
+            break;
+        }
+    }
+    
+    LOG_INFO("Остановка сервера").field("handoff", shared.handoff.load());
+    close(stopPipe[1]);
+    for (auto& loop : loops) {
+        loop.join();
+    }
+    close(stopPipe[0]);
+    LOG_INFO("Сервер остановлен");
+    
+    if (sessionSweeper) {
+        sessionSweeper->stop();
+    }
+    SlowQueryLog::instance().stop();
+    for (auto& database : databases) {
+        database->disconnect();
+    }
+    stopTracing();
+    stopLogger();
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,93 @@
+#include "session_sweeper.h"
+#include "logger.h"
+
+namespace {
+
+// Пауза между пачками: строки таблицы освобождаются для запросов сервера
+const std::chrono::milliseconds BATCH_PAUSE(50);
+// Пачек за один проход; остаток дочищается на следующем
+const int MAX_BATCHES_PER_RUN = 1000;
+
+} // namespace
+
+SessionSweeper::SessionSweeper(std::unique_ptr<Database> db, std::chrono::seconds interval, int batchSize)
+    : db(std::move(db)), interval(interval), batchSize(batchSize) {}
+
+SessionSweeper::~SessionSweeper() {
+    stop();
+}
+
+void SessionSweeper::start() {
+    if (!thread.joinable()) {
+        stopping = false;
+        thread = std::thread(&SessionSweeper::run, this);
+    }
+}
+
+void SessionSweeper::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
+
+bool SessionSweeper::sleepFor(std::chrono::milliseconds duration) {
+    std::unique_lock<std::mutex> lock(mutex);
+    return !wake.wait_for(lock, duration, [this] { return stopping; });
+}
+
+void SessionSweeper::run() {
+    // Первый проход сразу при запуске - дочищает накопившееся за простой
+    bool connected = false;
+    do {
+        if (!connected) {
+            // Первое подключение или соединение потеряно на прошлом проходе
+            db->disconnect();
+            connected = db->connect(false);
+            if (!connected) continue;
+        }
+        if (!sweep("expired_sessions", &Database::deleteExpiredSessions, sessionMetrics) ||
+            !sweep("expired_session_revocations", &Database::deleteExpiredSessionRevocations, revocationMetrics)) {
+            break;
+        }
+        connected = db->isConnected();
+    } while (sleepFor(interval));
+    db->disconnect();
+}
+
+bool SessionSweeper::sweep(const char* task, int (Database::*deleteBatch)(int), MaintenanceMetrics& metrics) {
+    auto start = std::chrono::steady_clock::now();
+    long long total = 0;
+    int batches = 0;
+    bool failed = false;
+    while (batches < MAX_BATCHES_PER_RUN) {
+        int deleted = ((*db).*deleteBatch)(batchSize);
+        batches++;
+        if (deleted < 0) {
+            metrics.errors.add();
+            failed = true;
+            break;
+        }
+        total += deleted;
+        metrics.rowsDeleted.add(deleted);
+        if (deleted < batchSize) break;
+        if (!sleepFor(BATCH_PAUSE)) return false;
+    }
+    uint64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    metrics.runs.add();
+    metrics.duration.record(micros);
+    if (total > 0 || failed) {
+        LOG_INFO("Очистка просроченных строк")
+            .field("task", task)
+            .field("deleted", total)
+            .field("batches", batches)
+            .field("failed", failed)
+            .field("duration_us", micros);
+    }
+    return true;
+}
@@ -0,0 +1,243 @@
+#include "session_tokens.h"
+#include "logger.h"
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+namespace {
+
+const char BASE64URL[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// base64url без дополнения '=' - допустим в cookie без экранирования
+std::string base64UrlEncode(const unsigned char* data, size_t size) {
+    std::string result;
+    result.reserve((size + 2) / 3 * 4);
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t chunk = data[i] << 16;
+        if (i + 1 < size) chunk |= data[i + 1] << 8;
+        if (i + 2 < size) chunk |= data[i + 2];
+        result += BASE64URL[(chunk >> 18) & 63];
+        result += BASE64URL[(chunk >> 12) & 63];
+        if (i + 1 < size) result += BASE64URL[(chunk >> 6) & 63];
+        if (i + 2 < size) result += BASE64URL[chunk & 63];
+    }
+    return result;
+}
+
+bool base64UrlDecode(const std::string& text, std::string& out) {
+    out.clear();
+    uint32_t chunk = 0;
+    int bits = 0;
+    for (char c : text) {
+        int value;
+        if (c >= 'A' && c <= 'Z') value = c - 'A';
+        else if (c >= 'a' && c <= 'z') value = c - 'a' + 26;
+        else if (c >= '0' && c <= '9') value = c - '0' + 52;
+        else if (c == '-') value = 62;
+        else if (c == '_') value = 63;
+        else return false;
+        chunk = (chunk << 6) | value;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out += static_cast<char>((chunk >> bits) & 0xFF);
+        }
+    }
+    return true;
+}
+
+bool parseInt64(const std::string& text, int64_t& value) {
+    if (text.empty() || text.size() > 18) return false;
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + (c - '0');
+    }
+    return true;
+}
+
+} // namespace
+
+std::string randomHex(size_t bytes) {
+    std::vector<unsigned char> random(bytes);
+    if (RAND_bytes(random.data(), static_cast<int>(bytes)) != 1) {
+        // Без энтропии нельзя выдавать идентификаторы
+        LOG_ERROR("RAND_bytes не выдал случайные байты");
+        std::abort();
+    }
+    const char* hex = "0123456789abcdef";
+    std::string result;
+    result.reserve(bytes * 2);
+    for (unsigned char b : random) {
+        result += hex[b >> 4];
+        result += hex[b & 15];
+    }
+    return result;
+}
+
+bool SessionTokens::configureKeys(const std::string& spec) {
+    keys.clear();
+    signingKid.clear();
+    size_t pos = 0;
+    while (pos <= spec.size()) {
+        size_t end = spec.find(',', pos);
+        if (end == std::string::npos) end = spec.size();
+        std::string entry = spec.substr(pos, end - pos);
+        pos = end + 1;
+        if (entry.empty()) continue;
+
+        size_t colon = entry.find(':');
+        std::string kid = colon == std::string::npos ? "" : entry.substr(0, colon);
+        if (kid.empty() || kid.find('.') != std::string::npos || colon + 1 >= entry.size()) {
+            LOG_ERROR("Некорректный ключ в SESSION_KEYS").field("kid", kid);
+            keys.clear();
+            signingKid.clear();
+            return false;
+        }
+        std::string secret = entry.substr(colon + 1);
+        if (secret.size() < 32) {
+            LOG_WARN("Короткий ключ подписи сессий").field("kid", kid).field("bytes", secret.size());
+        }
+        keys[kid] = secret;
+        if (signingKid.empty()) signingKid = kid;
+    }
+    return !signingKid.empty();
+}
+
+void SessionTokens::generateKey() {
+    keys.clear();
+    signingKid = "local";
+    keys[signingKid] = randomHex(32);
+}
+
+std::string SessionTokens::sign(const std::string& kid, const std::string& data) const {
+    const std::string& key = keys.at(kid);
+    unsigned char mac[EVP_MAX_MD_SIZE];
+    unsigned int macSize = 0;
+    HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()), reinterpret_cast<const unsigned char*>(data.data()),
+         data.size(), mac, &macSize);
+    return base64UrlEncode(mac, macSize);
+}
+
+std::string SessionTokens::issue(int userId, const std::string& username, bool isAdmin) {
+    int64_t now = time(nullptr);
+    std::string claims = std::to_string(userId) + ":" + (isAdmin ? "1" : "0") + ":" + std::to_string(now) + ":" +
+                         std::to_string(now + ttlSeconds) + ":" + randomHex(16) + ":" + username;
+    std::string data = signingKid + "." +
+                       base64UrlEncode(reinterpret_cast<const unsigned char*>(claims.data()), claims.size());
+    return data + "." + sign(signingKid, data);
+}
+
+bool SessionTokens::decode(const std::string& token, Claims& claims) const {
+    size_t firstDot = token.find('.');
+    size_t lastDot = token.rfind('.');
+    if (firstDot == std::string::npos || firstDot == lastDot) return false;
+
+    auto key = keys.find(token.substr(0, firstDot));
+    if (key == keys.end()) return false;
+    std::string data = token.substr(0, lastDot);
+    std::string expected = sign(key->first, data);
+    std::string actual = token.substr(lastDot + 1);
+    if (actual.size() != expected.size() || CRYPTO_memcmp(actual.data(), expected.data(), expected.size()) != 0) {
+        return false;
+    }
+
+    std::string text;
+    if (!base64UrlDecode(token.substr(firstDot + 1, lastDot - firstDot - 1), text)) return false;
+    // uid:admin:iat:exp:jti:username - имя последним, в нём может быть ':'
+    std::string fields[5];
+    size_t pos = 0;
+    for (auto& field : fields) {
+        size_t colon = text.find(':', pos);
+        if (colon == std::string::npos) return false;
+        field = text.substr(pos, colon - pos);
+        pos = colon + 1;
+    }
+    int64_t userId;
+    if (!parseInt64(fields[0], userId) || !parseInt64(fields[2], claims.issuedAt) ||
+        !parseInt64(fields[3], claims.expiresAt)) {
+        return false;
+    }
+    claims.userId = static_cast<int>(userId);
+    claims.isAdmin = fields[1] == "1";
+    claims.tokenId = fields[4];
+    claims.username = text.substr(pos);
+    return true;
+}
+
+std::optional<Session> SessionTokens::verify(const std::string& token) const {
+    Claims claims;
+    if (!decode(token, claims) || claims.expiresAt <= static_cast<int64_t>(time(nullptr))) {
+        return std::nullopt;
+    }
+    {
+        std::lock_guard<std::mutex> lock(revocationMutex);
+        if (revokedTokens.count(claims.tokenId)) {
+            return std::nullopt;
+        }
+        auto userRevoked = userRevokedAt.find(claims.userId);
+        if (userRevoked != userRevokedAt.end() && claims.issuedAt <= userRevoked->second) {
+            return std::nullopt;
+        }
+    }
+
+    std::optional<Session> session(std::in_place);
+    session->sessionId = token;
+    session->userId = claims.userId;
+    session->username = std::move(claims.username);
+    session->isAdmin = claims.isAdmin;
+    return session;
+}
+
+bool SessionTokens::revoke(Database& db, const std::string& token) {
+    Claims claims;
+    if (!decode(token, claims)) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(revocationMutex);
+        revokedTokens.insert(claims.tokenId);
+    }
+    return db.revokeSessionToken(claims.tokenId, claims.userId, claims.expiresAt);
+}
+
+bool SessionTokens::refreshRevocations(Database& db) {
+    std::vector<SessionRevocation> revocations;
+    if (!db.getSessionRevocations(revocations)) {
+        return false;
+    }
+    // Новые списки строятся без блокировки, под мьютексом только обмен
+    std::unordered_set<std::string> tokens;
+    std::unordered_map<int, int64_t> users;
+    for (const auto& revocation : revocations) {
+        if (!revocation.tokenId.empty()) {
+            tokens.insert(revocation.tokenId);
+        } else {
+            int64_t& revokedAt = users[revocation.userId];
+            revokedAt = std::max<int64_t>(revokedAt, revocation.revokedAt);
+        }
+    }
+    std::lock_guard<std::mutex> lock(revocationMutex);
+    revokedTokens.swap(tokens);
+    userRevokedAt.swap(users);
+    revocationsRefreshedAt.store(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_relaxed);
+    return true;
+}
+
+void SessionTokens::refreshRevocationsIfDue(Database& db, std::chrono::seconds interval) {
+    int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t last = revocationsRefreshedAt.load(std::memory_order_relaxed);
+    if (last != 0 && now - last < std::chrono::duration_cast<std::chrono::milliseconds>(interval).count()) {
+        return;
+    }
+    // Отметку ставит тот, кто обновляет; остальные видят свежее время и выходят
+    if (revocationsRefreshedAt.compare_exchange_strong(last, now, std::memory_order_relaxed)) {
+        refreshRevocations(db);
+    }
+}
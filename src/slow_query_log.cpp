@@ -0,0 +1,215 @@
+#include "slow_query_log.h"
+#include "logger.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <strings.h>
+#include <libpq-fe.h>
+
+namespace {
+
+const size_t EXPLAIN_QUEUE_LIMIT = 16;
+
+// Числа показываем как есть, строки (имена, пароли, идентификаторы сессий,
+// поисковые запросы) - только длиной
+std::string redactParams(int paramCount, const char* const* paramValues) {
+    std::string result;
+    for (int i = 0; i < paramCount; i++) {
+        if (i > 0) result += ", ";
+        result += "$" + std::to_string(i + 1) + "=";
+        const char* value = paramValues[i];
+        if (value == nullptr) {
+            result += "NULL";
+            continue;
+        }
+        bool numeric = *value != '\0';
+        for (const char* p = value; *p; p++) {
+            if (!((*p >= '0' && *p <= '9') || (p == value && *p == '-'))) {
+                numeric = false;
+                break;
+            }
+        }
+        if (numeric) {
+            result += value;
+        } else {
+            result += "<строка, " + std::to_string(strlen(value)) + " байт>";
+        }
+    }
+    return result;
+}
+
+// Только чтение: SELECT без блокировки строк (FOR UPDATE/FOR SHARE).
+// Такой запрос можно выполнить повторно под EXPLAIN ANALYZE.
+bool isReadOnlyQuery(const std::string& sql) {
+    size_t pos = 0;
+    while (pos < sql.size()) {
+        if (isspace(static_cast<unsigned char>(sql[pos]))) {
+            pos++;
+        } else if (sql.compare(pos, 2, "--") == 0) {
+            pos = sql.find('\n', pos);
+        } else {
+            break;
+        }
+    }
+    if (pos >= sql.size() || strncasecmp(sql.c_str() + pos, "SELECT", 6) != 0) {
+        return false;
+    }
+    std::string upper = sql;
+    std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return toupper(c); });
+    return upper.find("FOR UPDATE") == std::string::npos && upper.find("FOR SHARE") == std::string::npos &&
+           upper.find("FOR NO KEY UPDATE") == std::string::npos;
+}
+
+std::string utcNow() {
+    time_t now = time(nullptr);
+    tm utc;
+    gmtime_r(&now, &utc);
+    char buffer[32];
+    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", &utc);
+    return buffer;
+}
+
+} // namespace
+
+SlowQueryLog& SlowQueryLog::instance() {
+    static SlowQueryLog* log = new SlowQueryLog();   // фоновый поток живёт до конца процесса
+    return *log;
+}
+
+void SlowQueryLog::configure(uint64_t thresholdMicros, const std::string& explainConnection) {
+    std::lock_guard<std::mutex> lock(mutex);
+    threshold.store(thresholdMicros == 0 ? UINT64_MAX : thresholdMicros, std::memory_order_relaxed);
+    if (!explainConnection.empty() && !explainThread.joinable()) {
+        explainConnectionString = explainConnection;
+        stopping = false;
+        explainThread = std::thread(&SlowQueryLog::explainLoop, this);
+    }
+}
+
+void SlowQueryLog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        explainQueue.clear();
+    }
+    explainWake.notify_all();
+    if (explainThread.joinable()) {
+        explainThread.join();
+    }
+}
+
+void SlowQueryLog::record(const std::string& key, const std::string& sql, int paramCount,
+                          const char* const* paramValues, uint64_t micros, long long rows) {
+    std::string params = redactParams(paramCount, paramValues);
+    LOG_WARN("Медленный запрос")
+        .field("query", key)
+        .field("params", params)
+        .field("duration_us", micros)
+        .field("rows", rows);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    SlowQueryEntry& entry = entries[key];
+    entry.key = key;
+    entry.count++;
+    entry.totalMicros += micros;
+    if (micros <= entry.maxMicros) {
+        return;
+    }
+    entry.maxMicros = micros;
+    entry.maxParams = params;
+    entry.maxRows = rows;
+    entry.maxTime = utcNow();
+    entry.plan.clear();
+    entry.planCommand.clear();
+    sampleByKey.erase(key);
+
+    // План снимается только для нового максимума по ключу, поэтому повторный
+    // прогон запроса случается редко; очередь ограничена
+    if (!explainThread.joinable() || stopping || explainQueue.size() >= EXPLAIN_QUEUE_LIMIT) {
+        return;
+    }
+    uint64_t sample = ++nextSample;
+    sampleByKey[key] = sample;
+    ExplainJob job{sample, key, sql, {}};
+    for (int i = 0; i < paramCount; i++) {
+        job.params.push_back(paramValues[i] ? paramValues[i] : "");
+    }
+    explainQueue.push_back(std::move(job));
+    explainWake.notify_one();
+}
+
+std::vector<SlowQueryEntry> SlowQueryLog::top(size_t limit) const {
+    std::vector<SlowQueryEntry> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const auto& entry : entries) {
+            result.push_back(entry.second);
+        }
+    }
+    std::sort(result.begin(), result.end(), [](const SlowQueryEntry& a, const SlowQueryEntry& b) {
+        return a.maxMicros > b.maxMicros;
+    });
+    if (result.size() > limit) {
+        result.resize(limit);
+    }
+    return result;
+}
+
+void SlowQueryLog::explainLoop() {
+    PGconn* conn = nullptr;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        explainWake.wait(lock, [this] { return stopping || !explainQueue.empty(); });
+        if (stopping) break;
+        ExplainJob job = std::move(explainQueue.front());
+        explainQueue.pop_front();
+        lock.unlock();
+
+        if (conn == nullptr || PQstatus(conn) != CONNECTION_OK) {
+            if (conn) PQfinish(conn);
+            conn = PQconnectdb(explainConnectionString.c_str());
+            if (PQstatus(conn) != CONNECTION_OK) {
+                LOG_ERROR("Нет соединения для EXPLAIN").field("error", PQerrorMessage(conn));
+            } else {
+                PQclear(PQexec(conn, "SET statement_timeout = '10s'"));
+            }
+        }
+
+        std::string plan;
+        // ANALYZE выполняет запрос заново - только для SELECT; изменяющие
+        // запросы не выполняются, план без фактического времени
+        bool analyze = isReadOnlyQuery(job.sql);
+        const char* command = analyze ? "EXPLAIN (ANALYZE, BUFFERS)" : "EXPLAIN";
+        if (PQstatus(conn) == CONNECTION_OK) {
+            std::vector<const char*> values;
+            for (const auto& param : job.params) values.push_back(param.c_str());
+            std::string explainSql = std::string(command) + " " + job.sql;
+
+            PQclear(PQexec(conn, "BEGIN"));
+            PGresult* res = PQexecParams(conn, explainSql.c_str(), static_cast<int>(values.size()), nullptr,
+                                         values.empty() ? nullptr : values.data(), nullptr, nullptr, 0);
+            if (PQresultStatus(res) == PGRES_TUPLES_OK) {
+                for (int i = 0; i < PQntuples(res); i++) {
+                    plan += PQgetvalue(res, i, 0);
+                    plan += '\n';
+                }
+            } else {
+                LOG_ERROR("Ошибка EXPLAIN").field("query", job.key).field("error", PQerrorMessage(conn));
+            }
+            PQclear(res);
+            PQclear(PQexec(conn, "ROLLBACK"));
+        }
+
+        lock.lock();
+        auto sample = sampleByKey.find(job.key);
+        if (!plan.empty() && sample != sampleByKey.end() && sample->second == job.sample) {
+            entries[job.key].plan = plan;
+            entries[job.key].planCommand = command;
+        }
+    }
+    lock.unlock();
+    if (conn) PQfinish(conn);
+}
@@ -0,0 +1,243 @@
+#include "text_kernels.h"
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define TEXT_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+typedef size_t (*FindFn)(const char* data, size_t size, const ByteSet& set);
+
+size_t findScalar(const char* data, size_t size, const ByteSet& set) {
+    for (size_t i = 0; i < size; i++) {
+        if (set.contains(data[i])) return i;
+    }
+    return size;
+}
+
+#ifdef TEXT_KERNELS_X86
+
+// Маска байтов блока, входящих в набор
+__attribute__((target("sse4.2")))
+inline int classify16(__m128i block, __m128i low, __m128i high) {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    __m128i lo = _mm_shuffle_epi8(low, _mm_and_si128(block, nibble));
+    __m128i hi = _mm_shuffle_epi8(high, _mm_and_si128(_mm_srli_epi16(block, 4), nibble));
+    __m128i misses = _mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128());
+    return _mm_movemask_epi8(misses) ^ 0xFFFF;
+}
+
+__attribute__((target("sse4.2")))
+size_t findSSE42(const char* data, size_t size, const ByteSet& set) {
+    const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.low));
+    const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.high));
+
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        int mask = classify16(block, low, high);
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    return i + findScalar(data + i, size - i, set);
+}
+
+__attribute__((target("avx2")))
+size_t findAVX2(const char* data, size_t size, const ByteSet& set) {
+    const __m128i low128 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.low));
+    const __m128i high128 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(set.high));
+    const __m256i low = _mm256_broadcastsi128_si256(low128);
+    const __m256i high = _mm256_broadcastsi128_si256(high128);
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i lo = _mm256_shuffle_epi8(low, _mm256_and_si256(block, nibble));
+        __m256i hi = _mm256_shuffle_epi8(high, _mm256_and_si256(_mm256_srli_epi16(block, 4), nibble));
+        __m256i misses = _mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), _mm256_setzero_si256());
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(misses));
+        if (mask != 0) return i + __builtin_ctz(mask);
+    }
+    if (i + 16 <= size) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        int mask = classify16(block, low128, high128);
+        if (mask != 0) return i + __builtin_ctz(mask);
+        i += 16;
+    }
+    return i + findScalar(data + i, size - i, set);
+}
+
+#endif
+
+bool levelSupported(TextKernelLevel level) {
+#ifdef TEXT_KERNELS_X86
+    __builtin_cpu_init();
+    switch (level) {
+        case TextKernelLevel::Scalar: return true;
+        case TextKernelLevel::SSE42: return __builtin_cpu_supports("sse4.2");
+        case TextKernelLevel::AVX2: return __builtin_cpu_supports("avx2");
+    }
+    return false;
+#else
+    return level == TextKernelLevel::Scalar;
+#endif
+}
+
+FindFn findFor(TextKernelLevel level) {
+#ifdef TEXT_KERNELS_X86
+    if (level == TextKernelLevel::AVX2) return findAVX2;
+    if (level == TextKernelLevel::SSE42) return findSSE42;
+#endif
+    return findScalar;
+}
+
+TextKernelLevel detectLevel() {
+    TextKernelLevel best = TextKernelLevel::Scalar;
+    if (levelSupported(TextKernelLevel::AVX2)) {
+        best = TextKernelLevel::AVX2;
+    } else if (levelSupported(TextKernelLevel::SSE42)) {
+        best = TextKernelLevel::SSE42;
+    }
+
+    const char* env = std::getenv("TEXT_KERNELS");
+    if (env != nullptr && *env != '\0') {
+        std::string requested(env);
+        TextKernelLevel limit = best;
+        if (requested == "scalar") {
+            limit = TextKernelLevel::Scalar;
+        } else if (requested == "sse42") {
+            limit = TextKernelLevel::SSE42;
+        } else if (requested == "avx2") {
+            limit = TextKernelLevel::AVX2;
+        } else {
+            std::cerr << "Неизвестное значение TEXT_KERNELS: " << requested << std::endl;
+        }
+        if (limit < best) best = limit;
+    }
+    return best;
+}
+
+TextKernelLevel currentLevel = detectLevel();
+FindFn currentFind = findFor(currentLevel);
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+const ByteSet URL_SPECIAL("%+");
+const ByteSet HTML_SPECIAL("&<>\"'");
+const ByteSet JS_SPECIAL("\\\"\n\r");
+
+// Общий цикл: обычные участки копируются целиком, идущие подряд специальные
+// байты обрабатываются через handle без повторного векторного поиска.
+// handle возвращает число обработанных байтов, начиная со специального.
+template <typename String, typename Handler>
+void appendTransformed(String& out, const char* data, size_t size, const ByteSet& set, Handler handle) {
+    size_t i = 0;
+    while (i < size) {
+        if (set.contains(data[i])) {
+            i += handle(data + i, size - i);
+            continue;
+        }
+        size_t next = i + currentFind(data + i, size - i, set);
+        out.append(data + i, next - i);
+        i = next;
+    }
+}
+
+template <typename String>
+void appendUrlDecodedTo(String& out, const char* data, size_t size) {
+    appendTransformed(out, data, size, URL_SPECIAL, [&out](const char* p, size_t remaining) -> size_t {
+        if (*p == '+') {
+            out += ' ';
+            return 1;
+        }
+        int high = remaining > 2 ? hexValue(p[1]) : -1;
+        int low = high >= 0 ? hexValue(p[2]) : -1;
+        if (low < 0) {
+            out += '%';
+            return 1;
+        }
+        out += static_cast<char>((high << 4) | low);
+        return 3;
+    });
+}
+
+} // namespace
+
+ByteSet::ByteSet(const char* chars) : low(), high(), table() {
+    for (int bit = 0; bit < 8 && chars[bit] != '\0'; bit++) {
+        unsigned char c = static_cast<unsigned char>(chars[bit]);
+        low[c & 0x0F] |= 1 << bit;
+        high[c >> 4] |= 1 << bit;
+        table[c] = true;
+    }
+}
+
+TextKernelLevel textKernelLevel() {
+    return currentLevel;
+}
+
+const char* textKernelName(TextKernelLevel level) {
+    switch (level) {
+        case TextKernelLevel::Scalar: return "scalar";
+        case TextKernelLevel::SSE42: return "sse42";
+        case TextKernelLevel::AVX2: return "avx2";
+    }
+    return "unknown";
+}
+
+bool setTextKernelLevel(TextKernelLevel level) {
+    if (!levelSupported(level)) return false;
+    currentLevel = level;
+    currentFind = findFor(level);
+    return true;
+}
+
+size_t findFirstOf(const char* data, size_t size, const ByteSet& set) {
+    return currentFind(data, size, set);
+}
+
+void appendUrlDecoded(std::string& out, const char* data, size_t size) {
+    appendUrlDecodedTo(out, data, size);
+}
+
+void appendUrlDecoded(std::pmr::string& out, const char* data, size_t size) {
+    appendUrlDecodedTo(out, data, size);
+}
+
+void appendHtmlEscaped(std::string& out, const char* data, size_t size) {
+    appendTransformed(out, data, size, HTML_SPECIAL, [&out](const char* p, size_t) -> size_t {
+        switch (*p) {
+            case '&': out += "&amp;"; break;
+            case '<': out += "&lt;"; break;
+            case '>': out += "&gt;"; break;
+            case '"': out += "&quot;"; break;
+            default: out += "&#39;"; break;
+        }
+        return 1;
+    });
+}
+
+void appendJsEscaped(std::string& out, const char* data, size_t size) {
+    appendTransformed(out, data, size, JS_SPECIAL, [&out](const char* p, size_t) -> size_t {
+        switch (*p) {
+            case '\\': out += "\\\\"; break;
+            case '"': out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default: break;   // \r удаляется
+        }
+        return 1;
+    });
+}
+
+bool needsJsEscape(const char* data, size_t size) {
+    return currentFind(data, size, JS_SPECIAL) < size;
+}
@@ -0,0 +1,197 @@
+#include "tracing.h"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+struct SpanRecord {
+    const char* name;
+    std::string detail;
+    uint64_t startMicros;
+    uint64_t durationMicros;
+};
+
+struct ThreadTrace {
+    uint64_t traceId = 0;
+    bool sampled = false;
+    uint64_t startMicros = 0;
+    std::vector<SpanRecord> spans;
+    std::string buffer;
+    uint64_t random = 0;
+    int threadNumber = 0;
+};
+
+std::atomic<bool> enabled{false};
+std::atomic<uint64_t> sampleThreshold{0};   // сэмплируем, если случайное число < порога
+std::atomic<int> nextThreadNumber{1};
+std::mutex fileMutex;
+int traceFd = -1;
+
+thread_local ThreadTrace current;
+
+uint64_t nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// xorshift64*: достаточно для сэмплирования и уникальности trace id
+uint64_t nextRandom() {
+    if (current.random == 0) {
+        std::random_device device;
+        current.random = (static_cast<uint64_t>(device()) << 32) ^ device() ^ nowMicros();
+        if (current.random == 0) current.random = 0x9e3779b97f4a7c15ULL;
+        current.threadNumber = nextThreadNumber.fetch_add(1);
+    }
+    current.random ^= current.random >> 12;
+    current.random ^= current.random << 25;
+    current.random ^= current.random >> 27;
+    return current.random * 0x2545f4914f6cdd1dULL;
+}
+
+void appendJsonString(std::string& out, const char* data, size_t size) {
+    out += '"';
+    for (size_t i = 0; i < size; i++) {
+        char c = data[i];
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+void appendEvent(std::string& out, const char* name, const std::string& detail, uint64_t start,
+                 uint64_t duration, const std::string& traceId) {
+    char numbers[96];
+    out += "{\"name\":";
+    appendJsonString(out, name, strlen(name));
+    snprintf(numbers, sizeof(numbers), ",\"ph\":\"X\",\"ts\":%llu,\"dur\":%llu,\"pid\":%d,\"tid\":%d",
+             static_cast<unsigned long long>(start), static_cast<unsigned long long>(duration),
+             static_cast<int>(getpid()), current.threadNumber);
+    out += numbers;
+    out += ",\"args\":{\"trace_id\":\"";
+    out += traceId;
+    out += '"';
+    if (!detail.empty()) {
+        out += ",\"detail\":";
+        appendJsonString(out, detail.data(), detail.size());
+    }
+    out += "}},\n";
+}
+
+void writeAll(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return;
+        }
+        written += n;
+    }
+}
+
+} // namespace
+
+bool startTracing(double sampleRate, const std::string& path) {
+    if (path.empty() || sampleRate <= 0) {
+        return true;
+    }
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        std::cerr << "Ошибка открытия файла трассировки: " << path << std::endl;
+        return false;
+    }
+    // JSON Array Format: закрывающая скобка и запятая после последнего события необязательны
+    if (lseek(fd, 0, SEEK_END) == 0) {
+        writeAll(fd, "[\n");
+    }
+    traceFd = fd;
+    sampleThreshold.store(sampleRate >= 1 ? UINT64_MAX : static_cast<uint64_t>(sampleRate * 18446744073709551615.0));
+    enabled.store(true);
+    return true;
+}
+
+void stopTracing() {
+    std::lock_guard<std::mutex> lock(fileMutex);
+    enabled.store(false);
+    if (traceFd >= 0) {
+        close(traceFd);
+        traceFd = -1;
+    }
+}
+
+uint64_t beginTrace() {
+    current.traceId = nextRandom();
+    current.sampled = enabled.load(std::memory_order_relaxed) &&
+                      nextRandom() < sampleThreshold.load(std::memory_order_relaxed);
+    current.spans.clear();
+    current.startMicros = current.sampled ? nowMicros() : 0;
+    return current.traceId;
+}
+
+void endTrace(const char* route) {
+    if (!current.sampled) {
+        return;
+    }
+    current.sampled = false;
+    uint64_t end = nowMicros();
+    std::string traceId = formatTraceId(current.traceId);
+
+    std::string& out = current.buffer;
+    out.clear();
+    appendEvent(out, route, std::string(), current.startMicros, end - current.startMicros, traceId);
+    for (const SpanRecord& span : current.spans) {
+        appendEvent(out, span.name, span.detail, span.startMicros, span.durationMicros, traceId);
+    }
+    current.spans.clear();
+
+    std::lock_guard<std::mutex> lock(fileMutex);
+    if (traceFd >= 0) {
+        writeAll(traceFd, out);
+    }
+}
+
+uint64_t currentTraceId() {
+    return current.traceId;
+}
+
+std::string formatTraceId(uint64_t traceId) {
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%016llx", static_cast<unsigned long long>(traceId));
+    return buffer;
+}
+
+TraceSpan::TraceSpan(const char* name, std::string_view detail) : index(0), active(current.sampled) {
+    if (!active) return;
+    index = current.spans.size();
+    current.spans.push_back({name, std::string(detail), nowMicros(), 0});
+}
+
+TraceSpan::~TraceSpan() {
+    end();
+}
+
+void TraceSpan::end() {
+    if (!active) return;
+    active = false;
+    if (index < current.spans.size()) {
+        SpanRecord& span = current.spans[index];
+        span.durationMicros = nowMicros() - span.startMicros;
+    }
+}
@@ -0,0 +1,122 @@
+#include "utf8.h"
+
+uint32_t utf8Decode(const char*& p, const char* end) {
+    const unsigned char c = static_cast<unsigned char>(*p++);
+    if (c < 0x80) {
+        return c;
+    }
+
+    int extra;
+    uint32_t codePoint;
+    if ((c & 0xE0) == 0xC0) {
+        extra = 1;
+        codePoint = c & 0x1F;
+    } else if ((c & 0xF0) == 0xE0) {
+        extra = 2;
+        codePoint = c & 0x0F;
+    } else if ((c & 0xF8) == 0xF0) {
+        extra = 3;
+        codePoint = c & 0x07;
+    } else {
+        return 0xFFFD;
+    }
+
+    for (int i = 0; i < extra; i++) {
+        if (p >= end || (static_cast<unsigned char>(*p) & 0xC0) != 0x80) {
+            return 0xFFFD;
+        }
+        codePoint = (codePoint << 6) | (static_cast<unsigned char>(*p++) & 0x3F);
+    }
+    return codePoint;
+}
+
+void utf8Append(std::string& out, uint32_t codePoint) {
+    if (codePoint < 0x80) {
+        out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codePoint >> 6));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else if (codePoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codePoint >> 12));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codePoint >> 18));
+        out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+}
+
+uint32_t foldCodePoint(uint32_t cp) {
+    // ASCII
+    if (cp < 0x80) {
+        return (cp >= 'A' && cp <= 'Z') ? cp + 32 : cp;
+    }
+    // Latin-1: À..Þ (кроме знака умножения)
+    if (cp >= 0x00C0 && cp <= 0x00DE && cp != 0x00D7) {
+        return cp + 32;
+    }
+    // Latin Extended-A: пары "прописная/строчная"
+    if ((cp >= 0x0100 && cp <= 0x0137) || (cp >= 0x014A && cp <= 0x0177)) {
+        return cp | 1;
+    }
+    if ((cp >= 0x0139 && cp <= 0x0148) || (cp >= 0x0179 && cp <= 0x017E)) {
+        return (cp & 1) ? cp + 1 : cp;
+    }
+    if (cp == 0x0178) {
+        return 0x00FF;
+    }
+    // Кириллица: Ѐ..Џ, А..Я
+    if (cp >= 0x0400 && cp <= 0x040F) {
+        return cp + 0x50;
+    }
+    if (cp >= 0x0410 && cp <= 0x042F) {
+        return cp + 0x20;
+    }
+    // Расширенная кириллица (Ѡ, Ґ, Ӂ, Ӑ и т.д.)
+    if ((cp >= 0x0460 && cp <= 0x0481) || (cp >= 0x048A && cp <= 0x04BF) || (cp >= 0x04D0 && cp <= 0x052F)) {
+        return cp | 1;
+    }
+    if (cp >= 0x04C1 && cp <= 0x04CE) {
+        return (cp & 1) ? cp + 1 : cp;
+    }
+    if (cp == 0x04C0) {
+        return 0x04CF;
+    }
+    return cp;
+}
+
+std::string utf8ToLower(const std::string& str) {
+    std::string result;
+    result.reserve(str.size());
+    const char* p = str.data();
+    const char* end = p + str.size();
+    while (p < end) {
+        // Быстрый путь для ASCII
+        unsigned char c = static_cast<unsigned char>(*p);
+        if (c < 0x80) {
+            result += (c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32) : static_cast<char>(c);
+            p++;
+            continue;
+        }
+        utf8Append(result, foldCodePoint(utf8Decode(p, end)));
+    }
+    return result;
+}
+
+uint32_t foldForSearch(uint32_t codePoint) {
+    uint32_t folded = foldCodePoint(codePoint);
+    return folded == 0x0451 ? 0x0435 : folded;
+}
+
+std::string utf8FoldForSearch(const std::string& str) {
+    std::string result;
+    result.reserve(str.size());
+    const char* p = str.data();
+    const char* end = p + str.size();
+    while (p < end) {
+        utf8Append(result, foldForSearch(utf8Decode(p, end)));
+    }
+    return result;
+}